@@ -0,0 +1,55 @@
+#include <benchmark/benchmark.h>
+#include <sodium.h>
+#include <memory>
+#include <vector>
+#include "CryptoModule.h"
+#include "SecureArena.h"
+
+namespace {
+
+// 每个秘密单独 sodium_malloc：mmap + mprotect 保护页 + mlock，释放时再逐一撤销
+void BM_SecretSodiumMalloc(benchmark::State& state)
+{
+    const size_t size = static_cast<size_t>(state.range(0));
+    for (auto _ : state) {
+        void* secret = sodium_malloc(size);
+        benchmark::DoNotOptimize(secret);
+        sodium_free(secret);
+    }
+}
+BENCHMARK(BM_SecretSodiumMalloc)->ArgName("bytes")->Arg(32)->Arg(256);
+
+// 从预先锁定的 chunk 中取槽位，释放时清零放回空闲链表
+void BM_SecretArenaSlot(benchmark::State& state)
+{
+    SecureArena arena;
+    const size_t size = static_cast<size_t>(state.range(0));
+    for (auto _ : state) {
+        size_t capacity = 0;
+        uint8_t* secret = arena.Acquire(size, capacity);
+        benchmark::DoNotOptimize(secret);
+        arena.Release(secret, capacity);
+    }
+    state.counters["chunks"] = static_cast<double>(arena.GetStats().chunkAllocations);
+}
+BENCHMARK(BM_SecretArenaSlot)->ArgName("bytes")->Arg(32)->Arg(256);
+
+// 同时持有 range(0) 个数据密钥（例如打开多个密码本），统计实际申请的锁定内存
+void BM_SecureKeyWorkingSet(benchmark::State& state)
+{
+    const size_t keys = static_cast<size_t>(state.range(0));
+    const SecureArena::Stats before = SecureArena::Global().GetStats();
+    for (auto _ : state) {
+        std::vector<std::unique_ptr<SecureKey>> live;
+        for (size_t i = 0; i < keys; ++i) {
+            live.emplace_back(new SecureKey());
+        }
+        benchmark::DoNotOptimize(live.data());
+    }
+    const SecureArena::Stats after = SecureArena::Global().GetStats();
+    state.counters["sodium_malloc"] = static_cast<double>(after.chunkAllocations - before.chunkAllocations);
+    state.counters["live"] = static_cast<double>(after.liveSlots);
+}
+BENCHMARK(BM_SecureKeyWorkingSet)->ArgName("keys")->Arg(16)->Arg(1024);
+
+} // namespace
@@ -0,0 +1,90 @@
+#include <benchmark/benchmark.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "BenchSupport.h"
+#include "BreachStore.h"
+#include "PasswordAudit.h"
+
+namespace {
+
+// 用密钥环自己的数据密钥加密 range(0) 条条目，每十条中有一条与前一条密码相同
+struct AuditFixture {
+    explicit AuditFixture(int count)
+        : vault("audit-" + std::to_string(count)),
+          keyring(std::make_shared<SessionKeyring>(CryptoModule().generateDataKey(), "Bench-Password-123"))
+    {
+        CryptoModule crypto;
+        auto key = keyring->GetCodebookKey(vault.Vault(), vault.CodebookId());
+        std::vector<PasswordVault::PasswordEntry> batch;
+        for (int i = 0; i < count; ++i) {
+            const std::string password = "Bench-" + std::to_string(i % 10 == 9 ? i - 1 : i);
+            PasswordVault::PasswordEntry entry;
+            entry.address = "site" + std::to_string(i) + ".example.com";
+            entry.encrypted_password = crypto.encrypt(*key, std::vector<uint8_t>(password.begin(), password.end()));
+            batch.push_back(std::move(entry));
+            if (batch.size() == 1000 || i + 1 == count) {
+                vault.Vault().AddEntries(vault.CodebookId(), batch);
+                batch.clear();
+            }
+        }
+    }
+
+    BenchVault vault;
+    std::shared_ptr<SessionKeyring> keyring;
+};
+
+// 首次审计：每个条目都要解密并写入缓存
+void BM_AuditReuseCold(benchmark::State& state)
+{
+    AuditFixture fixture(static_cast<int>(state.range(0)));
+    PasswordAuditor auditor(fixture.vault.Vault(), fixture.keyring);
+    for (auto _ : state) {
+        state.PauseTiming();
+        sqlite3_exec(fixture.vault.Database(), "DELETE FROM AuditCache", nullptr, nullptr, nullptr);
+        state.ResumeTiming();
+        benchmark::DoNotOptimize(auditor.AuditReuse("bench"));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_AuditReuseCold)->Arg(10000)->Unit(benchmark::kMillisecond);
+
+// 无改动时再次审计：只比对密文摘要，不解密
+void BM_AuditReuseCached(benchmark::State& state)
+{
+    AuditFixture fixture(static_cast<int>(state.range(0)));
+    PasswordAuditor auditor(fixture.vault.Vault(), fixture.keyring);
+    auditor.AuditReuse("bench");
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(auditor.AuditReuse("bench"));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_AuditReuseCached)->Arg(10000)->Unit(benchmark::kMillisecond);
+
+// range(0) 个摘要的泄露库中查询，一半命中
+void BM_BreachLookup(benchmark::State& state)
+{
+    std::vector<BreachStore::Digest> digests;
+    for (int i = 0; i < state.range(0); ++i) {
+        digests.push_back(BreachStore::Hash("breached" + std::to_string(i)));
+    }
+    const std::string path = BenchDirectory() + "/passbench-breach.breach";
+    BreachStoreWriter::Write(digests, path);
+    auto store = BreachStore::Open(path);
+
+    std::vector<BreachStore::Digest> queries;
+    for (int i = 0; i < 1024; ++i) {
+        queries.push_back(BreachStore::Hash((i % 2 ? "breached" : "unknown") + std::to_string(i * 977)));
+    }
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(store->Contains(queries[i++ % queries.size()]));
+    }
+    state.SetItemsProcessed(state.iterations());
+    store.reset();
+    std::remove(path.c_str());
+}
+BENCHMARK(BM_BreachLookup)->Arg(100000)->Arg(1000000);
+
+} // namespace
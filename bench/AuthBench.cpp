@@ -0,0 +1,55 @@
+#include <benchmark/benchmark.h>
+#include "BenchSupport.h"
+#include "PassWordGen.h"
+
+namespace {
+
+// 登录校验：crypto_pwhash_str_verify 按注册时的 SENSITIVE 参数运行
+void BM_LoginVerify(benchmark::State& state)
+{
+    static BenchVault fixture("login");
+    static const bool registered = fixture.Auth().Register("loginuser", "LoginPass123");
+    if (!registered) {
+        state.SkipWithError("Register failed");
+        return;
+    }
+
+    const bool correct = state.range(0) != 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(fixture.Auth().Login("loginuser", correct ? "LoginPass123" : "WrongPass123"));
+    }
+}
+BENCHMARK(BM_LoginVerify)->ArgName("correct")->Arg(1)->Arg(0)->Unit(benchmark::kMillisecond)->Iterations(2);
+
+void BM_GenerateBasic(benchmark::State& state)
+{
+    PasswordGenerator generator(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(generator.generateBasic());
+    }
+}
+BENCHMARK(BM_GenerateBasic)->Arg(8)->Arg(16)->Arg(32);
+
+void BM_GenerateExtended(benchmark::State& state)
+{
+    PasswordGenerator generator(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(generator.generateExtended());
+    }
+}
+BENCHMARK(BM_GenerateExtended)->Arg(8)->Arg(16)->Arg(32);
+
+// 批量轮换凭据：一次生成 range(0) 个 16 位强密码
+void BM_GenerateBatch(benchmark::State& state)
+{
+    static constexpr Charset charset(kStrongPolicy);
+    PasswordGenerator generator(16);
+    const size_t count = static_cast<size_t>(state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(generator.generateBatch(count, charset));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_GenerateBatch)->Arg(1)->Arg(100)->Arg(10000);
+
+} // namespace
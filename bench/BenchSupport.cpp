@@ -0,0 +1,110 @@
+#include "BenchSupport.h"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <new>
+#include <stdexcept>
+
+namespace {
+std::atomic<uint64_t> heapAllocations(0);
+}
+
+// 计数的全局 operator new：数组与 nothrow 版本默认都转调这两个函数
+void* operator new(std::size_t size)
+{
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+// C++14 的带大小释放版本默认转调上面的 operator delete，但只替换不带大小的版本会触发 -Wsized-deallocation
+void operator delete(void* p, std::size_t) noexcept
+{
+    operator delete(p);
+}
+
+uint64_t HeapAllocations()
+{
+    return heapAllocations.load(std::memory_order_relaxed);
+}
+
+std::string BenchDirectory()
+{
+    for (const char* name : {"PASSBENCH_DIR", "TMPDIR", "TEMP"}) {
+        const char* dir = std::getenv(name);
+        if (dir && *dir) {
+            return dir;
+        }
+    }
+    return "/tmp";
+}
+
+BenchVault::BenchVault(const std::string& tag, const ConnectionProfile& profile)
+    : path_(BenchDirectory() + "/passbench-" + tag + ".db")
+{
+    for (const char* suffix : {"", "-wal", "-shm", "-journal"}) {
+        std::remove((path_ + suffix).c_str());
+    }
+
+    auth_.reset(new UserAuth(path_, profile));
+    // 直接写入用户行：Register 使用 SENSITIVE 级 Argon2，不适合在每个夹具中运行
+    sqlite3_exec(Database(), "INSERT INTO User (username, password_hash) VALUES ('bench', 'x')",
+                 nullptr, nullptr, nullptr);
+
+    vault_.reset(new PasswordVault(Database()));
+    codebookId_ = vault_->CreateCodebook("bench", "bench").id;
+    if (codebookId_ < 0) {
+        throw std::runtime_error("Failed to create benchmark codebook");
+    }
+
+    CryptoModule crypto;
+    key_ = crypto.generateDataKey();
+    const std::string password = "Bench-Password-123";
+    blob_ = crypto.encrypt(*key_, std::vector<uint8_t>(password.begin(), password.end()));
+}
+
+BenchVault::~BenchVault()
+{
+    vault_.reset();
+    auth_.reset();
+    for (const char* suffix : {"", "-wal", "-shm", "-journal"}) {
+        std::remove((path_ + suffix).c_str());
+    }
+}
+
+void BenchVault::Fill(int count)
+{
+    std::vector<PasswordVault::PasswordEntry> batch;
+    for (int i = 0; i < count; ++i) {
+        PasswordVault::PasswordEntry entry;
+        entry.address = "site" + std::to_string(entries_ + i) + ".example.com";
+        entry.encrypted_password = blob_;
+        entry.notes = i % 4 == 0 ? "user" + std::to_string(i) : "";
+        batch.push_back(std::move(entry));
+
+        if (batch.size() == 1000 || i + 1 == count) {
+            vault_->AddEntries(codebookId_, batch);
+            batch.clear();
+        }
+    }
+    entries_ += count;
+}
+
+BenchVault& SharedVault(int entries)
+{
+    static std::map<int, std::unique_ptr<BenchVault>> vaults;
+    auto& vault = vaults[entries];
+    if (!vault) {
+        vault.reset(new BenchVault("shared-" + std::to_string(entries)));
+        vault->Fill(entries);
+    }
+    return *vault;
+}
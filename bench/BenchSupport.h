@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "UserAuth.h"
+#include "PassWordVault.h"
+#include "CryptoModule.h"
+#include "ConnectionProfile.h"
+
+// 基准测试数据库所在目录：PASSBENCH_DIR 环境变量，未设置时使用系统临时目录。
+// 将 PASSBENCH_DIR 指向网络盘即可测量网络盘上的表现
+std::string BenchDirectory();
+
+// 进程启动以来经 operator new 分配的次数（passbench 替换了全局 operator new）；
+// sodium_malloc 等不经过 operator new 的分配不计入
+uint64_t HeapAllocations();
+
+// 一个临时的磁盘数据库：包含用户 bench、一个密码本及其数据密钥，析构时删除数据库文件
+class BenchVault {
+public:
+    explicit BenchVault(const std::string& tag,
+                        const ConnectionProfile& profile = ConnectionProfile::Default());
+    ~BenchVault();
+    BenchVault(const BenchVault&) = delete;
+    BenchVault& operator=(const BenchVault&) = delete;
+
+    UserAuth& Auth() { return *auth_; }
+    PasswordVault& Vault() { return *vault_; }
+    sqlite3* Database() const { return auth_->GetDatabaseHandle(); }
+    int CodebookId() const { return codebookId_; }
+    const SecureKey& Key() const { return *key_; }
+
+    // 批量插入 count 条条目，地址为 site<n>.example.com
+    void Fill(int count);
+    int EntryCount() const { return entries_; }
+    const std::vector<uint8_t>& SampleBlob() const { return blob_; }
+
+private:
+    std::string path_;
+    std::unique_ptr<UserAuth> auth_;
+    std::unique_ptr<PasswordVault> vault_;
+    std::shared_ptr<SecureKey> key_;
+    std::vector<uint8_t> blob_;
+    int codebookId_ = -1;
+    int entries_ = 0;
+};
+
+// 按条目数缓存已填充的数据库，避免每次基准运行都重新插入
+BenchVault& SharedVault(int entries);
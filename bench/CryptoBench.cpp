@@ -0,0 +1,241 @@
+#include <benchmark/benchmark.h>
+#include "BenchSupport.h"
+#include "CryptoModule.h"
+#include "KdfProfile.h"
+#include <string>
+#include <vector>
+
+namespace {
+
+std::vector<uint8_t> Plaintext(size_t size)
+{
+    return std::vector<uint8_t>(size, 'p');
+}
+
+// 每次迭代平均的堆分配次数
+void CountAllocations(benchmark::State& state, uint64_t before)
+{
+    state.counters["allocs"] = benchmark::Counter(static_cast<double>(HeapAllocations() - before),
+                                                  benchmark::Counter::kAvgIterations);
+}
+
+// 数据密钥路径：一次 XChaCha20-Poly1305，记录头作为附加数据
+void BM_EncryptDataKey(benchmark::State& state)
+{
+    CryptoModule crypto;
+    auto key = crypto.generateDataKey();
+    const auto plaintext = Plaintext(static_cast<size_t>(state.range(0)));
+    const uint64_t allocations = HeapAllocations();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(crypto.encrypt(*key, plaintext));
+    }
+    CountAllocations(state, allocations);
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_EncryptDataKey)->Arg(16)->Arg(64)->Arg(256);
+
+void BM_DecryptDataKey(benchmark::State& state)
+{
+    CryptoModule crypto;
+    auto key = crypto.generateDataKey();
+    const auto packed = crypto.encrypt(*key, Plaintext(static_cast<size_t>(state.range(0))));
+    const uint64_t allocations = HeapAllocations();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(crypto.decrypt(*key, packed));
+    }
+    CountAllocations(state, allocations);
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_DecryptDataKey)->Arg(16)->Arg(64)->Arg(256);
+
+// 指针接口：读写调用方的缓冲区，稳定状态下不分配
+void BM_EncryptDataKeyInPlace(benchmark::State& state)
+{
+    CryptoModule crypto;
+    auto key = crypto.generateDataKey();
+    const auto plaintext = Plaintext(static_cast<size_t>(state.range(0)));
+    std::vector<uint8_t> packed(CryptoModule::sealedSize(plaintext.size()));
+    const uint64_t allocations = HeapAllocations();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(crypto.encrypt(*key, plaintext.data(), plaintext.size(), packed.data(), packed.size()));
+    }
+    CountAllocations(state, allocations);
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_EncryptDataKeyInPlace)->Arg(16)->Arg(64)->Arg(256);
+
+void BM_DecryptDataKeyInPlace(benchmark::State& state)
+{
+    CryptoModule crypto;
+    auto key = crypto.generateDataKey();
+    const auto packed = crypto.encrypt(*key, Plaintext(static_cast<size_t>(state.range(0))));
+    SecureBuffer plaintext(CryptoModule::openedSize(packed.size()));
+    const uint64_t allocations = HeapAllocations();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(crypto.decrypt(*key, packed.data(), packed.size(), plaintext));
+    }
+    CountAllocations(state, allocations);
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_DecryptDataKeyInPlace)->Arg(16)->Arg(64)->Arg(256);
+
+// 只解析记录头，不解密：筛选需要转换的条目时每行一次
+void BM_ParseRecord(benchmark::State& state)
+{
+    CryptoModule crypto;
+    auto key = crypto.generateDataKey();
+    const auto packed = crypto.encrypt(*key, Plaintext(64));
+    EntryRecord::View view;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(EntryRecord::Parse(packed.data(), packed.size(), view));
+        benchmark::DoNotOptimize(view.keyId);
+    }
+}
+BENCHMARK(BM_ParseRecord);
+
+// 密钥轮换期间先用新密钥尝试：key_id 不符时不做认证计算
+void BM_DecryptWrongKey(benchmark::State& state)
+{
+    CryptoModule crypto;
+    auto key = crypto.generateDataKey();
+    auto otherKey = crypto.generateDataKey();
+    const auto packed = crypto.encrypt(*otherKey, Plaintext(64));
+    SecureBuffer plaintext(CryptoModule::openedSize(packed.size()));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(crypto.decrypt(*key, packed.data(), packed.size(), plaintext));
+    }
+}
+BENCHMARK(BM_DecryptWrongKey);
+
+// 整条条目（地址、备注、密码）作为一条记录封装与打开，字段指向锁定内存中的明文
+void BM_SealEntry(benchmark::State& state)
+{
+    CryptoModule crypto;
+    auto key = crypto.generateDataKey();
+    const auto password = Plaintext(16);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(crypto.sealEntry(*key, "accounts.example.com", "work account",
+                                                  password.data(), password.size()));
+    }
+}
+BENCHMARK(BM_SealEntry);
+
+void BM_OpenEntry(benchmark::State& state)
+{
+    CryptoModule crypto;
+    auto key = crypto.generateDataKey();
+    const auto password = Plaintext(16);
+    const auto packed = crypto.sealEntry(*key, "accounts.example.com", "work account", password.data(), password.size());
+    SecureBuffer plaintext(CryptoModule::openedSize(packed.size()));
+    EntryRecord::Fields fields;
+    const uint64_t allocations = HeapAllocations();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(crypto.openEntry(*key, packed.data(), packed.size(), plaintext, fields));
+    }
+    CountAllocations(state, allocations);
+}
+BENCHMARK(BM_OpenEntry);
+
+// 旧格式：每次加解密都运行一次 Argon2id MODERATE
+void BM_EncryptLegacy(benchmark::State& state)
+{
+    CryptoModule crypto;
+    const std::string master = "Master-Password-1";
+    const auto plaintext = Plaintext(16);
+    const uint64_t allocations = HeapAllocations();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(crypto.encrypt(master, plaintext));
+    }
+    CountAllocations(state, allocations);
+}
+BENCHMARK(BM_EncryptLegacy)->Unit(benchmark::kMillisecond)->Iterations(3);
+
+void BM_DecryptLegacy(benchmark::State& state)
+{
+    CryptoModule crypto;
+    const std::string master = "Master-Password-1";
+    const auto packed = crypto.encrypt(master, Plaintext(16));
+    const uint64_t allocations = HeapAllocations();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(crypto.decrypt(master, packed));
+    }
+    CountAllocations(state, allocations);
+}
+BENCHMARK(BM_DecryptLegacy)->Unit(benchmark::kMillisecond)->Iterations(3);
+
+// 登录时派生会话密钥（KDF）：range(0) 为 KdfProfile::Names() 中的配置序号
+void BM_DeriveSessionKey(benchmark::State& state)
+{
+    CryptoModule crypto;
+    const auto salt = crypto.generateSalt();
+    const std::string name = KdfProfile::Names()[static_cast<size_t>(state.range(0))];
+    const KdfParams params = KdfProfile::Named(name).sessionKey;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(crypto.deriveSessionKey("Master-Password-1", salt, params));
+    }
+    state.SetLabel(name + " " + std::to_string(params.memLimit >> 20) + " MiB");
+}
+BENCHMARK(BM_DeriveSessionKey)->ArgName("profile")->DenseRange(0, 2)->Unit(benchmark::kMillisecond)->Iterations(3);
+
+void BM_UnwrapKey(benchmark::State& state)
+{
+    CryptoModule crypto;
+    auto kek = crypto.generateDataKey();
+    const auto wrapped = crypto.wrapKey(*kek, *crypto.generateDataKey());
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(crypto.unwrapKey(*kek, wrapped));
+    }
+}
+BENCHMARK(BM_UnwrapKey);
+
+// 批量加解密按线程数扩展：range(0) 为线程数
+void BM_EncryptBatch(benchmark::State& state)
+{
+    CryptoModule crypto;
+    auto key = crypto.generateDataKey();
+    const std::vector<std::vector<uint8_t>> plaintexts(10000, Plaintext(16));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(crypto.encryptBatch(*key, plaintexts, static_cast<unsigned>(state.range(0))));
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(plaintexts.size()));
+}
+BENCHMARK(BM_EncryptBatch)->Arg(1)->Arg(2)->Arg(4)->UseRealTime();
+
+void BM_DecryptBatch(benchmark::State& state)
+{
+    CryptoModule crypto;
+    auto key = crypto.generateDataKey();
+    std::vector<std::vector<uint8_t>> packed(10000);
+    for (auto& blob : packed) {
+        blob = crypto.encrypt(*key, Plaintext(16));
+    }
+
+    BatchDecryptOptions options;
+    options.threads = static_cast<unsigned>(state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(crypto.decryptBatch(std::string(), key.get(), packed, options));
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(packed.size()));
+}
+BENCHMARK(BM_DecryptBatch)->Arg(1)->Arg(2)->Arg(4)->UseRealTime();
+
+// 旧格式批量解密：受 Argon2 内存上限约束的并行度
+void BM_DecryptBatchLegacy(benchmark::State& state)
+{
+    CryptoModule crypto;
+    const std::string master = "Master-Password-1";
+    std::vector<std::vector<uint8_t>> packed(4);
+    for (auto& blob : packed) {
+        blob = crypto.encrypt(master, Plaintext(16));
+    }
+
+    BatchDecryptOptions options;
+    options.threads = static_cast<unsigned>(state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(crypto.decryptBatch(master, nullptr, packed, options));
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(packed.size()));
+}
+BENCHMARK(BM_DecryptBatchLegacy)->Arg(1)->Arg(4)->Unit(benchmark::kMillisecond)->Iterations(1)->UseRealTime();
+
+} // namespace
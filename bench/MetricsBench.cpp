@@ -0,0 +1,30 @@
+#include <benchmark/benchmark.h>
+#include "Metrics.h"
+
+// 插桩的单次开销：启用 PASSMGR_ENABLE_METRICS 时每个 PASSMGR_SPAN 展开为一次 ScopedSpan
+namespace {
+
+// 只写本线程的直方图
+void BM_MetricsRecordSpan(benchmark::State& state)
+{
+    const int id = Metrics::Register("bench.record", Metrics::Kind::Span);
+    uint64_t nanos = 1;
+    for (auto _ : state) {
+        Metrics::RecordSpan(id, nanos);
+        nanos = nanos * 3 % 1000003;
+    }
+}
+BENCHMARK(BM_MetricsRecordSpan)->Threads(1)->Threads(4);
+
+// 两次读时钟加一次记录
+void BM_MetricsScopedSpan(benchmark::State& state)
+{
+    const int id = Metrics::Register("bench.scoped", Metrics::Kind::Span);
+    for (auto _ : state) {
+        Metrics::ScopedSpan span(id);
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_MetricsScopedSpan);
+
+} // namespace
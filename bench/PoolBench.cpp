@@ -0,0 +1,81 @@
+#include <benchmark/benchmark.h>
+#include "BenchSupport.h"
+#include "ConnectionPool.h"
+#include <memory>
+#include <string>
+
+// 多个窗口同时写入与查询时连接池的吞吐：线程数对应同时发起请求的后台任务数
+namespace {
+
+std::unique_ptr<BenchVault> fixture;
+
+// 每个写操作单独提交（连接池引入之前的做法）：每条一次日志同步
+void BM_PoolWriteEach(benchmark::State& state)
+{
+    if (state.thread_index() == 0) {
+        fixture.reset(new BenchVault("pool-each"));
+    }
+    int n = 0;
+    for (auto _ : state) {
+        auto pool = ConnectionPool::ForConnection(fixture->Database());
+        const std::string address = "t" + std::to_string(state.thread_index()) + "-" + std::to_string(n++);
+        pool->Exclusive([&](PasswordVault& vault) {
+            return vault.AddEntry(fixture->CodebookId(), address, fixture->SampleBlob(), "");
+        }).get();
+    }
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index() == 0) {
+        fixture.reset();
+    }
+}
+BENCHMARK(BM_PoolWriteEach)->Threads(1)->Threads(4)->Threads(16)->UseRealTime();
+
+// 同时排队的写操作合并为一次提交
+void BM_PoolWriteGrouped(benchmark::State& state)
+{
+    if (state.thread_index() == 0) {
+        fixture.reset(new BenchVault("pool-grouped"));
+    }
+    int n = 0;
+    for (auto _ : state) {
+        auto pool = ConnectionPool::ForConnection(fixture->Database());
+        const std::string address = "t" + std::to_string(state.thread_index()) + "-" + std::to_string(n++);
+        pool->Write([&](PasswordVault& vault) {
+            return vault.AddEntry(fixture->CodebookId(), address, fixture->SampleBlob(), "");
+        }).get();
+    }
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index() == 0) {
+        const ConnectionPool::Stats stats = ConnectionPool::ForConnection(fixture->Database())->GetStats();
+        state.counters["commits"] = static_cast<double>(stats.groupCommits);
+        state.counters["largest_group"] = static_cast<double>(stats.largestGroup);
+        fixture.reset();
+    }
+}
+BENCHMARK(BM_PoolWriteGrouped)->Threads(1)->Threads(4)->Threads(16)->UseRealTime();
+
+// 并发读取第一页条目摘要：range(0) 为读连接数，0 表示所有查询共用主连接
+void BM_PoolRead(benchmark::State& state)
+{
+    if (state.thread_index() == 0) {
+        ConnectionProfile profile = ConnectionProfile::Default();
+        profile.readers = static_cast<int>(state.range(0));
+        fixture.reset(new BenchVault("pool-read-" + std::to_string(profile.readers), profile));
+        fixture->Fill(5000);
+    }
+    for (auto _ : state) {
+        auto page = ConnectionPool::ForConnection(fixture->Database())->Read([](PasswordVault& vault) {
+            return vault.GetEntrySummaries(fixture->CodebookId(), "", 0, 200);
+        });
+        benchmark::DoNotOptimize(page.entries.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index() == 0) {
+        state.counters["waits"] =
+            static_cast<double>(ConnectionPool::ForConnection(fixture->Database())->GetStats().readWaits);
+        fixture.reset();
+    }
+}
+BENCHMARK(BM_PoolRead)->ArgName("readers")->Arg(0)->Arg(4)->Threads(1)->Threads(4)->UseRealTime();
+
+} // namespace
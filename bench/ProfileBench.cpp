@@ -0,0 +1,83 @@
+#include <benchmark/benchmark.h>
+#include "BenchSupport.h"
+#include <string>
+
+// 各数据库连接配置下的写入与查询吞吐：range(0) 为 ConnectionProfile::Names() 中的序号。
+// 设置 PASSBENCH_DIR 可在网络盘上运行
+namespace {
+
+ConnectionProfile ProfileAt(int64_t index)
+{
+    return ConnectionProfile::Named(ConnectionProfile::Names().at(static_cast<size_t>(index)));
+}
+
+void Profiles(benchmark::internal::Benchmark* bench)
+{
+    bench->ArgName("profile");
+    for (size_t i = 0; i < ConnectionProfile::Names().size(); ++i) {
+        bench->Arg(static_cast<int64_t>(i));
+    }
+}
+
+// 逐条自动提交：每条一次日志同步
+void BM_ProfileInsert(benchmark::State& state)
+{
+    const ConnectionProfile profile = ProfileAt(state.range(0));
+    BenchVault fixture("profile-" + profile.name, profile);
+    int n = 0;
+    for (auto _ : state) {
+        fixture.Vault().AddEntry(fixture.CodebookId(), "site" + std::to_string(n++) + ".example.com",
+                                 fixture.SampleBlob(), "");
+    }
+    state.SetLabel(profile.name);
+}
+BENCHMARK(BM_ProfileInsert)->Apply(Profiles);
+
+void BM_ProfileBatchInsert(benchmark::State& state)
+{
+    const ConnectionProfile profile = ProfileAt(state.range(0));
+    BenchVault fixture("profile-" + profile.name, profile);
+    std::vector<PasswordVault::PasswordEntry> batch(1000);
+    for (size_t i = 0; i < batch.size(); ++i) {
+        batch[i].address = "batch" + std::to_string(i) + ".example.com";
+        batch[i].encrypted_password = fixture.SampleBlob();
+    }
+    for (auto _ : state) {
+        fixture.Vault().AddEntries(fixture.CodebookId(), batch);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(batch.size()));
+    state.SetLabel(profile.name);
+}
+BENCHMARK(BM_ProfileBatchInsert)->Apply(Profiles)->Unit(benchmark::kMillisecond);
+
+void BM_ProfileScan(benchmark::State& state)
+{
+    const ConnectionProfile profile = ProfileAt(state.range(0));
+    BenchVault fixture("profile-" + profile.name, profile);
+    fixture.Fill(20000);
+    for (auto _ : state) {
+        PasswordVault::EntryPage page;
+        do {
+            page = fixture.Vault().GetEntries(fixture.CodebookId(), "", page.next_after_id, 200);
+        } while (page.has_more);
+    }
+    state.SetItemsProcessed(state.iterations() * fixture.EntryCount());
+    state.SetLabel(profile.name);
+}
+BENCHMARK(BM_ProfileScan)->Apply(Profiles)->Unit(benchmark::kMillisecond);
+
+void BM_ProfileSearch(benchmark::State& state)
+{
+    const ConnectionProfile profile = ProfileAt(state.range(0));
+    BenchVault fixture("profile-" + profile.name, profile);
+    fixture.Fill(20000);
+    int n = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(fixture.Vault().GetEntrySummaries(
+            fixture.CodebookId(), "site" + std::to_string((n++ * 37) % 20000), 0, 20));
+    }
+    state.SetLabel(profile.name);
+}
+BENCHMARK(BM_ProfileSearch)->Apply(Profiles);
+
+} // namespace
@@ -0,0 +1,39 @@
+#include <benchmark/benchmark.h>
+#include <string>
+#include <vector>
+#include "BenchSupport.h"
+#include "KeyRotation.h"
+
+namespace {
+
+// 重新加密 range(0) 条条目：每轮先建立一次轮换（当前数据密钥成为旧密钥），只计时 Resume
+void BM_KeyRotationResume(benchmark::State& state)
+{
+    BenchVault vault("rotate-" + std::to_string(state.range(0)));
+    CryptoModule crypto;
+    auto kek = crypto.generateDataKey();
+    vault.Vault().SetCodebookKey(vault.CodebookId(), crypto.wrapKey(*kek, vault.Key()));
+    vault.Fill(static_cast<int>(state.range(0)));
+
+    auto keyring = std::make_shared<SessionKeyring>(kek, "Bench-Password-123");
+    KeyRotation rotation(vault.Vault(), keyring);
+    RotationOptions options;
+    options.threads = static_cast<unsigned>(state.range(1));
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        PasswordVault::CodebookRotation next;
+        next.codebook_id = vault.CodebookId();
+        next.wrapped_key = crypto.wrapKey(*kek, *crypto.generateDataKey());
+        next.previous_wrapped_key = crypto.wrapKey(*kek, *keyring->GetCodebookKey(vault.Vault(), vault.CodebookId()));
+        vault.Vault().BeginKeyRotation("bench", "x", crypto.generateSalt(), KdfParams::moderate().encode(), {next});
+        keyring->ForgetCodebook(vault.CodebookId());
+        state.ResumeTiming();
+
+        benchmark::DoNotOptimize(rotation.Resume("bench", options));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_KeyRotationResume)->Args({10000, 1})->Args({10000, 0})->Unit(benchmark::kMillisecond);
+
+} // namespace
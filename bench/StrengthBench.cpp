@@ -0,0 +1,74 @@
+#include <benchmark/benchmark.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "BenchSupport.h"
+#include "PasswordStrength.h"
+
+namespace {
+
+// 常见密码、l33t、键盘序列、日期和随机串各占一部分
+const char* const kSamples[] = {
+    "password", "P@ssw0rd", "qwerty123", "Summer2026", "1988-05-12",
+    "abcabcabc", "zxcvbnm", "woaini1314", "Tr0ub4dour&3", "kJ8#mQ2$vL9!xR4p",
+};
+
+void BM_EstimateStrength(benchmark::State& state)
+{
+    StrengthEstimator estimator;
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(estimator.Estimate(kSamples[i++ % 10]));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_EstimateStrength);
+
+// 最坏情况：达到分析上限长度的随机串
+void BM_EstimateStrengthLong(benchmark::State& state)
+{
+    StrengthEstimator estimator;
+    std::string password;
+    for (int i = 0; i < state.range(0); ++i) {
+        password += "aZ3#kq9!x"[(i * 7) % 9];
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(estimator.Estimate(password));
+    }
+}
+BENCHMARK(BM_EstimateStrengthLong)->Arg(16)->Arg(32)->Arg(100);
+
+// 映射并校验一个 range(0) 词的字典文件
+void BM_DictionaryOpen(benchmark::State& state)
+{
+    std::vector<std::string> words;
+    for (int i = 0; i < state.range(0); ++i) {
+        words.push_back("word" + std::to_string(i * 7919));
+    }
+    const std::string path = BenchDirectory() + "/passbench-dict.dict";
+    PasswordDictionary::CompileFile(words, path);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(PasswordDictionary::Open(path));
+    }
+    std::remove(path.c_str());
+}
+BENCHMARK(BM_DictionaryOpen)->Arg(10000)->Arg(100000)->Unit(benchmark::kMillisecond);
+
+// 大词典下的估计：trie 查找与词表大小基本无关
+void BM_EstimateStrengthLargeDictionary(benchmark::State& state)
+{
+    std::vector<std::string> words;
+    for (int i = 0; i < 100000; ++i) {
+        words.push_back("word" + std::to_string(i * 7919));
+    }
+    StrengthEstimator estimator(PasswordDictionary::FromBytes(PasswordDictionary::Compile(words)));
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(estimator.Estimate(kSamples[i++ % 10]));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_EstimateStrengthLargeDictionary);
+
+} // namespace
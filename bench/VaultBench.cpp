@@ -0,0 +1,286 @@
+#include <benchmark/benchmark.h>
+#include "BenchSupport.h"
+#include <map>
+#include <memory>
+#include <string>
+
+namespace {
+
+// 不同规模的密码本：range(0) 为已有条目数
+void VaultSizes(benchmark::internal::Benchmark* bench)
+{
+    bench->Arg(1000)->Arg(10000)->Arg(100000);
+}
+
+// 删除基准运行期间新增的条目，使共享数据库保持原有规模
+void TrimTo(BenchVault& fixture, sqlite3_int64 lastId)
+{
+    const std::string sql = "DELETE FROM PasswordEntry WHERE entry_id > " + std::to_string(lastId);
+    sqlite3_exec(fixture.Database(), sql.c_str(), nullptr, nullptr, nullptr);
+}
+
+sqlite3_int64 LastEntryId(BenchVault& fixture)
+{
+    sqlite3_stmt* stmt = nullptr;
+    sqlite3_prepare_v2(fixture.Database(), "SELECT max(entry_id) FROM PasswordEntry", -1, &stmt, nullptr);
+    sqlite3_int64 id = sqlite3_step(stmt) == SQLITE_ROW ? sqlite3_column_int64(stmt, 0) : 0;
+    sqlite3_finalize(stmt);
+    return id;
+}
+
+void BM_AddEntry(benchmark::State& state)
+{
+    BenchVault& fixture = SharedVault(static_cast<int>(state.range(0)));
+    const sqlite3_int64 lastId = LastEntryId(fixture);
+    int n = 0;
+    for (auto _ : state) {
+        fixture.Vault().AddEntry(fixture.CodebookId(), "new" + std::to_string(n++) + ".example.com",
+                                 fixture.SampleBlob(), "");
+    }
+    TrimTo(fixture, lastId);
+}
+BENCHMARK(BM_AddEntry)->Apply(VaultSizes);
+
+// 单事务批量插入 1000 条
+void BM_AddEntries(benchmark::State& state)
+{
+    BenchVault& fixture = SharedVault(static_cast<int>(state.range(0)));
+    const sqlite3_int64 lastId = LastEntryId(fixture);
+    std::vector<PasswordVault::PasswordEntry> batch(1000);
+    for (size_t i = 0; i < batch.size(); ++i) {
+        batch[i].address = "batch" + std::to_string(i) + ".example.com";
+        batch[i].encrypted_password = fixture.SampleBlob();
+    }
+    for (auto _ : state) {
+        fixture.Vault().AddEntries(fixture.CodebookId(), batch);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(batch.size()));
+    TrimTo(fixture, lastId);
+}
+BENCHMARK(BM_AddEntries)->Apply(VaultSizes)->Unit(benchmark::kMillisecond);
+
+// 键集分页读取位于密码本中部的一页
+void BM_GetEntriesPage(benchmark::State& state)
+{
+    BenchVault& fixture = SharedVault(static_cast<int>(state.range(0)));
+    const int afterId = static_cast<int>(LastEntryId(fixture) / 2);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(fixture.Vault().GetEntries(fixture.CodebookId(), "", afterId, 50));
+    }
+    state.SetItemsProcessed(state.iterations() * 50);
+}
+BENCHMARK(BM_GetEntriesPage)->Apply(VaultSizes);
+
+// 逐页读取整个密码本
+void BM_GetEntriesScan(benchmark::State& state)
+{
+    BenchVault& fixture = SharedVault(static_cast<int>(state.range(0)));
+    for (auto _ : state) {
+        PasswordVault::EntryPage page;
+        do {
+            page = fixture.Vault().GetEntries(fixture.CodebookId(), "", page.next_after_id, 500);
+        } while (page.has_more);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_GetEntriesScan)->Apply(VaultSizes)->Unit(benchmark::kMillisecond);
+
+// 读取并解密整个密码本：GetEntries 把每行复制进 PasswordEntry，再由向量接口解密
+void BM_DecryptScanCopy(benchmark::State& state)
+{
+    BenchVault& fixture = SharedVault(static_cast<int>(state.range(0)));
+    CryptoModule crypto;
+    const uint64_t allocations = HeapAllocations();
+    for (auto _ : state) {
+        PasswordVault::EntryPage page;
+        do {
+            page = fixture.Vault().GetEntries(fixture.CodebookId(), "", page.next_after_id, 500);
+            for (const auto& entry : page.entries) {
+                benchmark::DoNotOptimize(crypto.decrypt(fixture.Key(), entry.encrypted_password));
+            }
+        } while (page.has_more);
+    }
+    const double entries = static_cast<double>(state.iterations() * state.range(0));
+    state.counters["allocs_per_entry"] = static_cast<double>(HeapAllocations() - allocations) / entries;
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_DecryptScanCopy)->Apply(VaultSizes)->Unit(benchmark::kMillisecond);
+
+// 同样的工作改用 VisitEntryBlobs 与指针接口：密文不离开语句结果，明文写入复用的锁定内存
+void BM_DecryptScanView(benchmark::State& state)
+{
+    BenchVault& fixture = SharedVault(static_cast<int>(state.range(0)));
+    CryptoModule crypto;
+    SecureBuffer plaintext(64);
+    const uint64_t allocations = HeapAllocations();
+    for (auto _ : state) {
+        PasswordVault::BlobPage page;
+        do {
+            page = fixture.Vault().VisitEntryBlobs(fixture.CodebookId(), [&](int, const uint8_t* blob, size_t size) {
+                benchmark::DoNotOptimize(crypto.decrypt(fixture.Key(), blob, size, plaintext));
+            }, page.next_after_id, 500);
+        } while (page.has_more);
+    }
+    const double entries = static_cast<double>(state.iterations() * state.range(0));
+    state.counters["allocs_per_entry"] = static_cast<double>(HeapAllocations() - allocations) / entries;
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_DecryptScanView)->Apply(VaultSizes)->Unit(benchmark::kMillisecond);
+
+// 按地址子串过滤
+void BM_GetEntriesFilter(benchmark::State& state)
+{
+    BenchVault& fixture = SharedVault(static_cast<int>(state.range(0)));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(fixture.Vault().GetEntrySummaries(fixture.CodebookId(), "site77", 0, 20));
+    }
+}
+BENCHMARK(BM_GetEntriesFilter)->Apply(VaultSizes);
+
+// 全文搜索：arg1 = 0 为少量命中，1 为几乎全部命中
+void BM_Search(benchmark::State& state)
+{
+    BenchVault& fixture = SharedVault(static_cast<int>(state.range(0)));
+    const char* query = state.range(1) == 0 ? "site77" : "example";
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(fixture.Vault().Search(fixture.CodebookId(), query, 20));
+    }
+}
+BENCHMARK(BM_Search)->ArgsProduct({{1000, 10000, 100000}, {0, 1}});
+
+void BM_DeleteEntry(benchmark::State& state)
+{
+    BenchVault& fixture = SharedVault(static_cast<int>(state.range(0)));
+    for (auto _ : state) {
+        state.PauseTiming();
+        fixture.Vault().AddEntry(fixture.CodebookId(), "doomed.example.com", fixture.SampleBlob(), "");
+        const int entryId = static_cast<int>(sqlite3_last_insert_rowid(fixture.Database()));
+        state.ResumeTiming();
+
+        fixture.Vault().DeleteEntry(entryId);
+    }
+}
+BENCHMARK(BM_DeleteEntry)->Apply(VaultSizes);
+
+// 预编译语句缓存：每次重新 prepare/finalize 与复用缓存语句的对比
+void BM_PointQueryUncached(benchmark::State& state)
+{
+    BenchVault& fixture = SharedVault(1000);
+    for (auto _ : state) {
+        sqlite3_stmt* stmt = nullptr;
+        sqlite3_prepare_v2(fixture.Database(), "SELECT 1 FROM Codebook WHERE codebook_id = ?", -1, &stmt, nullptr);
+        sqlite3_bind_int(stmt, 1, fixture.CodebookId());
+        benchmark::DoNotOptimize(sqlite3_step(stmt));
+        sqlite3_finalize(stmt);
+    }
+}
+BENCHMARK(BM_PointQueryUncached);
+
+void BM_PointQueryCached(benchmark::State& state)
+{
+    BenchVault& fixture = SharedVault(1000);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(fixture.Vault().CheckCodebookExists(fixture.CodebookId()));
+    }
+}
+BENCHMARK(BM_PointQueryCached);
+
+// 列出用户的密码本：range(0) 个密码本，每个 20 条条目
+BenchVault& CodebookListVault(int codebooks)
+{
+    static std::map<int, std::unique_ptr<BenchVault>> vaults;
+    auto& fixture = vaults[codebooks];
+    if (!fixture) {
+        fixture.reset(new BenchVault("codebooks-" + std::to_string(codebooks)));
+        std::vector<PasswordVault::PasswordEntry> batch(20);
+        for (size_t i = 0; i < batch.size(); ++i) {
+            batch[i].address = "site" + std::to_string(i) + ".example.com";
+            batch[i].encrypted_password = fixture->SampleBlob();
+        }
+        for (int i = 1; i < codebooks; ++i) {
+            const int id = fixture->Vault().CreateCodebook("bench", "book" + std::to_string(i)).id;
+            fixture->Vault().AddEntries(id, batch);
+        }
+    }
+    return *fixture;
+}
+
+// 触发器维护的统计列：一次按索引的查询
+void BM_ListCodebooks(benchmark::State& state)
+{
+    BenchVault& fixture = CodebookListVault(static_cast<int>(state.range(0)));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(fixture.Vault().GetUserCodebooks("bench"));
+    }
+}
+BENCHMARK(BM_ListCodebooks)->Arg(100)->Arg(1000);
+
+// 对照：列表时对条目表做聚合
+void BM_ListCodebooksAggregate(benchmark::State& state)
+{
+    BenchVault& fixture = CodebookListVault(static_cast<int>(state.range(0)));
+    const char* sql = R"(
+        SELECT c.codebook_id, c.codebook_name, c.created_time, COUNT(e.entry_id),
+               COALESCE(SUM(length(e.address) + length(e.encrypted_password) + COALESCE(length(e.notes), 0)), 0),
+               MAX(e.created_time)
+        FROM Codebook c LEFT JOIN PasswordEntry e ON e.codebook_id = c.codebook_id
+        WHERE c.username = ?
+        GROUP BY c.codebook_id
+        ORDER BY c.created_time DESC
+    )";
+    sqlite3_stmt* stmt = nullptr;
+    sqlite3_prepare_v2(fixture.Database(), sql, -1, &stmt, nullptr);
+    for (auto _ : state) {
+        sqlite3_bind_text(stmt, 1, "bench", -1, SQLITE_STATIC);
+        int rows = 0;
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            ++rows;
+        }
+        sqlite3_reset(stmt);
+        benchmark::DoNotOptimize(rows);
+    }
+    sqlite3_finalize(stmt);
+}
+BENCHMARK(BM_ListCodebooksAggregate)->Arg(100)->Arg(1000);
+
+// 密码本的创建与删除：用户已有 range(0) 个密码本，每次迭代为两个界面操作，items_per_second 即每秒操作数
+void BM_CodebookActionsById(benchmark::State& state)
+{
+    BenchVault& fixture = CodebookListVault(static_cast<int>(state.range(0)));
+    int n = 0;
+    for (auto _ : state) {
+        const int id = fixture.Vault().CreateCodebook("bench", "action" + std::to_string(n++)).id;
+        fixture.Vault().DeleteCodebook(id);
+    }
+    state.SetItemsProcessed(state.iterations() * 2);
+}
+BENCHMARK(BM_CodebookActionsById)->Arg(1)->Arg(100)->UseRealTime();
+
+// 对照：改为按 ID 之前的语句序列——按名称反查 ID、检查存在、显式删除条目后再删除密码本
+void BM_CodebookActionsByName(benchmark::State& state)
+{
+    BenchVault& fixture = CodebookListVault(static_cast<int>(state.range(0)));
+    auto statements = StatementCache::ForConnection(fixture.Database());
+    auto run = [&statements](const char* sql, const std::string& text, int id) {
+        auto stmt = statements->Prepare(sql);
+        if (!text.empty()) sqlite3_bind_text(stmt, 1, text.c_str(), -1, SQLITE_TRANSIENT);
+        if (id >= 0) sqlite3_bind_int(stmt, 1, id);
+        return sqlite3_step(stmt) == SQLITE_ROW ? sqlite3_column_int(stmt, 0) : -1;
+    };
+    int n = 0;
+    for (auto _ : state) {
+        const std::string name = "action" + std::to_string(n++);
+        run("INSERT INTO Codebook (username, codebook_name) VALUES ('bench', ?) ON CONFLICT DO NOTHING", name, -1);
+        benchmark::DoNotOptimize(fixture.Vault().GetUserCodebooks("bench"));   // 创建后重新加载列表
+        const int id = run("SELECT codebook_id FROM Codebook WHERE username = 'bench' AND codebook_name = ?", name, -1);
+        run("SELECT 1 FROM Codebook WHERE codebook_id = ?", "", id);
+        run("BEGIN", "", -1);
+        run("DELETE FROM PasswordEntry WHERE codebook_id = ?", "", id);
+        run("DELETE FROM Codebook WHERE codebook_id = ?", "", id);
+        run("COMMIT", "", -1);
+    }
+    state.SetItemsProcessed(state.iterations() * 2);
+}
+BENCHMARK(BM_CodebookActionsByName)->Arg(1)->Arg(100)->UseRealTime();
+
+} // namespace
@@ -0,0 +1,19 @@
+#pragma once
+#include <istream>
+#include <map>
+#include <string>
+
+// 简单的 key = value 配置文件，# 开头为注释；文件不存在时所有项取默认值
+class AppConfig {
+public:
+    static AppConfig Load(const std::string& path);
+    static AppConfig Parse(std::istream& in);
+
+    bool Has(const std::string& key) const;
+    std::string Get(const std::string& key, const std::string& fallback = "") const;
+    long long GetInt(const std::string& key, long long fallback) const;
+    void Set(const std::string& key, const std::string& value);
+
+private:
+    std::map<std::string, std::string> values_;
+};
@@ -0,0 +1,70 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+
+// 本地泄露密码库：按 SHA-1 排序的摘要表，加载时内存映射，查询不联网。
+// 文件格式（小端）：
+//   "PMBR" ‖ 版本 u32 ‖ 摘要数 u64 ‖ 前缀索引 u64[65537] ‖ 摘要 20 字节 × 摘要数
+// 前缀索引第 p 项是前两字节不小于 p 的第一个摘要序号，与 HIBP 按前缀分段的 k-匿名查询一致，
+// 查询先定位前缀段，再在段内二分查找。使用 SHA-1 是为了能直接导入 HIBP 的 "哈希:次数" 列表。
+class BreachStore {
+public:
+    static const size_t kDigestBytes = 20;
+    using Digest = std::array<uint8_t, kDigestBytes>;
+
+    // 打开并校验文件，格式错误时抛出 std::runtime_error
+    static std::shared_ptr<const BreachStore> Open(const std::string& path);
+    // 工作目录下的 passmgr.breach，不存在时返回空指针
+    static std::shared_ptr<const BreachStore> OpenDefault();
+
+    // 密码（UTF-8）的 SHA-1
+    static Digest Hash(const uint8_t* data, size_t length);
+    static Digest Hash(const std::string& password) {
+        return Hash(reinterpret_cast<const uint8_t*>(password.data()), password.size());
+    }
+    // 解析 40 位十六进制摘要（大小写均可），格式错误返回 false
+    static bool ParseHex(const char* hex, size_t length, Digest& digest);
+
+    bool Contains(const Digest& digest) const;
+    bool Contains(const std::string& password) const { return Contains(Hash(password)); }
+    uint64_t Count() const { return count_; }
+    // 标识库的内容：更换泄露库后缓存的检查结果随之失效
+    const std::vector<uint8_t>& Tag() const { return tag_; }
+
+private:
+    BreachStore() = default;
+
+    MappedFile file_;
+    const uint8_t* buckets_ = nullptr;
+    const uint8_t* digests_ = nullptr;
+    uint64_t count_ = 0;
+    std::vector<uint8_t> tag_;
+};
+
+// 顺序写入泄露库：摘要须按升序添加，重复的摘要只保留一个
+class BreachStoreWriter {
+public:
+    // 无法创建文件时抛出 std::runtime_error
+    explicit BreachStoreWriter(const std::string& path);
+
+    // 摘要小于上一个时抛出 std::invalid_argument
+    void Add(const BreachStore::Digest& digest);
+    // 写入前缀索引与文件头，返回摘要数
+    uint64_t Finish();
+
+    // 排序、去重后写入整个摘要表
+    static uint64_t Write(std::vector<BreachStore::Digest> digests, const std::string& path);
+
+private:
+    std::ofstream out_;
+    std::vector<uint64_t> buckets_;
+    BreachStore::Digest last_{};
+    uint64_t count_ = 0;
+    bool finished_ = false;
+};
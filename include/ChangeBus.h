@@ -0,0 +1,35 @@
+#pragma once
+#include <sqlite3.h>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+
+// 每个连接一份的变更通知：PasswordVault 提交写入后发布当前的变更序号，
+// 订阅者再用 PasswordVault::GetChangesSince 取回自己关心的差量。
+// 回调在写入所在的线程中同步调用，期间持有总线的锁：回调应当只投递通知，
+// 不能再订阅、退订或访问数据库。
+class ChangeBus {
+public:
+    using Listener = std::function<void(int64_t seq)>;
+
+    // 获取连接对应的总线；关闭连接前必须调用 ReleaseConnection
+    static std::shared_ptr<ChangeBus> ForConnection(sqlite3* db);
+    static void ReleaseConnection(sqlite3* db);
+
+    ChangeBus(const ChangeBus&) = delete;
+    ChangeBus& operator=(const ChangeBus&) = delete;
+
+    // 返回订阅编号；退订返回后回调不会再被调用
+    int Subscribe(Listener listener);
+    void Unsubscribe(int id);
+    void Publish(int64_t seq);
+
+private:
+    ChangeBus() = default;
+
+    std::mutex mutex_;
+    std::map<int, Listener> listeners_;
+    int nextId_ = 1;
+};
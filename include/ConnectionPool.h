@@ -0,0 +1,184 @@
+#pragma once
+#include <sqlite3.h>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "ConnectionProfile.h"
+#include "PassWordVault.h"
+
+// 一个数据库文件的连接池：若干只读 WAL 连接并发执行查询，所有写入交给唯一的写线程。
+// 写线程独占主连接（UserAuth 打开的连接），把排队的写操作合并为成组提交的事务：
+// 每个操作包在各自的 SAVEPOINT 中，单个失败只回滚它自己，其余随同一次 COMMIT 落盘，
+// 提交后才兑现各自的 future 并在主连接的 ChangeBus 上发布一次变更序号。
+// WAL 下读连接看到的是已提交的快照，不会因写事务而等待；
+// 独占锁或非 WAL 模式下不开读连接，查询借用主连接，与写线程互斥：
+// 只在写线程没有执行任务、主连接上没有未结束的事务时读取，写线程执行长任务期间查询需要等待。
+class ConnectionPool {
+public:
+    struct Stats {
+        size_t readers = 0;            // 已打开的只读连接
+        uint64_t reads = 0;
+        uint64_t readWaits = 0;        // 读连接全部占用而等待的次数
+        uint64_t groupedWrites = 0;
+        uint64_t groupCommits = 0;
+        size_t largestGroup = 0;
+        uint64_t exclusiveJobs = 0;
+        size_t peakQueueDepth = 0;
+    };
+
+    // 读连接租约：析构时归还
+    class ReadLease {
+    public:
+        ReadLease(ReadLease&& other) noexcept;
+        ~ReadLease();
+        ReadLease(const ReadLease&) = delete;
+        ReadLease& operator=(const ReadLease&) = delete;
+        ReadLease& operator=(ReadLease&&) = delete;
+
+        PasswordVault& Vault() const { return *vault_; }
+        sqlite3* Handle() const { return db_; }
+
+    private:
+        friend class ConnectionPool;
+        ReadLease(ConnectionPool* pool, int index, sqlite3* db, PasswordVault* vault,
+                  std::unique_lock<std::mutex> primaryLock = std::unique_lock<std::mutex>());
+
+        ConnectionPool* pool_;
+        int index_;   // -1 表示借用主连接
+        sqlite3* db_;
+        PasswordVault* vault_;
+        std::unique_lock<std::mutex> primaryLock_;   // 借用主连接期间持有
+    };
+
+    // 为主连接建立连接池，读连接数取 profile.readers；已建立时返回已有的连接池
+    static std::shared_ptr<ConnectionPool> Attach(sqlite3* primary, const ConnectionProfile& profile);
+    // 获取主连接对应的连接池，尚未建立时以不含读连接的配置建立
+    static std::shared_ptr<ConnectionPool> ForConnection(sqlite3* primary);
+    // 关闭主连接前调用：执行完已排队的写操作，停止写线程并关闭读连接
+    static void ReleaseConnection(sqlite3* primary);
+
+    ~ConnectionPool();
+    ConnectionPool(const ConnectionPool&) = delete;
+    ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+    // 按需打开读连接；全部占用时等待归还
+    ReadLease AcquireReader();
+
+    // 在调用线程上用一个读连接执行查询
+    template <typename Fn>
+    auto Read(Fn&& fn) -> decltype(fn(std::declval<PasswordVault&>())) {
+        ReadLease lease = AcquireReader();
+        return fn(lease.Vault());
+    }
+
+    // 排入写队列，与同时排队的其他写操作成组提交；结果在提交后才可取得
+    template <typename Fn>
+    auto Write(Fn fn) -> std::future<decltype(fn(std::declval<PasswordVault&>()))> {
+        return Submit(std::move(fn), true);
+    }
+
+    // 在写线程上单独执行、不并入成组事务：用于自行分批提交的长任务（导入、审计、密钥轮换等），
+    // 执行期间其余写操作排队等待，读连接不受影响
+    template <typename Fn>
+    auto Exclusive(Fn fn) -> std::future<decltype(fn(std::declval<PasswordVault&>()))> {
+        return Submit(std::move(fn), false);
+    }
+
+    size_t MaxReaders() const { return maxReaders_; }
+    Stats GetStats() const;
+
+private:
+    struct Job {
+        std::function<void(PasswordVault&)> run;
+        std::function<void()> complete;
+        std::function<void(std::exception_ptr)> fail;
+        bool grouped;
+    };
+
+    template <typename R>
+    struct Outcome {
+        std::promise<R> promise;
+        std::unique_ptr<R> value;
+
+        template <typename Fn>
+        void Run(Fn& fn, PasswordVault& vault) { value.reset(new R(fn(vault))); }
+        void Complete() { promise.set_value(std::move(*value)); }
+    };
+
+    template <typename Fn>
+    auto Submit(Fn fn, bool grouped) -> std::future<decltype(fn(std::declval<PasswordVault&>()))> {
+        using Result = decltype(fn(std::declval<PasswordVault&>()));
+        auto outcome = std::make_shared<Outcome<Result>>();
+        auto task = std::make_shared<Fn>(std::move(fn));
+
+        Job job;
+        job.run = [outcome, task](PasswordVault& vault) { outcome->Run(*task, vault); };
+        job.complete = [outcome] { outcome->Complete(); };
+        job.fail = [outcome](std::exception_ptr error) { outcome->promise.set_exception(error); };
+        job.grouped = grouped;
+
+        auto future = outcome->promise.get_future();
+        Enqueue(std::move(job));
+        return future;
+    }
+
+    ConnectionPool(sqlite3* primary, const ConnectionProfile& profile, size_t readers);
+
+    void Enqueue(Job job);
+    void WriterLoop();
+    void RunGroup(std::vector<Job>& group);
+    void RunExclusive(Job& job);
+    void Publish(int64_t seq);
+    void Shutdown();
+    void ReturnReader(int index);
+    sqlite3* OpenReader();
+
+    sqlite3* primary_;
+    const std::string path_;
+    const ConnectionProfile profile_;
+    const size_t maxReaders_;
+    PasswordVault writerVault_;
+    // 写线程执行任务期间持有；不开读连接时，借用主连接的租约同样持有，查询不会看到未提交的写入
+    std::mutex primaryMutex_;
+
+    // 读连接
+    struct Reader {
+        sqlite3* db;
+        std::unique_ptr<PasswordVault> vault;
+    };
+    std::vector<Reader> readers_;
+    std::vector<int> idleReaders_;
+    bool closed_ = false;
+    std::mutex readMutex_;
+    std::condition_variable readerReturned_;
+
+    // 写队列
+    std::deque<Job> queue_;
+    std::thread writer_;
+    bool stopping_ = false;
+    std::mutex writeMutex_;
+    std::condition_variable queued_;
+
+    mutable std::mutex statsMutex_;
+    Stats stats_;
+};
+
+// 无返回值的写操作
+template <>
+struct ConnectionPool::Outcome<void> {
+    std::promise<void> promise;
+
+    template <typename Fn>
+    void Run(Fn& fn, PasswordVault& vault) { fn(vault); }
+    void Complete() { promise.set_value(); }
+};
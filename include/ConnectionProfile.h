@@ -0,0 +1,41 @@
+#pragma once
+#include <sqlite3.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "AppConfig.h"
+
+// SQLite 连接参数。每个连接打开后调用 Apply，按配置设置日志模式、缓存等 PRAGMA
+struct ConnectionProfile {
+    std::string name = "default";
+    std::string journalMode = "WAL";      // WAL / DELETE / TRUNCATE
+    std::string synchronous = "NORMAL";   // OFF / NORMAL / FULL / EXTRA
+    std::string lockingMode = "NORMAL";   // NORMAL / EXCLUSIVE
+    std::string tempStore = "MEMORY";     // DEFAULT / FILE / MEMORY
+    int64_t cacheSizeKiB = 16 * 1024;
+    int64_t mmapSize = 256 * 1024 * 1024;
+    int busyTimeoutMs = 5000;
+    int readers = 4;                      // 连接池的只读连接数，0 表示查询也使用主连接
+
+    // default：本地磁盘，WAL + 内存映射读取
+    static ConnectionProfile Default();
+    // network：网络盘上共享内存与 mmap 不可靠，使用独占锁的 WAL（不需要 -shm 文件）、
+    // 关闭 mmap、加大页缓存以减少往返；独占锁下无法再开读连接
+    static ConnectionProfile Network();
+    // compat：SQLite 默认设置（回滚日志、FULL 同步），用于不支持 WAL 的环境
+    static ConnectionProfile Compat();
+
+    static ConnectionProfile Named(const std::string& name);
+    static std::vector<std::string> Names();
+
+    // 读取 db.profile 选择基础配置，再用 db.* 单项覆盖；非法取值抛出 invalid_argument
+    static ConnectionProfile FromConfig(const AppConfig& config);
+
+    // readers 大于 0 时要求 WAL 且非独占锁，否则抛出 invalid_argument
+    void Validate() const;
+    bool SupportsReaders() const;
+    // 同时开启 foreign_keys，该设置只对当前连接有效
+    void Apply(sqlite3* db) const;
+    // 连接池的只读连接：沿用主连接的日志模式，只设置缓存、mmap 等并开启 query_only
+    void ApplyReader(sqlite3* db) const;
+};
@@ -1,15 +1,187 @@
 #pragma once
 #include <vector>
 #include <string>
+#include <memory>
+#include <atomic>
+#include <functional>
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <stdexcept>
+#include "SecureArena.h"
+#include "EntryRecord.h"
+
+// 存放在锁定内存池槽位中的对称密钥，析构时自动清零归还
+class SecureKey {
+public:
+    static const size_t kKeyBytes = 32;
+
+    SecureKey();
+    ~SecureKey();
+    SecureKey(const SecureKey&) = delete;
+    SecureKey& operator=(const SecureKey&) = delete;
+
+    uint8_t* data() { return data_; }
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return kKeyBytes; }
+    // 记录头中的 key_id：以密钥为 BLAKE2b 的密钥对固定串取摘要的前 4 字节，不泄露密钥本身。
+    // 首次调用时计算并缓存，因此密钥写入后不能再修改
+    uint32_t id() const;
+
+private:
+    uint8_t* data_;
+    mutable std::atomic<uint64_t> id_;   // 低 32 位为标识，第 32 位表示已计算
+};
+
+// 存放明文的锁定内存缓冲区，取自 SecureArena 槽位，可在多次解密之间复用：
+// 容量按槽位大小向上取整，只在容量不足时换用更大的槽位，旧槽位归还前先清零
+class SecureBuffer {
+public:
+    explicit SecureBuffer(size_t capacity = 0);
+    ~SecureBuffer();
+    SecureBuffer(const SecureBuffer&) = delete;
+    SecureBuffer& operator=(const SecureBuffer&) = delete;
+
+    void reserve(size_t capacity);
+    // 扩容时不保留原有内容
+    void resize(size_t size);
+    // 清零内容并将长度置零，保留容量
+    void clear();
+
+    uint8_t* data() { return data_; }
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+    size_t capacity() const { return capacity_; }
+
+private:
+    uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    size_t capacity_ = 0;
+};
+
+// 不持有内存的口令视图，指向调用方的缓冲区（如存放主密码的 SecureBuffer），传递时不复制口令
+struct PasswordView {
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+
+    PasswordView() = default;
+    PasswordView(const uint8_t* bytes, size_t length) : data(bytes), size(length) {}
+    PasswordView(const char* text) : data(reinterpret_cast<const uint8_t*>(text)), size(std::strlen(text)) {}
+    PasswordView(const std::string& text)
+        : data(reinterpret_cast<const uint8_t*>(text.data())), size(text.size()) {}
+    PasswordView(const SecureBuffer& buffer) : data(buffer.data()), size(buffer.size()) {}
+
+    bool empty() const { return size == 0; }
+};
+
+// Argon2id 成本参数
+struct KdfParams {
+    uint64_t opsLimit;
+    size_t memLimit;   // 字节
+
+    static KdfParams interactive();   // 64 MiB
+    static KdfParams moderate();      // 256 MiB，旧版本的会话密钥与备份固定使用
+    static KdfParams sensitive();     // 1 GiB，旧版本的登录密码哈希固定使用
+
+    // 8 字节编码：u32 opsLimit ‖ u32 memLimit（KiB），小端；用于数据库与备份文件头
+    static const size_t kEncodedBytes = 8;
+    std::vector<uint8_t> encode() const;
+    // 长度错误或超出 libsodium 允许范围时抛出 runtime_error
+    static KdfParams decode(const uint8_t* data, size_t size);
+
+    void validate() const;
+    bool operator==(const KdfParams& other) const { return opsLimit == other.opsLimit && memLimit == other.memLimit; }
+    bool operator!=(const KdfParams& other) const { return !(*this == other); }
+};
+
+// 批量解密参数
+struct BatchDecryptOptions {
+    unsigned threads = 0;                       // 工作线程数，0 表示使用全部硬件线程
+    size_t kdfMemoryCap = 512u * 1024 * 1024;   // 同时进行的 Argon2 派生占用内存上限
+    const SecureKey* previousKey = nullptr;     // 数据密钥无法解密时再尝试的旧数据密钥（密钥轮换未完成时）
+    // 每完成一个工作单元调用一次（已串行化），返回 false 取消剩余工作
+    std::function<bool(size_t done, size_t total)> progress;
+};
+
+struct BatchDecryptResult {
+    bool ok = false;
+    std::vector<uint8_t> plaintext;
+};
 
 class CryptoModule {
 public:
     CryptoModule();
-    std::vector<uint8_t> encrypt(const std::string& masterPassword, const std::vector<uint8_t>& plaintext);
-    std::vector<uint8_t> decrypt(const std::string& masterPassword, const std::vector<uint8_t>& packedData);
+
+    // 旧格式（salt‖nonce‖ciphertext）：每次调用都会运行一次 Argon2id
+    std::vector<uint8_t> encrypt(PasswordView masterPassword, const std::vector<uint8_t>& plaintext);
+    std::vector<uint8_t> decrypt(PasswordView masterPassword, const std::vector<uint8_t>& packedData);
+
+    // 密钥层级：登录时派生一次会话密钥（KEK），用它包裹每个密码本的数据密钥
+    std::vector<uint8_t> generateSalt() const;
+    std::shared_ptr<SecureKey> deriveSessionKey(const std::string& masterPassword, const std::vector<uint8_t>& salt,
+                                                const KdfParams& params = KdfParams::moderate());
+    // 测量本机后选择参数：内存取不超过 memoryCap 的最大可用值（单次派生超时则减半），
+    // 再按实测耗时选择迭代次数，使一次派生接近 targetMs
+    static KdfParams calibrateKdf(unsigned targetMs, size_t memoryCap);
+    std::shared_ptr<SecureKey> generateDataKey() const;
+    // 从 key 派生用途独立的子密钥，context 为 8 字节的用途标识
+    std::shared_ptr<SecureKey> deriveSubkey(const SecureKey& key, uint64_t id, const char* context) const;
+    std::vector<uint8_t> wrapKey(const SecureKey& kek, const SecureKey& dataKey);
+    std::shared_ptr<SecureKey> unwrapKey(const SecureKey& kek, const std::vector<uint8_t>& wrappedKey);
+
+    // 数据密钥格式：写入 EntryRecord 版本 3（XChaCha20-Poly1305，记录头为附加数据），
+    // 读取时兼容版本 2 的 secretbox 记录；记录的 key_id 与密钥不符时不做解密直接失败
+    std::vector<uint8_t> encrypt(const SecureKey& dataKey, const std::vector<uint8_t>& plaintext);
+    std::vector<uint8_t> decrypt(const SecureKey& dataKey, const std::vector<uint8_t>& packedData);
+
+    // 指针与长度版本：直接读写调用方的缓冲区，不分配内存、不复制输入。
+    // 输出长度分别为 sealedSize / openedSize；缓冲区不足、格式错误或校验失败时返回 false
+    static size_t sealedSize(size_t plaintextSize);
+    // 按记录头给出准确的明文长度；无法识别的数据返回 0
+    static size_t openedSize(const uint8_t* packedData, size_t packedSize);
+    // 只看长度时的上限（按开销最小的版本 2 计算），用于预先分配缓冲区
+    static size_t openedSize(size_t packedSize);
+    bool encrypt(const SecureKey& dataKey, const uint8_t* plaintext, size_t plaintextSize,
+                 uint8_t* packedOut, size_t packedCapacity);
+    bool decrypt(const SecureKey& dataKey, const uint8_t* packedData, size_t packedSize,
+                 uint8_t* plaintextOut, size_t plaintextCapacity);
+    // 解密到可复用的锁定内存缓冲区，容量不足时扩容
+    bool decrypt(const SecureKey& dataKey, const uint8_t* packedData, size_t packedSize, SecureBuffer& plaintext);
+
+    // 整条条目（地址、备注、密码）封装为一条 EntryRecord::Kind::Entry 记录；
+    // 拼接明文时只使用锁定内存。openEntry 解密到 plaintext，fields 指向其内部，缓冲区复用或清空后失效
+    std::vector<uint8_t> sealEntry(const SecureKey& dataKey, const std::string& address, const std::string& notes,
+                                   const uint8_t* password, size_t passwordSize);
+    bool openEntry(const SecureKey& dataKey, const uint8_t* packedData, size_t packedSize,
+                   SecureBuffer& plaintext, EntryRecord::Fields& fields);
+
+    // 并行解密整批数据：新格式使用 dataKey（可为空），旧格式按 salt 分组、每组只派生一次密钥；
+    // 给出主密码时，带记录头但无法解密的数据再按旧格式尝试一次（见 mayBeLegacyFormat）
+    std::vector<BatchDecryptResult> decryptBatch(PasswordView masterPassword,
+                                                 const SecureKey* dataKey,
+                                                 const std::vector<std::vector<uint8_t>>& packedData,
+                                                 const BatchDecryptOptions& options = BatchDecryptOptions());
+
+    // 用数据密钥并行加密整批数据，返回顺序与输入一致
+    std::vector<std::vector<uint8_t>> encryptBatch(const SecureKey& dataKey,
+                                                   const std::vector<std::vector<uint8_t>>& plaintexts,
+                                                   unsigned threads = 0);
+
+    // 旧格式：没有记录头、由主密码派生密钥的数据
+    static bool isLegacyFormat(const std::vector<uint8_t>& packedData);
+    static bool isLegacyFormat(const uint8_t* packedData, size_t packedSize);
+    // 旧格式以随机 salt 开头，约 1/32768 的旧数据恰好以版本 2/3 的记录头开头而被误认为新格式。
+    // 长度足够的数据都可能是旧格式：按记录头解密失败后应再按旧格式尝试
+    static bool mayBeLegacyFormat(const uint8_t* packedData, size_t packedSize);
+    // 是否为当前写入的版本；旧格式与版本 2 的数据需要重新加密转换
+    static bool isCurrentFormat(const uint8_t* packedData, size_t packedSize);
+    // 是否为当前版本且记录头的 key_id 与 dataKey 相符，不做解密；用于挑选需要迁移的条目
+    static bool isCurrentFormat(const SecureKey& dataKey, const uint8_t* packedData, size_t packedSize);
 
 private:
     void validateSodiumInit() const;
-};
\ No newline at end of file
+    bool seal(const SecureKey& dataKey, EntryRecord::Kind kind, const uint8_t* plaintext, size_t plaintextSize,
+              uint8_t* packedOut, size_t packedCapacity);
+    bool open(const SecureKey& dataKey, EntryRecord::Kind kind, const uint8_t* packedData, size_t packedSize,
+              uint8_t* plaintextOut, size_t plaintextCapacity);
+};
@@ -0,0 +1,91 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "CryptoModule.h"
+#include "PassWordVault.h"
+
+// RFC 4180 CSV 流式读取：逐条记录解析，支持引号内的逗号、换行和 "" 转义
+class CsvReader {
+public:
+    explicit CsvReader(std::istream& in);
+
+    // 读取下一条记录，文件结束时返回 false
+    bool ReadRecord(std::vector<std::string>& fields);
+    // 最近一条记录起始处的行号（从 1 开始）
+    size_t RecordLine() const { return recordLine_; }
+    uint64_t BytesRead() const { return bytesRead_; }
+
+private:
+    int Get();
+
+    std::istream& in_;
+    size_t line_ = 1;
+    size_t recordLine_ = 0;
+    uint64_t bytesRead_ = 0;
+};
+
+enum class CsvLayout { Unknown, Chrome, Firefox, KeePass, KeePassXC, Bitwarden, Generic };
+
+// 批量导入参数
+struct CsvImportOptions {
+    size_t batchSize = 1000;   // 每个事务提交的条目数
+    unsigned threads = 0;      // 加密线程数，0 表示使用全部硬件线程
+    // 每提交一批调用一次，返回 false 取消剩余导入（已提交的批次保留）
+    std::function<bool(uint64_t bytesRead, uint64_t totalBytes)> progress;
+};
+
+struct CsvRowError {
+    size_t line;
+    std::string message;
+};
+
+struct CsvImportReport {
+    CsvLayout layout = CsvLayout::Unknown;
+    size_t rowsRead = 0;
+    size_t imported = 0;
+    bool canceled = false;
+    std::vector<CsvRowError> errors;
+};
+
+// 从浏览器或密码管理器导出的 CSV 批量导入密码条目
+class CsvImporter {
+public:
+    CsvImporter(PasswordVault& vault, std::shared_ptr<SecureKey> dataKey);
+
+    CsvImportReport ImportFile(int codebook_id, const std::string& path,
+                               const CsvImportOptions& options = CsvImportOptions());
+    CsvImportReport Import(int codebook_id, std::istream& in, uint64_t totalBytes,
+                           const CsvImportOptions& options = CsvImportOptions());
+
+    static const char* LayoutName(CsvLayout layout);
+
+private:
+    struct ColumnMap {
+        int title = -1;
+        int url = -1;
+        int username = -1;
+        int password = -1;
+        int notes = -1;
+    };
+
+    struct PendingRow {
+        size_t line;
+        std::string address;
+        std::string notes;
+    };
+
+    static CsvLayout DetectLayout(const std::vector<std::string>& header, ColumnMap& columns);
+    static std::string Field(const std::vector<std::string>& fields, int column);
+    void CommitBatch(int codebook_id, std::vector<PendingRow>& rows,
+                     std::vector<std::vector<uint8_t>>& passwords,
+                     const CsvImportOptions& options, CsvImportReport& report);
+
+    PasswordVault& vault_;
+    std::shared_ptr<SecureKey> dataKey_;
+    CryptoModule crypto_;
+};
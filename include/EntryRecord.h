@@ -0,0 +1,76 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// 条目密文的记录格式（版本 3），多字节整数均为小端：
+//
+//   magic 0xA7 ‖ version 0x03 ‖ kind ‖ algorithm ‖ kdf ‖ key_id (u32)
+//   ‖ nonce 24 字节 ‖ ciphertext（末尾 16 字节认证标签）
+//
+// nonce 之前的 9 字节是记录头，作为 AEAD 附加数据参与认证，篡改任何字段都会导致解密失败。
+// algorithm 与 kdf 目前各只有一个取值，留给以后的格式扩展；未知取值的记录不会被解析。
+// key_id 标识加密所用的数据密钥（见 SecureKey::id），解密前即可判断密钥是否匹配。
+// 版本 2（magic ‖ 0x02 ‖ nonce ‖ secretbox 密文）与无头部的旧格式仍可读取，但不再写入。
+class EntryRecord {
+public:
+    enum class Kind : uint8_t {
+        Password = 1,   // 明文只有密码
+        Entry = 2,      // 明文为整条条目：地址、备注、密码
+    };
+    enum class Algorithm : uint8_t {
+        XChaCha20Poly1305 = 1,
+    };
+    enum class Kdf : uint8_t {
+        DataKey = 0,    // 由 key_id 指明的随机数据密钥，无需派生
+    };
+
+    static const uint8_t kMagic = 0xA7;
+    static const uint8_t kVersion = 0x03;
+    static const uint8_t kVersionSecretbox = 0x02;
+    static const size_t kHeaderBytes = 9;
+    static const size_t kNonceBytes = 24;
+    static const size_t kTagBytes = 16;
+
+    // 解析结果：指针都指向被解析的缓冲区，不复制任何字节，缓冲区释放后失效
+    struct View {
+        Kind kind = Kind::Password;
+        Algorithm algorithm = Algorithm::XChaCha20Poly1305;
+        Kdf kdf = Kdf::DataKey;
+        uint32_t keyId = 0;
+        const uint8_t* header = nullptr;      // 附加数据：记录起始到 nonce 之前
+        const uint8_t* nonce = nullptr;
+        const uint8_t* ciphertext = nullptr;  // 含认证标签
+        size_t ciphertextSize = 0;
+
+        size_t PlaintextSize() const { return ciphertextSize - kTagBytes; }
+    };
+
+    // 只检查结构与长度，不解密；不是版本 3、字段取值未知或长度不足时返回 false
+    static bool Parse(const uint8_t* data, size_t size, View& view);
+    // 只看前两个字节
+    static bool IsCurrent(const uint8_t* data, size_t size);
+
+    static size_t SealedSize(size_t plaintextSize);
+    // 写入记录头并返回其长度，nonce 紧随其后
+    static size_t WriteHeader(uint8_t* out, Kind kind, uint32_t keyId);
+
+    // Kind::Entry 的明文：地址、备注、密码依次排列，各自以 varint 长度开头
+    struct Field {
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+
+        std::string ToString() const { return std::string(reinterpret_cast<const char*>(data), size); }
+    };
+    struct Fields {
+        Field address;
+        Field notes;
+        Field password;
+    };
+
+    static size_t EncodedFieldsSize(size_t addressSize, size_t notesSize, size_t passwordSize);
+    // out 至少 EncodedFieldsSize 字节，返回写入的字节数
+    static size_t EncodeFields(uint8_t* out, const Field& address, const Field& notes, const Field& password);
+    // 同样不复制：fields 指向 data 内部；长度字段越界或有多余字节时返回 false
+    static bool ParseFields(const uint8_t* data, size_t size, Fields& fields);
+};
@@ -0,0 +1,35 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "AppConfig.h"
+#include "CryptoModule.h"
+
+// 口令派生的 Argon2id 成本。登录依次运行两次派生：校验 User.password_hash，再派生会话密钥；
+// 所用参数随结果一同保存（哈希字符串自带参数，会话密钥参数存入 User.kdf_params，
+// 备份参数写入文件头），修改配置后旧参数在下次登录时自动升级
+struct KdfProfile {
+    std::string name = "default";
+    KdfParams passwordHash = KdfParams::sensitive();   // 登录密码哈希
+    KdfParams sessionKey = KdfParams::moderate();      // 会话密钥与备份口令
+
+    // default：与旧版本相同，登录 SENSITIVE（1 GiB）+ 会话密钥 MODERATE（256 MiB）
+    static KdfProfile Default();
+    // moderate：两次派生都使用 MODERATE
+    static KdfProfile Moderate();
+    // interactive：小内存虚拟机，两次派生都使用 INTERACTIVE（64 MiB）
+    static KdfProfile Interactive();
+
+    static KdfProfile Named(const std::string& name);
+    static std::vector<std::string> Names();
+
+    // 读取 kdf.profile 选择基础配置，再用 kdf.hash_ops / kdf.hash_mem_kib /
+    // kdf.key_ops / kdf.key_mem_kib 单项覆盖；非法取值抛出 invalid_argument
+    static KdfProfile FromConfig(const AppConfig& config);
+
+    // 测量本机，两次派生使用相同参数、各自接近 targetMs，内存不超过 memoryCap
+    static KdfProfile Calibrate(unsigned targetMs, size_t memoryCap);
+    // 输出可追加到配置文件的 kdf.* 配置行
+    std::string ToConfig() const;
+
+    void Validate() const;
+};
@@ -0,0 +1,55 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include "CryptoModule.h"
+#include "PassWordVault.h"
+#include "SessionKeyring.h"
+
+// 密钥轮换参数
+struct RotationOptions {
+    int batchSize = 256;    // 每个检查点提交的条目数
+    unsigned threads = 0;   // 解密与加密的工作线程数，0 表示使用全部硬件线程
+    // 每提交一批调用一次，返回 false 在检查点处停止，之后可再次 Resume
+    std::function<bool(uint64_t done, uint64_t total)> progress;
+};
+
+struct RotationReport {
+    size_t reencrypted = 0;
+    size_t alreadyRotated = 0;   // 轮换期间已用新数据密钥写入的条目
+    size_t undecryptable = 0;    // 新旧数据密钥都无法解密，保持原样
+    bool canceled = false;
+    bool finished = false;       // 所有密码本都已完成，旧数据密钥已清除
+};
+
+// 修改主密码并轮换所有密码本的数据密钥。
+// ChangeMasterPassword 在一个事务内切换主密码：新的密码哈希与密钥盐、每个密码本新的数据密钥，
+// 旧数据密钥改由新会话密钥包裹保留；之后 Resume 在后台按批重新加密条目，
+// 每批与检查点在同一事务内提交，崩溃或取消后再次调用 Resume 即从检查点继续。
+// 轮换完成前，密钥环解密失败时会回退到旧数据密钥，期间密码本可照常读写。
+class KeyRotation {
+public:
+    KeyRotation(PasswordVault& vault, std::shared_ptr<SessionKeyring> keyring);
+
+    // 旧主密码不正确时返回 false；新密码不满足复杂度要求时抛出 invalid_argument。
+    // 仍由旧主密码加密的旧格式条目先迁移到数据密钥，否则切换后将无法解密。
+    // 成功后密钥环切换到新的会话密钥
+    bool ChangeMasterPassword(const std::string& username,
+                              const std::string& oldPassword,
+                              const std::string& newPassword);
+
+    // 是否有尚未完成重新加密的密码本
+    bool Pending(const std::string& username);
+
+    // 从检查点继续重新加密
+    RotationReport Resume(const std::string& username, const RotationOptions& options = RotationOptions());
+
+private:
+    void MigrateLegacyEntries(int codebook_id, const SecureKey& codebookKey);
+
+    PasswordVault& vault_;
+    std::shared_ptr<SessionKeyring> keyring_;
+    CryptoModule crypto_;
+};
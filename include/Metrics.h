@@ -0,0 +1,85 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 进程内的计时跨度与计数器。每个线程只写自己的直方图（不加锁，只有 relaxed 原子读写），
+// 导出时加锁汇总全部线程；线程退出时其数据并入全局累计。
+// 插桩点使用下方的 PASSMGR_SPAN / PASSMGR_COUNT 宏：未定义 PASSMGR_ENABLE_METRICS 时宏展开为空语句，
+// 热路径上不留下任何代码，导出接口照常可用但没有数据。
+class Metrics {
+public:
+    enum class Kind { Span, Counter };
+
+    // 跨度按纳秒的二进制数量级分桶：桶 i 统计 [2^(i-1), 2^i) 纳秒，最后一桶兼收更长的跨度
+    static const size_t kBuckets = 40;
+    // 插桩点总数上限；超出后新注册的指标不再记录
+    static const size_t kMaxSeries = 128;
+
+    struct Series {
+        std::string name;
+        Kind kind = Kind::Counter;
+        uint64_t count = 0;             // 跨度次数；计数器为累加次数
+        uint64_t sum = 0;               // 跨度为纳秒总和，计数器为累加值
+        uint64_t max = 0;               // 最长跨度（纳秒）
+        std::vector<uint64_t> buckets;  // 仅跨度
+
+        // 由分桶估计分位数（取所在桶的上界），单位纳秒
+        uint64_t Quantile(double q) const;
+    };
+
+    // 注册指标并返回编号，同名返回同一编号；宏在每个插桩点只注册一次
+    static int Register(const char* name, Kind kind);
+    static void RecordSpan(int id, uint64_t nanos);
+    static void Add(int id, uint64_t value);
+
+    // 汇总所有线程的数据，按名称排序
+    static std::vector<Series> Snapshot();
+    static void Reset();
+
+    static std::string ToJson(const std::vector<Series>& series);
+    static std::string ToPrometheus(const std::vector<Series>& series);
+    // 扩展名为 .json 时写 JSON，否则写 Prometheus 文本格式；写入失败时抛出异常
+    static void WriteFile(const std::string& path);
+
+    // 编译时是否启用了插桩
+    static bool Enabled();
+
+    // 析构时记录从构造起经过的时间
+    class ScopedSpan {
+    public:
+        explicit ScopedSpan(int id) : id_(id), start_(std::chrono::steady_clock::now()) {}
+        ~ScopedSpan() {
+            const auto elapsed = std::chrono::steady_clock::now() - start_;
+            RecordSpan(id_, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+        }
+        ScopedSpan(const ScopedSpan&) = delete;
+        ScopedSpan& operator=(const ScopedSpan&) = delete;
+
+    private:
+        int id_;
+        std::chrono::steady_clock::time_point start_;
+    };
+};
+
+#define PASSMGR_METRICS_CONCAT_(a, b) a##b
+#define PASSMGR_METRICS_CONCAT(a, b) PASSMGR_METRICS_CONCAT_(a, b)
+
+#ifdef PASSMGR_ENABLE_METRICS
+// 计时到当前作用域结束
+#define PASSMGR_SPAN(name)                                                                              \
+    static const int PASSMGR_METRICS_CONCAT(passmgrSpanId_, __LINE__) =                                 \
+        Metrics::Register(name, Metrics::Kind::Span);                                                   \
+    Metrics::ScopedSpan PASSMGR_METRICS_CONCAT(passmgrSpan_, __LINE__)(PASSMGR_METRICS_CONCAT(passmgrSpanId_, __LINE__))
+#define PASSMGR_COUNT(name, value)                                                                      \
+    do {                                                                                                \
+        static const int passmgrCounterId = Metrics::Register(name, Metrics::Kind::Counter);            \
+        Metrics::Add(passmgrCounterId, static_cast<uint64_t>(value));                                   \
+    } while (0)
+#else
+#define PASSMGR_SPAN(name) ((void)0)
+#define PASSMGR_COUNT(name, value) ((void)0)
+#endif
@@ -1,17 +1,84 @@
 #pragma once
 #include <string>
+#include <vector>
 #include <cstddef>
 
+// 字符类别，可按位组合
+enum CharClass : unsigned {
+    Uppercase = 1,
+    Lowercase = 2,
+    Digits = 4,
+    Symbols = 8,
+};
+
+// 字符集策略
+struct CharsetPolicy {
+    unsigned classes;        // 可用的字符类别
+    unsigned required;       // 每个密码至少包含一个字符的类别
+    bool excludeAmbiguous;   // 排除 0/O、1/l/I、| 等易混淆字符
+};
+
+constexpr CharsetPolicy kBasicPolicy = {Uppercase | Lowercase | Digits, 0, false};
+constexpr CharsetPolicy kExtendedPolicy = {Uppercase | Lowercase | Digits | Symbols, 0, false};
+// 满足条目密码规则（必须包含大小写字母和数字），并去掉易混淆字符
+constexpr CharsetPolicy kStrongPolicy = {Uppercase | Lowercase | Digits | Symbols,
+                                         Uppercase | Lowercase | Digits, true};
+
+// 按策略展开的字符表；用 constexpr 策略构造时在编译期完成
+class Charset {
+public:
+    constexpr explicit Charset(const CharsetPolicy& policy) : policy_(policy) {
+        if (policy.classes & Uppercase) append("ABCDEFGHIJKLMNOPQRSTUVWXYZ", Uppercase);
+        if (policy.classes & Lowercase) append("abcdefghijklmnopqrstuvwxyz", Lowercase);
+        if (policy.classes & Digits) append("0123456789", Digits);
+        if (policy.classes & Symbols) append("!@#$%^&*()-_=+[]{}|;:,.<>?", Symbols);
+    }
+
+    constexpr size_t size() const { return size_; }
+    constexpr char at(size_t index) const { return chars_[index]; }
+    constexpr unsigned classAt(size_t index) const { return classes_[index]; }
+    constexpr const CharsetPolicy& policy() const { return policy_; }
+
+private:
+    static constexpr size_t kMaxChars = 26 + 26 + 10 + 26;
+
+    constexpr void append(const char* chars, unsigned charClass) {
+        for (; *chars; ++chars) {
+            if (policy_.excludeAmbiguous && isAmbiguous(*chars)) continue;
+            chars_[size_] = *chars;
+            classes_[size_] = static_cast<unsigned char>(charClass);
+            ++size_;
+        }
+    }
+
+    static constexpr bool isAmbiguous(char c) {
+        for (const char* p = "0O1lI|"; *p; ++p) {
+            if (*p == c) return true;
+        }
+        return false;
+    }
+
+    CharsetPolicy policy_;
+    char chars_[kMaxChars] = {};
+    unsigned char classes_[kMaxChars] = {};
+    size_t size_ = 0;
+};
+
 class PasswordGenerator {
 public:
     explicit PasswordGenerator(size_t length = 12);
-    
+
     std::string generateBasic() const;    // 仅字母数字
     std::string generateExtended() const; // 包含特殊字符
+    std::string generate(const Charset& charset) const;
+
+    // 一次生成 count 个密码：整批共用一次大块 randombytes_buf，
+    // 拒绝采样保证字符分布均匀，不满足必需类别的密码整体重新生成
+    std::vector<std::string> generateBatch(size_t count, const Charset& charset) const;
+
+    size_t length() const { return length_; }
+    void setLength(size_t length) { length_ = length; }
 
 private:
     size_t length_;
-    
-    static const std::string basic_charset;     // 大小写字母+数字
-    static const std::string extended_charset;  // 原字符集
-};
\ No newline at end of file
+};
@@ -3,6 +3,11 @@
 #include <vector>
 #include <string>
 #include <cstdint>
+#include <utility>
+#include <memory>
+#include <functional>
+#include "StatementCache.h"
+#include "ChangeBus.h"
 
 class PasswordVault {
 public:
@@ -10,26 +15,120 @@ public:
         int id;
         std::string name;
         std::string created_time;
+        int64_t updated_seq = 0;   // 密码本或其中任一条目最后一次变更的序号
+        // 以下由条目触发器维护，读取时不扫描条目表
+        int entry_count = 0;
+        int64_t total_bytes = 0;      // 条目地址、密文与备注的总字节数
+        std::string modified_time;    // 最后一次增删改条目的时间，没有改动过时为创建时间
     };
 
     struct PasswordEntry {
         int id;
         std::string address;
-        std::string public_key;
-        std::vector<uint8_t> encrypted_password;
+        std::vector<uint8_t> encrypted_password;   // EntryRecord 记录，旧数据可能为版本 2 或无头部的旧格式
         std::string notes;
         std::string created_time;
     };
 
+    struct EntryPage {
+        std::vector<PasswordEntry> entries;
+        int next_after_id = 0;
+        bool has_more = false;
+    };
+
+    // 自某个变更序号以来新增或修改的条目（只含元数据，按 entry_id 排列）与被删除的条目
+    struct ChangeSet {
+        std::vector<PasswordEntry> changed;
+        std::vector<int> deleted;
+        int64_t seq = 0;   // 结果覆盖到的变更序号，下次以它为起点
+        bool complete = true;   // false 时起点过旧、对应的墓碑已被清理，调用方需要重新加载
+    };
+
+    // 只读取密文时的分页位置
+    struct BlobPage {
+        int next_after_id = 0;
+        bool has_more = false;
+    };
+    // blob 直接指向 sqlite3_column_blob，只在回调期间有效
+    using BlobVisitor = std::function<void(int entry_id, const uint8_t* blob, size_t size)>;
+
+    // 密码审计：条目密文及 AuditCache 中缓存的上次审计结果
+    struct AuditRecord {
+        int entry_id = 0;
+        int codebook_id = 0;
+        std::string address;
+        std::vector<uint8_t> encrypted_password;
+        bool cached = false;                  // AuditCache 中是否有该条目
+        std::vector<uint8_t> blob_hash;       // 写入缓存时密文的摘要
+        std::vector<uint8_t> key_tag;         // 封装审计结果所用审计密钥的标识
+        std::vector<uint8_t> breach_tag;      // 检查时所用泄露库的标识，未检查时为空
+        // 以审计密钥封装的审计结果（明文摘要与是否已泄露），由 PasswordAuditor 封装与解开
+        std::vector<uint8_t> sealed_result;
+    };
+
+    struct AuditPage {
+        std::vector<AuditRecord> records;
+        int next_after_id = 0;
+        bool has_more = false;
+    };
+
+    // 主密码修改：每个密码本新的数据密钥，以及轮换完成前仍需用来解密的旧数据密钥，均由新会话密钥包裹
+    struct CodebookRotation {
+        int codebook_id = 0;
+        std::vector<uint8_t> wrapped_key;
+        std::vector<uint8_t> previous_wrapped_key;
+    };
+
+    // 尚未完成重新加密的密码本及其检查点
+    struct RotationCheckpoint {
+        int codebook_id = 0;
+        int last_entry_id = 0;   // 此前的条目均已用新数据密钥加密并提交
+        int remaining = 0;       // 检查点之后的条目数
+    };
+
+    // 重新加密后的条目密文（密钥轮换与旧格式迁移）；previous 为读取时的密文，期间被其他窗口修改过的条目不会被覆盖
+    struct RotatedBlob {
+        int entry_id = 0;
+        std::vector<uint8_t> previous;
+        std::vector<uint8_t> encrypted_password;
+    };
+
     explicit PasswordVault(sqlite3* db);
     
     // 密码本操作
-    bool CreateCodebook(const std::string& username, const std::string& name);
+    // 以下均为单条语句：创建时返回新密码本（名称已存在时 id 为 -1），删除时返回是否删除了该密码本；
+    // created_time 为空时使用当前时间
+    Codebook CreateCodebook(const std::string& username, const std::string& name,
+                            const std::string& created_time = "");
     bool DeleteCodebook(int codebook_id);
     int GetCodebookId(const std::string& username, const std::string& codebookName);
     bool CheckCodebookExists(int codebook_id);
+    // 一次查询取得用户的全部密码本及其条目统计，按创建时间倒序
     std::vector<Codebook> GetUserCodebooks(const std::string& username) const;
 
+    // 密码本数据密钥（由会话密钥包裹后存储）
+    bool GetCodebookKey(int codebook_id, std::vector<uint8_t>& wrapped_key);
+    bool SetCodebookKey(int codebook_id, const std::vector<uint8_t>& wrapped_key);
+    // 密码本全部条目已转换到的密文格式版本（0 表示尚未检查），旧格式迁移完成后写入，之后不再扫描
+    int GetCodebookFormat(int codebook_id);
+    bool SetCodebookFormat(int codebook_id, int format_version);
+    // 用户是否还有未迁移到 format_version 的密码本；没有时旧格式条目已不存在，可以不再保留主密码
+    bool HasCodebooksBelowFormat(const std::string& username, int format_version);
+
+    // 密钥轮换：BeginKeyRotation 在一个事务内写入新的密码哈希、密钥盐与派生参数、替换所有密码本的包裹密钥
+    // 并建立检查点；之后按批提交重新加密的条目，检查点随同一事务推进，中断后可从检查点继续
+    void BeginKeyRotation(const std::string& username,
+                          const std::string& password_hash,
+                          const std::vector<uint8_t>& kdf_salt,
+                          const std::vector<uint8_t>& kdf_params,
+                          const std::vector<CodebookRotation>& codebooks);
+    bool GetPreviousCodebookKey(int codebook_id, std::vector<uint8_t>& wrapped_key);
+    std::vector<RotationCheckpoint> GetRotationCheckpoints(const std::string& username);
+    // 返回实际写入的条目数
+    size_t CommitRotationBatch(int codebook_id, const std::vector<RotatedBlob>& blobs, int last_entry_id);
+    // 清除旧数据密钥并删除检查点
+    bool CompleteCodebookRotation(int codebook_id);
+
     // 密码条目操作
     bool AddEntry(int codebook_id, 
                 const std::string& address,
@@ -37,20 +136,58 @@ public:
                 const std::string& notes = "");
     bool UpdateEntry(int entry_id,
                    const std::string& new_address,
-                   const std::string& new_public_key,
-                   const std::string& new_encrypted_password,
+                   const std::vector<uint8_t>& new_encrypted_password,
                    const std::string& new_notes);
+    // 在一个事务内批量插入，返回每条是否插入成功；单条失败不影响其余条目。
+    // 条目的 created_time 非空时沿用（如从备份恢复），否则使用当前时间
+    std::vector<bool> AddEntries(int codebook_id, const std::vector<PasswordEntry>& entries);
+    // 在一个事务内替换条目密文，返回实际写入的条目数；期间已被修改（密文不再是 previous）的条目跳过
+    size_t UpdateEncryptedPasswords(const std::vector<RotatedBlob>& blobs);
     bool DeleteEntry(int entry_id);
-    std::vector<PasswordEntry> GetEntries(int codebook_id, 
-                                        const std::string& filter = "",
-                                        int page = 0,
-                                        int page_size = 50);
+    // 按地址或备注过滤，基于 entry_id 的键集分页：传入上一页的 next_after_id 获取下一页
+    EntryPage GetEntries(int codebook_id, 
+                         const std::string& filter = "",
+                         int after_id = 0,
+                         int page_size = 50);
+    // 只读取元数据（不含 encrypted_password），用于按需解密的列表展示
+    EntryPage GetEntrySummaries(int codebook_id,
+                                const std::string& filter = "",
+                                int after_id = 0,
+                                int page_size = 50);
+    // 全文搜索地址与备注（FTS5 trigram），地址命中优先、同等情况下新条目在前，返回至多 limit 条元数据；
+    // 不足 3 个字符的查询无法使用 trigram 索引，退回 LIKE 过滤
+    std::vector<PasswordEntry> Search(int codebook_id, const std::string& query, int limit = 200);
+    int CountEntries(int codebook_id, const std::string& filter = "");
+    bool GetEncryptedPassword(int entry_id, std::vector<uint8_t>& encrypted_password);
+    // 零拷贝读取密文：按 entry_id 分页把每行的 BLOB 原地交给 visit，不复制到 PasswordEntry
+    BlobPage VisitEntryBlobs(int codebook_id, const BlobVisitor& visit, int after_id = 0, int page_size = 256);
+    bool VisitEncryptedPassword(int entry_id, const BlobVisitor& visit);
+
+    // 在一个事务内执行 body 中的多次写入，body 返回 false 或抛出异常时全部回滚；返回是否已提交
+    bool RunInTransaction(const std::function<bool()>& body);
+
+    // 变更跟踪：写入提交后通过连接的 ChangeBus 发布最新序号
+    int64_t CurrentSeq();
+    ChangeSet GetChangesSince(int codebook_id, int64_t seq);
+
+    // 按 entry_id 分页读取密码本中的条目密文及其审计缓存
+    AuditPage GetAuditRecords(int codebook_id, int after_id = 0, int page_size = 256);
+    // 在一个事务内写入审计缓存；审计期间被删除的条目会被跳过
+    bool SaveAuditRecords(const std::vector<AuditRecord>& records);
 
 private:
     sqlite3* db_;
+    std::shared_ptr<StatementCache> statements_;
+    std::shared_ptr<ChangeBus> changes_;
+    int has_search_index_ = -1;   // -1 表示尚未检查
 
     bool BeginTransaction();
     bool CommitTransaction();
     bool RollbackTransaction();
+    void PublishChanges();
     bool ValidateCodebookName(const std::string& name);
+    void BindEntryQuery(sqlite3_stmt* stmt, int codebook_id, const std::string& filter,
+                        int after_id, int page_size);
+    bool HasSearchIndex();
+    static std::string EscapeLikePattern(const std::string& text);
 };
\ No newline at end of file
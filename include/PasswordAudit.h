@@ -0,0 +1,71 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "BreachStore.h"
+#include "PassWordVault.h"
+#include "PasswordStrength.h"
+#include "SessionKeyring.h"
+
+// 密码本审计参数
+struct AuditOptions {
+    int pageSize = 256;   // 每次读取并解密的条目数
+    int minScore = 3;     // 强度低于该分数的条目计为弱密码
+    // 每处理完一页调用一次，返回 false 取消剩余审计
+    std::function<bool(uint64_t done, uint64_t total)> progress;
+};
+
+struct WeakPassword {
+    int entryId;
+    std::string address;
+    int score;
+    double entropyBits;
+    std::string warning;
+};
+
+struct StrengthAuditReport {
+    size_t audited = 0;
+    size_t undecryptable = 0;
+    bool canceled = false;
+    std::vector<WeakPassword> weak;   // 按强度从弱到强排列
+};
+
+struct AuditedEntry {
+    int entryId;
+    int codebookId;
+    std::string address;
+};
+
+struct ReuseAuditReport {
+    size_t audited = 0;
+    size_t decrypted = 0;        // 缓存失效、本次重新解密的条目数
+    size_t undecryptable = 0;
+    bool canceled = false;
+    bool breachChecked = false;  // 是否提供了泄露库
+    std::vector<std::vector<AuditedEntry>> reused;   // 使用同一密码的条目组，大组在前
+    std::vector<AuditedEntry> breached;              // 出现在泄露库中的条目
+};
+
+// 逐页解密整个密码本并估计每个密码的强度；明文用完立即清零
+class PasswordAuditor {
+public:
+    PasswordAuditor(PasswordVault& vault, std::shared_ptr<SessionKeyring> keyring,
+                    std::shared_ptr<const PasswordDictionary> dictionary = PasswordDictionary::Default());
+
+    // 条目的地址和备注作为用户相关词参与估计：包含站点名的密码会被判为弱密码
+    StrengthAuditReport AuditStrength(int codebook_id, const AuditOptions& options = AuditOptions());
+
+    // 检查用户所有密码本中的重复密码，并在提供泄露库时检查已泄露的密码。
+    // 每个密码以审计密钥做带密钥的 BLAKE2b 摘要后分组，摘要与检查结果以审计密钥封装后缓存在 AuditCache 中；
+    // 再次检查时只解密密文、审计密钥或泄露库有变化的条目。
+    ReuseAuditReport AuditReuse(const std::string& username, const BreachStore* breaches = nullptr,
+                                const AuditOptions& options = AuditOptions());
+
+private:
+    PasswordVault& vault_;
+    std::shared_ptr<SessionKeyring> keyring_;
+    StrengthEstimator estimator_;
+};
@@ -0,0 +1,47 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+
+// 弱密码字典：按常见程度排序的词表编译成紧凑 trie，字典文件可直接内存映射使用。
+//   "PMDT" ‖ u32 version ‖ u32 nodeCount ‖ u32 edgeCount ‖ u32 wordCount
+//   ‖ u32 firstEdge[nodeCount + 1] ‖ u32 rank[nodeCount] ‖ u32 edge[edgeCount]
+// 整数均为小端序。节点 i 的出边是 edge[firstEdge[i], firstEdge[i + 1])，按字符升序排列，
+// 每条边为 字符 << 24 | 子节点序号；rank 是以该节点结尾的单词排名（从 1 开始），0 表示不是单词结尾。
+class PasswordDictionary {
+public:
+    static const uint32_t kRoot = 0;
+    static const uint32_t kNoNode = 0xFFFFFFFF;
+
+    // 将词表编译为字典文件内容：单词转为小写，排名取第一次出现的位置
+    static std::vector<uint8_t> Compile(const std::vector<std::string>& words);
+    static void CompileFile(const std::vector<std::string>& words, const std::string& path);
+
+    // 映射并校验字典文件，格式错误时抛出 std::runtime_error
+    static std::shared_ptr<const PasswordDictionary> Open(const std::string& path);
+    static std::shared_ptr<const PasswordDictionary> FromBytes(std::vector<uint8_t> bytes);
+    // 工作目录下的 passmgr.dict；不存在或无法使用时退回内置的常见密码表
+    static std::shared_ptr<const PasswordDictionary> Default();
+
+    // 沿字符 label 前进一步，没有这条边时返回 kNoNode
+    uint32_t Child(uint32_t node, uint8_t label) const;
+    uint32_t Rank(uint32_t node) const;
+    size_t WordCount() const { return wordCount_; }
+
+private:
+    PasswordDictionary() = default;
+    void Attach(const uint8_t* data, size_t size);
+    uint32_t Load(const uint8_t* base, uint32_t index) const;
+
+    MappedFile file_;
+    std::vector<uint8_t> bytes_;
+    const uint8_t* firstEdge_ = nullptr;
+    const uint8_t* rank_ = nullptr;
+    const uint8_t* edges_ = nullptr;
+    uint32_t nodeCount_ = 0;
+    uint32_t edgeCount_ = 0;
+    uint32_t wordCount_ = 0;
+};
@@ -0,0 +1,55 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "PasswordDictionary.h"
+
+// 账户密码与条目密码共用的复杂度规则：8-32 位，必须包含大小写字母和数字（正则只编译一次）
+bool MeetsComplexityRule(const std::string& password);
+
+// 密码中识别出的一段模式
+struct StrengthMatch {
+    enum Pattern { Dictionary, UserInput, Spatial, Sequence, Repeat, Date, Bruteforce };
+
+    Pattern pattern;
+    size_t begin;             // 字节区间 [begin, end)
+    size_t end;
+    double guessesLog10;
+    uint32_t rank = 0;        // 字典排名，仅 Dictionary / UserInput
+    bool reversed = false;
+    bool l33t = false;
+};
+
+struct StrengthResult {
+    double guessesLog10 = 0;   // 估计的猜测次数（以 10 为底的对数）
+    double entropyBits = 0;    // 同一估计换算成比特
+    int score = 0;             // 0（极弱）到 4（强），阈值与 zxcvbn 相同
+    std::string warning;       // 最主要弱点的说明，score >= 3 时为空
+    std::vector<StrengthMatch> sequence;   // 猜测次数最少的分解
+};
+
+// zxcvbn 风格的强度估计：字典（含大小写变化、l33t 替换和倒序）、用户相关词、键盘相邻、
+// 连续字符、重复和日期等匹配器找出候选片段，再用动态规划求猜测次数最少的分解。
+// 只分析前 100 个字节，评分也只针对这部分，其余字节不计入。
+class StrengthEstimator {
+public:
+    explicit StrengthEstimator(std::shared_ptr<const PasswordDictionary> dictionary = PasswordDictionary::Default());
+
+    // userInputs：用户名、站点地址等与账户相关的文本，其中的单词出现在密码中时按最常见的词计
+    StrengthResult Estimate(const std::string& password,
+                            const std::vector<std::string>& userInputs = std::vector<std::string>()) const;
+
+    static const char* ScoreName(int score);
+
+private:
+    StrengthResult EstimatePrefix(const std::string& password, const std::vector<std::string>& userWords,
+                                  bool excludeAdditive) const;
+    void MatchDictionary(const std::string& password, const std::string& lower, bool reversed,
+                         std::vector<StrengthMatch>& matches) const;
+    void MatchRepeats(const std::string& password, const std::vector<std::string>& userWords,
+                      std::vector<StrengthMatch>& matches) const;
+
+    std::shared_ptr<const PasswordDictionary> dictionary_;
+};
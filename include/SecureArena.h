@@ -0,0 +1,64 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// 明文与密钥专用的锁定内存池。
+// 每次 sodium_malloc 都要 mmap 一段带保护页的区域、mlock 并 mprotect，单个 32 字节密钥也要占用数个页；
+// 内存池一次申请一块（chunk），按固定大小分成若干槽位，之后的申请与释放只是出入空闲链表。
+// 槽位释放时立即清零；超过最大槽位的申请退回单独的 sodium_malloc。
+// 保护页只在 chunk 两端，同一 chunk 内的越界写不会触发异常，调用方须按返回的容量使用。
+class SecureArena {
+public:
+    // 槽位大小依次为 32、64、128、256、512、1024、4096 字节
+    static const size_t kMinSlotBytes = 32;
+    static const size_t kMaxSlotBytes = 4096;
+    static const size_t kDefaultChunkBytes = 64 * 1024;
+
+    struct Stats {
+        size_t liveSlots = 0;        // 当前持有的槽位（含单独分配）
+        size_t peakLiveSlots = 0;
+        size_t liveBytes = 0;        // 当前持有槽位的总容量
+        size_t chunks = 0;
+        size_t reservedBytes = 0;    // 所有 chunk 与单独分配的锁定内存
+        size_t oversized = 0;        // 当前持有的单独分配
+        uint64_t acquired = 0;       // 累计申请次数
+        uint64_t chunkAllocations = 0;   // 累计 sodium_malloc 次数
+    };
+
+    explicit SecureArena(size_t chunkBytes = kDefaultChunkBytes);
+    // 仍被持有的槽位随 chunk 一同清零释放
+    ~SecureArena();
+    SecureArena(const SecureArena&) = delete;
+    SecureArena& operator=(const SecureArena&) = delete;
+
+    // 进程级内存池，SecureKey 与 SecureBuffer 默认从这里取槽位。
+    // 有意不析构：静态对象析构顺序不确定，进程退出时仍可能有密钥在使用
+    static SecureArena& Global();
+
+    // 返回至少 size 字节、内容全零的锁定内存，capacity 为实际可用的大小；分配失败时抛出 runtime_error
+    uint8_t* Acquire(size_t size, size_t& capacity);
+    // 清零后归还；capacity 必须是 Acquire 返回的值
+    void Release(uint8_t* slot, size_t capacity);
+
+    // 释放所有槽位都空闲的 chunk，返回释放的字节数
+    size_t Trim();
+
+    Stats GetStats() const;
+
+private:
+    struct Chunk {
+        uint8_t* data;
+        size_t slotBytes;
+    };
+
+    static size_t ClassIndex(size_t size);
+    void Refill(size_t classIndex);
+
+    const size_t chunkBytes_;
+    std::vector<Chunk> chunks_;
+    std::vector<std::vector<uint8_t*>> freeSlots_;   // 按槽位大小分组，后进先出
+    Stats stats_;
+    mutable std::mutex mutex_;
+};
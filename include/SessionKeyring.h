@@ -0,0 +1,70 @@
+#pragma once
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "CryptoModule.h"
+#include "KdfProfile.h"
+#include "PassWordVault.h"
+
+// 一次登录会话内的密钥环：持有会话密钥（KEK），并缓存已解包的密码本数据密钥。
+// 密钥轮换未完成的密码本同时缓存旧数据密钥，解密失败时回退到旧密钥
+class SessionKeyring {
+public:
+    SessionKeyring(std::shared_ptr<SecureKey> kek, const std::string& masterPassword,
+                   const KdfProfile& kdf = KdfProfile::Default());
+    ~SessionKeyring();
+    SessionKeyring(const SessionKeyring&) = delete;
+    SessionKeyring& operator=(const SessionKeyring&) = delete;
+
+    // 获取密码本数据密钥，首次使用时生成并以包裹形式保存到数据库
+    std::shared_ptr<SecureKey> GetCodebookKey(PasswordVault& vault, int codebook_id);
+    // 只查缓存，不访问数据库；尚未加载时返回空
+    std::shared_ptr<SecureKey> CachedCodebookKey(int codebook_id) const;
+    // 只解包已保存的密钥，不生成也不写入，可在只读连接上调用；尚未保存时返回空
+    std::shared_ptr<SecureKey> FindCodebookKey(PasswordVault& vault, int codebook_id);
+    // 轮换未完成时返回旧数据密钥，否则返回空
+    std::shared_ptr<SecureKey> GetPreviousCodebookKey(PasswordVault& vault, int codebook_id);
+    void ForgetCodebook(int codebook_id);
+    // 主密码修改提交后切换到新的会话密钥，并丢弃所有已缓存的数据密钥；
+    // 修改前旧格式条目已全部迁移，新主密码只保留校验值
+    void Rekey(std::shared_ptr<SecureKey> kek, const std::string& masterPassword);
+
+    // 按打包格式选择数据密钥或旧的主密码路径解密；带记录头却无法解密的数据再按旧格式尝试一次
+    std::vector<uint8_t> Decrypt(const SecureKey& codebookKey, const std::vector<uint8_t>& packedData);
+    // 解密到可复用的锁定内存缓冲区；数据密钥格式不复制输入、不分配堆内存，失败时返回 false
+    bool Decrypt(const SecureKey& codebookKey, const uint8_t* packedData, size_t packedSize, SecureBuffer& plaintext);
+    std::vector<BatchDecryptResult> DecryptBatch(const SecureKey& codebookKey,
+                                                 const std::vector<std::vector<uint8_t>>& packedData,
+                                                 const BatchDecryptOptions& options = BatchDecryptOptions());
+
+    // 密码审计用的 BLAKE2b 密钥：由会话密钥派生，同一主密码下保持不变
+    std::shared_ptr<SecureKey> DeriveAuditKey() const;
+
+    // 以常量时间比对主密码：比对由会话密钥派生的 BLAKE2b 校验值，不需要保留主密码本身
+    bool CheckMasterPassword(const std::string& password) const;
+    // 主密码只用于解密旧格式条目，放在锁定内存中；所有密码本都已迁移后调用此函数清零释放，
+    // 之后旧格式的解密一律失败
+    void DropMasterPassword();
+    // 登录时使用的派生参数，修改主密码与导出备份沿用
+    const KdfProfile& Kdf() const { return kdf_; }
+
+private:
+    std::shared_ptr<SecureKey> LoadCodebookKey(PasswordVault& vault, int codebook_id, bool create = true);
+    std::shared_ptr<SecureKey> PreviousKeyFor(const SecureKey& codebookKey) const;
+    // 共享引用：解密期间 Rekey 或 DropMasterPassword 不会清除仍在使用的缓冲区
+    std::shared_ptr<const SecureBuffer> LegacyPassword() const;
+    std::vector<uint8_t> PasswordTag(const SecureKey& kek, const std::string& password) const;
+
+    CryptoModule crypto_;
+    std::shared_ptr<SecureKey> kek_;
+    std::shared_ptr<const SecureBuffer> masterPassword_;   // 已释放时为空
+    std::vector<uint8_t> passwordTag_;
+    const KdfProfile kdf_;
+    std::map<int, std::shared_ptr<SecureKey>> codebookKeys_;
+    // 以当前数据密钥为键的旧数据密钥，随 codebookKeys_ 一同清除
+    std::map<const SecureKey*, std::shared_ptr<SecureKey>> previousKeys_;
+    mutable std::mutex mutex_;
+};
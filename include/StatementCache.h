@@ -0,0 +1,53 @@
+#pragma once
+#include <sqlite3.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// 每个连接一份的预编译语句缓存：按 SQL 文本缓存 sqlite3_stmt，
+// 重复调用时只需复位并重新绑定参数，不再重新解析 SQL。
+class StatementCache : public std::enable_shared_from_this<StatementCache> {
+public:
+    // 语句租约：析构时复位、清空绑定并归还缓存
+    class Statement {
+    public:
+        Statement(Statement&& other) noexcept;
+        ~Statement();
+        Statement(const Statement&) = delete;
+        Statement& operator=(const Statement&) = delete;
+        Statement& operator=(Statement&&) = delete;
+
+        sqlite3_stmt* get() const { return stmt_; }
+        operator sqlite3_stmt*() const { return stmt_; }
+
+    private:
+        friend class StatementCache;
+        Statement(std::shared_ptr<StatementCache> cache, std::string sql, sqlite3_stmt* stmt);
+
+        std::shared_ptr<StatementCache> cache_;
+        std::string sql_;
+        sqlite3_stmt* stmt_;
+    };
+
+    // 获取连接对应的缓存；关闭连接前必须调用 ReleaseConnection
+    static std::shared_ptr<StatementCache> ForConnection(sqlite3* db);
+    static void ReleaseConnection(sqlite3* db);
+
+    ~StatementCache();
+    StatementCache(const StatementCache&) = delete;
+    StatementCache& operator=(const StatementCache&) = delete;
+
+    Statement Prepare(const std::string& sql);
+    size_t IdleCount() const;
+
+private:
+    explicit StatementCache(sqlite3* db);
+    void Return(const std::string& sql, sqlite3_stmt* stmt);
+
+    sqlite3* db_;
+    mutable std::mutex mutex_;
+    // 同一 SQL 可能被多个线程同时租用，因此每个键保存一组空闲语句
+    std::unordered_map<std::string, std::vector<sqlite3_stmt*>> idle_;
+};
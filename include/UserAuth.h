@@ -3,31 +3,77 @@
 #include <string>
 #include <vector>
 #include <stdexcept>
+#include <cstdint>
+#include <memory>
+#include "StatementCache.h"
+#include "ConnectionProfile.h"
+#include "CryptoModule.h"
+#include "KdfProfile.h"
 
 class UserAuth {
 public:
-    struct CodebookInfo {
-        int id;
-        std::string name;
-        std::string created_time;
-    };
-
-    explicit UserAuth(const std::string& db_path = "UserAuth.db");
+    explicit UserAuth(const std::string& db_path = "UserAuth.db",
+                      const ConnectionProfile& profile = ConnectionProfile::Default(),
+                      const KdfProfile& kdf = KdfProfile::Default());
     ~UserAuth();
 
+    // 登录所需的已保存凭据
+    struct Credentials {
+        std::string passwordHash;
+        std::vector<uint8_t> kdfSalt;                  // 老用户尚未生成时为空
+        KdfParams kdfParams = KdfParams::moderate();   // 未记录参数的用户按旧版本的固定参数派生
+    };
+    // 登录的计算结果：校验与派生都已完成，只剩需要写回数据库的内容
+    struct LoginResult {
+        std::shared_ptr<SecureKey> sessionKey;
+        std::string newPasswordHash;                   // 哈希参数与当前配置不同时的新哈希
+        std::vector<uint8_t> newKdfSalt;               // 需要保存新的盐与派生参数时非空
+        std::shared_ptr<SecureKey> previousSessionKey; // 派生参数升级时用于解开已包裹的数据密钥
+    };
+
     bool Register(const std::string& username, const std::string& password);
-    bool Login(const std::string& username, const std::string& password, 
-              std::vector<CodebookInfo>& codebooks);
+    // 只校验密码；登录成功后若密码哈希的参数与当前配置不同，用当前参数重新哈希。
+    // 密码本列表由 PasswordVault::GetUserCodebooks 取得
+    bool Login(const std::string& username, const std::string& password);
+
+    // Register / Login / DeriveSessionKey 的分步版本，耗时的 Argon2 不必在写连接上运行：
+    // 凭据可在任意连接（包括只读连接）上读取，校验、哈希与派生只做计算，
+    // 最后由 CreateUser / CompleteLogin 在写连接上执行插入与更新。
+    void ValidateRegistration(const std::string& username, const std::string& password);
+    // 用户名已存在时返回 false
+    bool CreateUser(const std::string& username, const std::string& passwordHash);
+    static bool LoadCredentials(sqlite3* db, const std::string& username, Credentials& credentials);
+    bool VerifyPassword(const Credentials& credentials, const std::string& password, LoginResult& result) const;
+    void DeriveKeys(const Credentials& credentials, const std::string& password, LoginResult& result);
+    // 派生参数升级时在同一个保存点内重新包裹所有密码本的数据密钥，可在外层事务中调用
+    void CompleteLogin(const std::string& username, const LoginResult& result);
     
+    // 生成保存在 User.password_hash 中的 Argon2id 哈希字符串，参数编码在字符串内
+    static std::string HashPassword(const std::string& password,
+                                    const KdfParams& params = KdfParams::sensitive());
+
+    // 按 User.kdf_salt / kdf_params 派生会话密钥（KEK）。应在 Login 成功后调用；
+    // 保存的参数与当前配置不同时，换用新盐与新参数派生，并在一个事务内重新包裹所有密码本的数据密钥
+    std::shared_ptr<SecureKey> DeriveSessionKey(const std::string& username, const std::string& password);
+
+    const KdfProfile& GetKdfProfile() const { return kdf_; }
+
     sqlite3* GetDatabaseHandle() const { return db_; }
 
 private:
     sqlite3* db_;
+    std::shared_ptr<StatementCache> statements_;
+    KdfProfile kdf_;
+    CryptoModule crypto_;
 
     bool CreateTables();
+    bool MigrateSchema();
+    bool CreateChangeTracking();
+    bool CreateSearchIndex();
+    bool HasColumn(const std::string& table, const std::string& column);
     bool CheckUserExists(const std::string& username);
     bool ValidatePassword(const std::string& password);
-    std::string GenerateHash(const std::string& password);
-    bool GetUserHash(const std::string& username, std::string& stored_hash);
-    bool GetUserCodebooks(const std::string& username, std::vector<CodebookInfo>& codebooks);
+    void SaveKdfParams(const std::string& username, const std::vector<uint8_t>& salt);
+    void UpgradeKeyParams(const std::string& username, const SecureKey& oldKek, const SecureKey& newKek,
+                          const std::vector<uint8_t>& salt);
 };
\ No newline at end of file
@@ -0,0 +1,56 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "CryptoModule.h"
+#include "PassWordVault.h"
+#include "SessionKeyring.h"
+
+// 备份导出 / 恢复参数
+struct BackupOptions {
+    int pageSize = 256;   // 每次从数据库读取、解密或写入的条目数
+    // 导出时按条目数、恢复时按字节数汇报进度，返回 false 取消
+    std::function<bool(uint64_t done, uint64_t total)> progress;
+};
+
+struct BackupStats {
+    size_t codebooks = 0;
+    size_t entries = 0;
+    size_t skipped = 0;    // 导出时无法解密的条目
+    bool canceled = false;
+};
+
+// 流式加密备份：
+//   "PMBK" ‖ version ‖ salt ‖ Argon2id 参数 ‖ secretstream header ‖ { u32 length ‖ chunk }*
+// 备份口令按文件头记录的参数经 Argon2id 派生出 crypto_secretstream_xchacha20poly1305 密钥
+// （导出时使用当前登录配置的会话密钥参数；版本 1 的文件没有参数字段，按 MODERATE 读取），
+// 每个 chunk 内是若干条长度前缀的明文记录，最后一个 chunk 带 TAG_FINAL。
+// 读写都按页进行，内存占用与密码本大小无关。
+class VaultBackup {
+public:
+    VaultBackup(PasswordVault& vault, std::shared_ptr<SessionKeyring> keyring);
+
+    BackupStats ExportUser(const std::string& username, const std::string& path,
+                           const std::string& passphrase, const BackupOptions& options = BackupOptions());
+    BackupStats ExportCodebooks(const std::vector<PasswordVault::Codebook>& codebooks, const std::string& path,
+                                const std::string& passphrase, const BackupOptions& options = BackupOptions());
+
+    // 先完整校验一遍，再在一个事务内写入数据库：损坏或被截断的备份、以及写入过程中取消或出错，
+    // 都不会恢复任何条目；同名密码本会合并到已有的密码本中，恢复的条目保留备份中的创建时间
+    BackupStats Restore(const std::string& username, const std::string& path,
+                        const std::string& passphrase, const BackupOptions& options = BackupOptions());
+    BackupStats Verify(const std::string& path, const std::string& passphrase);
+
+private:
+    struct RestoreTarget;
+
+    BackupStats ReadBackup(const std::string& path, const SecureKey& key,
+                           RestoreTarget* target, const BackupOptions& options);
+
+    PasswordVault& vault_;
+    std::shared_ptr<SessionKeyring> keyring_;
+    CryptoModule crypto_;
+};
@@ -1,4 +1,8 @@
 #include "LoginWindow.h"
+#include "AppConfig.h"
+#include "ConnectionProfile.h"
+#include "KdfProfile.h"
+#include "Metrics.h"
 #include <QApplication>
 #include <QStyleFactory>
 #include <QFile>
@@ -20,11 +24,23 @@ int main(int argc, char *argv[])
     }
 
     try {
+        // 数据库连接与密钥派生参数，配置文件不存在时使用默认配置
+        const AppConfig config = AppConfig::Load("passmgr.conf");
+        const ConnectionProfile profile = ConnectionProfile::FromConfig(config);
+        const KdfProfile kdf = KdfProfile::FromConfig(config);
+
         // 初始化界面
-        LoginWindow loginWindow;
+        LoginWindow loginWindow(profile, kdf);
         loginWindow.show();
         
-        return app.exec();
+        const int status = app.exec();
+
+        // 配置了 metrics.file 时在退出前导出插桩指标
+        const std::string metricsFile = config.Get("metrics.file");
+        if (!metricsFile.empty()) {
+            Metrics::WriteFile(metricsFile);
+        }
+        return status;
         
     } catch (const std::exception& e) {
         QMessageBox::critical(nullptr, "致命错误", 
@@ -0,0 +1,77 @@
+#include "AppConfig.h"
+#include <fstream>
+#include <stdexcept>
+using namespace std;
+
+namespace {
+
+string Trim(const string& text) {
+    const size_t begin = text.find_first_not_of(" \t\r");
+    if (begin == string::npos) {
+        return string();
+    }
+    const size_t end = text.find_last_not_of(" \t\r");
+    return text.substr(begin, end - begin + 1);
+}
+
+} // namespace
+
+AppConfig AppConfig::Load(const string& path) {
+    ifstream in(path);
+    if (!in) {
+        return AppConfig();
+    }
+    return Parse(in);
+}
+
+AppConfig AppConfig::Parse(istream& in) {
+    AppConfig config;
+    string line;
+    int lineNumber = 0;
+    while (getline(in, line)) {
+        ++lineNumber;
+        line = Trim(line);
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        const size_t eq = line.find('=');
+        if (eq == string::npos || Trim(line.substr(0, eq)).empty()) {
+            throw invalid_argument("配置文件第 " + to_string(lineNumber) + " 行格式错误");
+        }
+        config.Set(Trim(line.substr(0, eq)), Trim(line.substr(eq + 1)));
+    }
+    return config;
+}
+
+bool AppConfig::Has(const string& key) const {
+    return values_.count(key) > 0;
+}
+
+string AppConfig::Get(const string& key, const string& fallback) const {
+    auto it = values_.find(key);
+    return it == values_.end() ? fallback : it->second;
+}
+
+long long AppConfig::GetInt(const string& key, long long fallback) const {
+    auto it = values_.find(key);
+    if (it == values_.end()) {
+        return fallback;
+    }
+
+    size_t used = 0;
+    long long value = 0;
+    try {
+        value = stoll(it->second, &used);
+    } catch (const exception&) {
+        used = 0;
+    }
+    if (used == 0 || used != it->second.size()) {
+        throw invalid_argument("配置项 " + key + " 必须是整数: " + it->second);
+    }
+    return value;
+}
+
+void AppConfig::Set(const string& key, const string& value) {
+    values_[key] = value;
+}
@@ -0,0 +1,280 @@
+#include "BreachStore.h"
+#include <sodium.h>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+using namespace std;
+
+namespace {
+
+const char kMagic[4] = {'P', 'M', 'B', 'R'};
+const uint32_t kVersion = 1;
+const size_t kBucketCount = 65536;
+const size_t kHeaderBytes = 16 + (kBucketCount + 1) * 8;
+const size_t kTagBytes = 16;
+
+uint64_t ReadU64(const uint8_t* p) {
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; --i) {
+        value = (value << 8) | p[i];
+    }
+    return value;
+}
+
+void AppendU32(vector<uint8_t>& out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+}
+
+void AppendU64(vector<uint8_t>& out, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+}
+
+size_t Prefix(const uint8_t* digest) {
+    return (static_cast<size_t>(digest[0]) << 8) | digest[1];
+}
+
+uint32_t Rotl(uint32_t value, int bits) {
+    return (value << bits) | (value >> (32 - bits));
+}
+
+// libsodium 不提供 SHA-1；这里只用于与公开泄露库的摘要比对，不用于任何保密用途
+void Sha1Block(uint32_t state[5], const uint8_t* block) {
+    uint32_t w[80];
+    for (int i = 0; i < 16; ++i) {
+        w[i] = (static_cast<uint32_t>(block[4 * i]) << 24) | (static_cast<uint32_t>(block[4 * i + 1]) << 16) |
+               (static_cast<uint32_t>(block[4 * i + 2]) << 8) | block[4 * i + 3];
+    }
+    for (int i = 16; i < 80; ++i) {
+        w[i] = Rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    }
+
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+    for (int i = 0; i < 80; ++i) {
+        uint32_t f, k;
+        if (i < 20) {
+            f = (b & c) | (~b & d);
+            k = 0x5A827999;
+        } else if (i < 40) {
+            f = b ^ c ^ d;
+            k = 0x6ED9EBA1;
+        } else if (i < 60) {
+            f = (b & c) | (b & d) | (c & d);
+            k = 0x8F1BBCDC;
+        } else {
+            f = b ^ c ^ d;
+            k = 0xCA62C1D6;
+        }
+        const uint32_t temp = Rotl(a, 5) + f + e + k + w[i];
+        e = d;
+        d = c;
+        c = Rotl(b, 30);
+        b = a;
+        a = temp;
+    }
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    sodium_memzero(w, sizeof(w));
+}
+
+} // namespace
+
+BreachStore::Digest BreachStore::Hash(const uint8_t* data, size_t length) {
+    uint32_t state[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+
+    size_t offset = 0;
+    for (; offset + 64 <= length; offset += 64) {
+        Sha1Block(state, data + offset);
+    }
+
+    // 末块：剩余字节 ‖ 0x80 ‖ 填充 ‖ 位长度（大端）
+    uint8_t tail[128] = {};
+    const size_t rest = length - offset;
+    if (rest > 0) {
+        memcpy(tail, data + offset, rest);
+    }
+    tail[rest] = 0x80;
+    const size_t tailBytes = rest + 9 <= 64 ? 64 : 128;
+    const uint64_t bits = static_cast<uint64_t>(length) * 8;
+    for (int i = 0; i < 8; ++i) {
+        tail[tailBytes - 1 - i] = static_cast<uint8_t>(bits >> (8 * i));
+    }
+    Sha1Block(state, tail);
+    if (tailBytes == 128) {
+        Sha1Block(state, tail + 64);
+    }
+    sodium_memzero(tail, sizeof(tail));
+
+    Digest digest;
+    for (int i = 0; i < 5; ++i) {
+        digest[4 * i] = static_cast<uint8_t>(state[i] >> 24);
+        digest[4 * i + 1] = static_cast<uint8_t>(state[i] >> 16);
+        digest[4 * i + 2] = static_cast<uint8_t>(state[i] >> 8);
+        digest[4 * i + 3] = static_cast<uint8_t>(state[i]);
+    }
+    return digest;
+}
+
+bool BreachStore::ParseHex(const char* hex, size_t length, Digest& digest) {
+    if (length != kDigestBytes * 2) {
+        return false;
+    }
+    auto nibble = [](char c) -> int {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    };
+    for (size_t i = 0; i < kDigestBytes; ++i) {
+        const int high = nibble(hex[2 * i]);
+        const int low = nibble(hex[2 * i + 1]);
+        if (high < 0 || low < 0) {
+            return false;
+        }
+        digest[i] = static_cast<uint8_t>((high << 4) | low);
+    }
+    return true;
+}
+
+shared_ptr<const BreachStore> BreachStore::Open(const string& path) {
+    shared_ptr<BreachStore> store(new BreachStore());
+    store->file_ = MappedFile(path);
+    const uint8_t* data = store->file_.Data();
+    const size_t size = store->file_.Size();
+
+    if (size < kHeaderBytes || memcmp(data, kMagic, sizeof(kMagic)) != 0) {
+        throw runtime_error("Invalid breach store: " + path);
+    }
+    if (static_cast<uint32_t>(ReadU64(data + 4)) != kVersion) {
+        throw runtime_error("Unsupported breach store version: " + path);
+    }
+
+    const uint64_t count = ReadU64(data + 8);
+    if (count > (size - kHeaderBytes) / kDigestBytes || kHeaderBytes + count * kDigestBytes != size) {
+        throw runtime_error("Truncated breach store: " + path);
+    }
+
+    // 前缀索引须从 0 单调递增到摘要总数，否则段内二分可能越界
+    const uint8_t* buckets = data + 16;
+    uint64_t previous = 0;
+    for (size_t i = 0; i <= kBucketCount; ++i) {
+        const uint64_t value = ReadU64(buckets + 8 * i);
+        if (value < previous || value > count || (i == 0 && value != 0)) {
+            throw runtime_error("Corrupt breach store index: " + path);
+        }
+        previous = value;
+    }
+    if (previous != count) {
+        throw runtime_error("Corrupt breach store index: " + path);
+    }
+
+    store->buckets_ = buckets;
+    store->digests_ = data + kHeaderBytes;
+    store->count_ = count;
+
+    // 标识取文件头、前缀索引与首尾摘要的 BLAKE2b，避免打开时扫描整个库
+    crypto_generichash_state state;
+    crypto_generichash_init(&state, nullptr, 0, kTagBytes);
+    crypto_generichash_update(&state, data, kHeaderBytes);
+    if (count > 0) {
+        crypto_generichash_update(&state, store->digests_, kDigestBytes);
+        crypto_generichash_update(&state, store->digests_ + (count - 1) * kDigestBytes, kDigestBytes);
+    }
+    store->tag_.resize(kTagBytes);
+    crypto_generichash_final(&state, store->tag_.data(), kTagBytes);
+    return store;
+}
+
+shared_ptr<const BreachStore> BreachStore::OpenDefault() {
+    const string path = "passmgr.breach";
+    if (!ifstream(path, ios::binary)) {
+        return nullptr;
+    }
+    return Open(path);
+}
+
+bool BreachStore::Contains(const Digest& digest) const {
+    const size_t prefix = Prefix(digest.data());
+    size_t low = static_cast<size_t>(ReadU64(buckets_ + 8 * prefix));
+    size_t high = static_cast<size_t>(ReadU64(buckets_ + 8 * (prefix + 1)));
+
+    while (low < high) {
+        const size_t mid = low + (high - low) / 2;
+        const int order = memcmp(digests_ + mid * kDigestBytes, digest.data(), kDigestBytes);
+        if (order == 0) {
+            return true;
+        }
+        if (order < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return false;
+}
+
+BreachStoreWriter::BreachStoreWriter(const string& path)
+    : out_(path, ios::binary | ios::trunc), buckets_(kBucketCount, 0) {
+    if (!out_) {
+        throw runtime_error("Cannot create breach store: " + path);
+    }
+    // 先写占位文件头，Finish 时回填
+    const vector<char> placeholder(kHeaderBytes, 0);
+    out_.write(placeholder.data(), placeholder.size());
+}
+
+void BreachStoreWriter::Add(const BreachStore::Digest& digest) {
+    if (count_ > 0) {
+        const int order = memcmp(digest.data(), last_.data(), BreachStore::kDigestBytes);
+        if (order == 0) {
+            return;
+        }
+        if (order < 0) {
+            throw invalid_argument("Breach digests must be added in ascending order");
+        }
+    }
+    out_.write(reinterpret_cast<const char*>(digest.data()), digest.size());
+    ++buckets_[Prefix(digest.data())];
+    last_ = digest;
+    ++count_;
+}
+
+uint64_t BreachStoreWriter::Finish() {
+    if (finished_) {
+        return count_;
+    }
+
+    vector<uint8_t> header(kMagic, kMagic + sizeof(kMagic));
+    AppendU32(header, kVersion);
+    AppendU64(header, count_);
+    uint64_t start = 0;
+    for (size_t i = 0; i < kBucketCount; ++i) {
+        AppendU64(header, start);
+        start += buckets_[i];
+    }
+    AppendU64(header, start);
+
+    out_.seekp(0);
+    out_.write(reinterpret_cast<const char*>(header.data()), header.size());
+    out_.close();
+    if (!out_) {
+        throw runtime_error("Failed to write breach store");
+    }
+    finished_ = true;
+    return count_;
+}
+
+uint64_t BreachStoreWriter::Write(vector<BreachStore::Digest> digests, const string& path) {
+    sort(digests.begin(), digests.end());
+    BreachStoreWriter writer(path);
+    for (const auto& digest : digests) {
+        writer.Add(digest);
+    }
+    return writer.Finish();
+}
@@ -0,0 +1,50 @@
+#include "ChangeBus.h"
+#include <stdexcept>
+#include <utility>
+using namespace std;
+
+namespace {
+mutex registryMutex;
+// 与 StatementCache 相同，注册表有意不析构
+map<sqlite3*, shared_ptr<ChangeBus>>& registry() {
+    static auto* buses = new map<sqlite3*, shared_ptr<ChangeBus>>();
+    return *buses;
+}
+}
+
+shared_ptr<ChangeBus> ChangeBus::ForConnection(sqlite3* db) {
+    if (!db) {
+        throw invalid_argument("Invalid database connection");
+    }
+
+    lock_guard<mutex> lock(registryMutex);
+    auto& bus = registry()[db];
+    if (!bus) {
+        bus.reset(new ChangeBus());
+    }
+    return bus;
+}
+
+void ChangeBus::ReleaseConnection(sqlite3* db) {
+    lock_guard<mutex> lock(registryMutex);
+    registry().erase(db);
+}
+
+int ChangeBus::Subscribe(Listener listener) {
+    lock_guard<mutex> lock(mutex_);
+    const int id = nextId_++;
+    listeners_.emplace(id, move(listener));
+    return id;
+}
+
+void ChangeBus::Unsubscribe(int id) {
+    lock_guard<mutex> lock(mutex_);
+    listeners_.erase(id);
+}
+
+void ChangeBus::Publish(int64_t seq) {
+    lock_guard<mutex> lock(mutex_);
+    for (auto& listener : listeners_) {
+        listener.second(seq);
+    }
+}
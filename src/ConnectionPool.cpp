@@ -0,0 +1,348 @@
+#include "ConnectionPool.h"
+#include <algorithm>
+#include <map>
+#include <stdexcept>
+#include "ChangeBus.h"
+#include "Metrics.h"
+#include "StatementCache.h"
+using namespace std;
+
+namespace {
+
+// 一次成组提交最多合并的写操作数，避免写事务过长
+const size_t kMaxGroupSize = 256;
+
+mutex registryMutex;
+// 与 StatementCache 相同，注册表有意不析构
+map<sqlite3*, shared_ptr<ConnectionPool>>& registry() {
+    static auto* pools = new map<sqlite3*, shared_ptr<ConnectionPool>>();
+    return *pools;
+}
+
+void Exec(sqlite3* db, const char* sql) {
+    char* errMsg = nullptr;
+    if (sqlite3_exec(db, sql, nullptr, nullptr, &errMsg) != SQLITE_OK) {
+        string error = errMsg ? errMsg : sqlite3_errmsg(db);
+        sqlite3_free(errMsg);
+        throw runtime_error(string(sql) + " failed: " + error);
+    }
+}
+
+// 只有 WAL 且非独占锁时读连接才能与写连接并发
+size_t UsableReaders(sqlite3* primary, const ConnectionProfile& profile) {
+    const char* path = sqlite3_db_filename(primary, "main");
+    if (!path || !*path || profile.lockingMode == "EXCLUSIVE") {
+        return 0;
+    }
+
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(primary, "PRAGMA journal_mode", -1, &stmt, nullptr) != SQLITE_OK) {
+        return 0;
+    }
+    const bool wal = sqlite3_step(stmt) == SQLITE_ROW &&
+                     string(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0))) == "wal";
+    sqlite3_finalize(stmt);
+    return wal ? static_cast<size_t>(profile.readers) : 0;
+}
+
+} // namespace
+
+ConnectionPool::ReadLease::ReadLease(ConnectionPool* pool, int index, sqlite3* db, PasswordVault* vault,
+                                     unique_lock<mutex> primaryLock)
+    : pool_(pool), index_(index), db_(db), vault_(vault), primaryLock_(move(primaryLock)) {
+}
+
+ConnectionPool::ReadLease::ReadLease(ReadLease&& other) noexcept
+    : pool_(other.pool_), index_(other.index_), db_(other.db_), vault_(other.vault_),
+      primaryLock_(move(other.primaryLock_)) {
+    other.pool_ = nullptr;
+}
+
+ConnectionPool::ReadLease::~ReadLease() {
+    if (pool_ && index_ >= 0) {
+        pool_->ReturnReader(index_);
+    }
+}
+
+shared_ptr<ConnectionPool> ConnectionPool::Attach(sqlite3* primary, const ConnectionProfile& profile) {
+    if (!primary) {
+        throw invalid_argument("Invalid database connection");
+    }
+
+    lock_guard<mutex> lock(registryMutex);
+    auto& pool = registry()[primary];
+    if (!pool) {
+        pool.reset(new ConnectionPool(primary, profile, UsableReaders(primary, profile)));
+    }
+    return pool;
+}
+
+shared_ptr<ConnectionPool> ConnectionPool::ForConnection(sqlite3* primary) {
+    ConnectionProfile profile;
+    profile.readers = 0;
+    return Attach(primary, profile);
+}
+
+void ConnectionPool::ReleaseConnection(sqlite3* primary) {
+    shared_ptr<ConnectionPool> pool;
+    {
+        lock_guard<mutex> lock(registryMutex);
+        auto found = registry().find(primary);
+        if (found == registry().end()) {
+            return;
+        }
+        pool = move(found->second);
+        registry().erase(found);
+    }
+    // 仍持有连接池的对象之后再读写都会抛出异常
+    pool->Shutdown();
+}
+
+ConnectionPool::ConnectionPool(sqlite3* primary, const ConnectionProfile& profile, size_t readers)
+    : primary_(primary),
+      path_(sqlite3_db_filename(primary, "main") ? sqlite3_db_filename(primary, "main") : ""),
+      profile_(profile),
+      maxReaders_(readers),
+      writerVault_(primary) {
+}
+
+ConnectionPool::~ConnectionPool() {
+    Shutdown();
+}
+
+void ConnectionPool::Shutdown() {
+    {
+        lock_guard<mutex> lock(writeMutex_);
+        stopping_ = true;
+    }
+    queued_.notify_all();
+    if (writer_.joinable()) {
+        writer_.join();
+    }
+
+    unique_lock<mutex> lock(readMutex_);
+    closed_ = true;
+    readerReturned_.wait(lock, [this] { return idleReaders_.size() == readers_.size(); });
+    for (auto& reader : readers_) {
+        reader.vault.reset();
+        StatementCache::ReleaseConnection(reader.db);
+        ChangeBus::ReleaseConnection(reader.db);
+        sqlite3_close_v2(reader.db);
+    }
+    readers_.clear();
+    idleReaders_.clear();
+}
+
+sqlite3* ConnectionPool::OpenReader() {
+    sqlite3* db = nullptr;
+    // 每个读连接同一时间只租给一个线程，不需要 SQLite 的连接级互斥
+    if (sqlite3_open_v2(path_.c_str(), &db, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, nullptr) != SQLITE_OK) {
+        string error = db ? sqlite3_errmsg(db) : "out of memory";
+        sqlite3_close_v2(db);
+        throw runtime_error("Opening read connection failed: " + error);
+    }
+    try {
+        profile_.ApplyReader(db);
+    } catch (...) {
+        sqlite3_close_v2(db);
+        throw;
+    }
+    return db;
+}
+
+ConnectionPool::ReadLease ConnectionPool::AcquireReader() {
+    unique_lock<mutex> lock(readMutex_);
+    if (closed_) {
+        throw runtime_error("Connection pool is closed");
+    }
+    if (maxReaders_ == 0) {
+        // 借用主连接：等写线程执行完当前任务，期间主连接上的事务都已提交或回滚
+        lock.unlock();
+        unique_lock<mutex> primaryLock(primaryMutex_);
+        lock_guard<mutex> statsLock(statsMutex_);
+        ++stats_.reads;
+        return ReadLease(this, -1, primary_, &writerVault_, move(primaryLock));
+    }
+
+    if (idleReaders_.empty() && readers_.size() < maxReaders_) {
+        // 打开连接较慢，但在锁内进行可保证不会超过上限
+        sqlite3* db = OpenReader();
+        readers_.push_back({db, unique_ptr<PasswordVault>(new PasswordVault(db))});
+        idleReaders_.push_back(static_cast<int>(readers_.size()) - 1);
+        lock_guard<mutex> statsLock(statsMutex_);
+        stats_.readers = readers_.size();
+    }
+    if (idleReaders_.empty()) {
+        {
+            lock_guard<mutex> statsLock(statsMutex_);
+            ++stats_.readWaits;
+        }
+        PASSMGR_SPAN("pool.reader_wait");
+        readerReturned_.wait(lock, [this] { return !idleReaders_.empty(); });
+    }
+
+    const int index = idleReaders_.back();
+    idleReaders_.pop_back();
+    {
+        lock_guard<mutex> statsLock(statsMutex_);
+        ++stats_.reads;
+    }
+    return ReadLease(this, index, readers_[index].db, readers_[index].vault.get());
+}
+
+void ConnectionPool::ReturnReader(int index) {
+    {
+        lock_guard<mutex> lock(readMutex_);
+        idleReaders_.push_back(index);
+    }
+    readerReturned_.notify_one();
+}
+
+void ConnectionPool::Enqueue(Job job) {
+    {
+        lock_guard<mutex> lock(writeMutex_);
+        if (stopping_) {
+            throw runtime_error("Connection pool is closed");
+        }
+        queue_.push_back(move(job));
+        if (!writer_.joinable()) {
+            writer_ = thread(&ConnectionPool::WriterLoop, this);
+        }
+
+        lock_guard<mutex> statsLock(statsMutex_);
+        stats_.peakQueueDepth = max(stats_.peakQueueDepth, queue_.size());
+    }
+    queued_.notify_one();
+}
+
+void ConnectionPool::WriterLoop() {
+    for (;;) {
+        vector<Job> group;
+        {
+            unique_lock<mutex> lock(writeMutex_);
+            queued_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+            if (queue_.empty()) {
+                return;
+            }
+            // 独占任务单独执行；否则取出队首连续的可合并写操作
+            if (!queue_.front().grouped) {
+                Job job = move(queue_.front());
+                queue_.pop_front();
+                lock.unlock();
+                RunExclusive(job);
+                continue;
+            }
+            while (!queue_.empty() && queue_.front().grouped && group.size() < kMaxGroupSize) {
+                group.push_back(move(queue_.front()));
+                queue_.pop_front();
+            }
+        }
+        RunGroup(group);
+    }
+}
+
+void ConnectionPool::RunGroup(vector<Job>& group) {
+    PASSMGR_SPAN("pool.group_commit");
+    PASSMGR_COUNT("pool.grouped_writes", group.size());
+    vector<exception_ptr> errors(group.size());
+    unique_lock<mutex> primaryLock(primaryMutex_);
+    try {
+        // IMMEDIATE 在事务开始时就取得写锁，不会在中途因锁升级失败而回滚整组
+        Exec(primary_, "BEGIN IMMEDIATE");
+    } catch (...) {
+        primaryLock.unlock();
+        for (auto& job : group) {
+            job.fail(current_exception());
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < group.size(); ++i) {
+        try {
+            Exec(primary_, "SAVEPOINT pool_write");
+            try {
+                group[i].run(writerVault_);
+            } catch (...) {
+                errors[i] = current_exception();
+                Exec(primary_, "ROLLBACK TO pool_write");
+            }
+            Exec(primary_, "RELEASE pool_write");
+        } catch (...) {
+            errors[i] = current_exception();
+        }
+    }
+
+    try {
+        Exec(primary_, "COMMIT");
+    } catch (...) {
+        const exception_ptr error = current_exception();
+        sqlite3_exec(primary_, "ROLLBACK", nullptr, nullptr, nullptr);
+        primaryLock.unlock();
+        for (auto& job : group) {
+            job.fail(error);
+        }
+        return;
+    }
+    // 变更序号在释放主连接前读取，通知订阅者放到锁外
+    int64_t seq = -1;
+    try {
+        seq = writerVault_.CurrentSeq();
+    } catch (const exception&) {
+        // 与通知失败相同，订阅者会在下一次提交时取得差量
+    }
+    primaryLock.unlock();
+
+    {
+        lock_guard<mutex> lock(statsMutex_);
+        stats_.groupedWrites += group.size();
+        ++stats_.groupCommits;
+        stats_.largestGroup = max(stats_.largestGroup, group.size());
+    }
+
+    // 提交后再兑现结果：调用方拿到结果时写入已对读连接可见
+    for (size_t i = 0; i < group.size(); ++i) {
+        if (errors[i]) {
+            group[i].fail(errors[i]);
+        } else {
+            group[i].complete();
+        }
+    }
+    Publish(seq);
+}
+
+void ConnectionPool::RunExclusive(Job& job) {
+    {
+        lock_guard<mutex> lock(statsMutex_);
+        ++stats_.exclusiveJobs;
+    }
+    unique_lock<mutex> primaryLock(primaryMutex_);
+    try {
+        job.run(writerVault_);
+    } catch (...) {
+        // 任务中途抛出时可能仍留有未结束的事务，避免影响之后的写操作
+        if (!sqlite3_get_autocommit(primary_)) {
+            sqlite3_exec(primary_, "ROLLBACK", nullptr, nullptr, nullptr);
+        }
+        primaryLock.unlock();
+        job.fail(current_exception());
+        return;
+    }
+    primaryLock.unlock();
+    job.complete();
+}
+
+void ConnectionPool::Publish(int64_t seq) {
+    if (seq < 0) {
+        return;
+    }
+    try {
+        ChangeBus::ForConnection(primary_)->Publish(seq);
+    } catch (const exception&) {
+        // 通知失败不影响已提交的写入，订阅者会在下一次提交时取得差量
+    }
+}
+
+ConnectionPool::Stats ConnectionPool::GetStats() const {
+    lock_guard<mutex> lock(statsMutex_);
+    return stats_;
+}
@@ -0,0 +1,137 @@
+#include "ConnectionProfile.h"
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+using namespace std;
+
+namespace {
+
+string Upper(string text) {
+    transform(text.begin(), text.end(), text.begin(),
+              [](unsigned char c) { return static_cast<char>(toupper(c)); });
+    return text;
+}
+
+// PRAGMA 取值直接拼入 SQL，只接受白名单中的关键字
+void CheckOneOf(const string& option, const string& value, initializer_list<const char*> allowed) {
+    for (const char* candidate : allowed) {
+        if (value == candidate) {
+            return;
+        }
+    }
+    throw invalid_argument("不支持的数据库配置 " + option + " = " + value);
+}
+
+void Exec(sqlite3* db, const string& sql) {
+    char* errMsg = nullptr;
+    if (sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &errMsg) != SQLITE_OK) {
+        string error = errMsg ? errMsg : sqlite3_errmsg(db);
+        sqlite3_free(errMsg);
+        throw runtime_error("Failed to apply \"" + sql + "\": " + error);
+    }
+}
+
+} // namespace
+
+ConnectionProfile ConnectionProfile::Default() {
+    return ConnectionProfile();
+}
+
+ConnectionProfile ConnectionProfile::Network() {
+    ConnectionProfile profile;
+    profile.name = "network";
+    profile.lockingMode = "EXCLUSIVE";
+    profile.cacheSizeKiB = 64 * 1024;
+    profile.mmapSize = 0;
+    profile.busyTimeoutMs = 15000;
+    profile.readers = 0;
+    return profile;
+}
+
+ConnectionProfile ConnectionProfile::Compat() {
+    ConnectionProfile profile;
+    profile.name = "compat";
+    profile.journalMode = "DELETE";
+    profile.synchronous = "FULL";
+    profile.tempStore = "DEFAULT";
+    profile.cacheSizeKiB = 2000;
+    profile.mmapSize = 0;
+    // 回滚日志模式下读事务会阻塞写入
+    profile.readers = 0;
+    return profile;
+}
+
+ConnectionProfile ConnectionProfile::Named(const string& name) {
+    if (name == "default") return Default();
+    if (name == "network") return Network();
+    if (name == "compat") return Compat();
+    throw invalid_argument("未知的数据库配置: " + name);
+}
+
+vector<string> ConnectionProfile::Names() {
+    return {"default", "network", "compat"};
+}
+
+ConnectionProfile ConnectionProfile::FromConfig(const AppConfig& config) {
+    ConnectionProfile profile = Named(config.Get("db.profile", "default"));
+    profile.journalMode = Upper(config.Get("db.journal_mode", profile.journalMode));
+    profile.synchronous = Upper(config.Get("db.synchronous", profile.synchronous));
+    profile.lockingMode = Upper(config.Get("db.locking_mode", profile.lockingMode));
+    profile.tempStore = Upper(config.Get("db.temp_store", profile.tempStore));
+    profile.cacheSizeKiB = config.GetInt("db.cache_size_kib", profile.cacheSizeKiB);
+    profile.mmapSize = config.GetInt("db.mmap_size", profile.mmapSize);
+    profile.busyTimeoutMs = static_cast<int>(config.GetInt("db.busy_timeout_ms", profile.busyTimeoutMs));
+    // 单独改成独占锁或非 WAL 模式而没有指定读连接数时，不再沿用基础配置的读连接
+    const int fallbackReaders = profile.SupportsReaders() ? profile.readers : 0;
+    profile.readers = static_cast<int>(config.GetInt("db.readers", fallbackReaders));
+    profile.Validate();
+    return profile;
+}
+
+void ConnectionProfile::Validate() const {
+    CheckOneOf("journal_mode", journalMode, {"WAL", "DELETE", "TRUNCATE", "PERSIST"});
+    CheckOneOf("synchronous", synchronous, {"OFF", "NORMAL", "FULL", "EXTRA"});
+    CheckOneOf("locking_mode", lockingMode, {"NORMAL", "EXCLUSIVE"});
+    CheckOneOf("temp_store", tempStore, {"DEFAULT", "FILE", "MEMORY"});
+    if (cacheSizeKiB <= 0 || mmapSize < 0 || busyTimeoutMs < 0) {
+        throw invalid_argument("数据库配置 " + name + " 的数值项不能为负");
+    }
+    if (readers < 0 || readers > 64) {
+        throw invalid_argument("数据库配置 " + name + " 的读连接数须在 0-64 之间");
+    }
+    if (readers > 0 && !SupportsReaders()) {
+        throw invalid_argument("数据库配置 " + name + " 使用 locking_mode = " + lockingMode +
+                               "、journal_mode = " + journalMode + "，无法开启只读连接，db.readers 须为 0");
+    }
+}
+
+bool ConnectionProfile::SupportsReaders() const {
+    // 只读连接需要与写入并发：独占锁会挡住其他连接，回滚日志模式下读事务会阻塞写入
+    return journalMode == "WAL" && lockingMode == "NORMAL";
+}
+
+void ConnectionProfile::Apply(sqlite3* db) const {
+    Validate();
+    sqlite3_busy_timeout(db, busyTimeoutMs);
+
+    // locking_mode 必须在切换到 WAL 之前设置，独占模式下 WAL 索引放在进程内存中
+    Exec(db, "PRAGMA locking_mode = " + lockingMode);
+    // 内存数据库等不支持 WAL 时 SQLite 会保留原模式，这里不视为错误
+    Exec(db, "PRAGMA journal_mode = " + journalMode);
+    Exec(db, "PRAGMA synchronous = " + synchronous);
+    // 负数表示以 KiB 为单位
+    Exec(db, "PRAGMA cache_size = -" + to_string(cacheSizeKiB));
+    Exec(db, "PRAGMA mmap_size = " + to_string(mmapSize));
+    Exec(db, "PRAGMA temp_store = " + tempStore);
+    Exec(db, "PRAGMA foreign_keys = ON");
+}
+
+void ConnectionProfile::ApplyReader(sqlite3* db) const {
+    Validate();
+    sqlite3_busy_timeout(db, busyTimeoutMs);
+
+    Exec(db, "PRAGMA cache_size = -" + to_string(cacheSizeKiB));
+    Exec(db, "PRAGMA mmap_size = " + to_string(mmapSize));
+    Exec(db, "PRAGMA temp_store = " + tempStore);
+    Exec(db, "PRAGMA query_only = ON");
+}
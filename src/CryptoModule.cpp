@@ -1,97 +1,684 @@
 #include "CryptoModule.h"
+#include "Metrics.h"
 #include <sodium.h>
 #include <vector>
 #include <stdexcept>
 #include <iterator>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
 
-CryptoModule::CryptoModule() {
-    if (sodium_init() < 0) {
-        throw std::runtime_error("Libsodium initialization failed");
+static_assert(SecureKey::kKeyBytes == crypto_secretbox_KEYBYTES, "SecureKey size must match secretbox key size");
+static_assert(SecureKey::kKeyBytes == crypto_aead_xchacha20poly1305_ietf_KEYBYTES, "SecureKey size must match AEAD key size");
+static_assert(EntryRecord::kNonceBytes == crypto_aead_xchacha20poly1305_ietf_NPUBBYTES, "Record nonce size mismatch");
+static_assert(EntryRecord::kTagBytes == crypto_aead_xchacha20poly1305_ietf_ABYTES, "Record tag size mismatch");
+
+namespace {
+// Version 2 packed format: magic ‖ 0x02 ‖ nonce ‖ secretbox ciphertext. Still
+// read, never written; new data uses EntryRecord version 3.
+// Legacy blobs have no header and start with a random Argon2 salt.
+const size_t kPackedHeaderBytes = 2;
+const size_t kSecretboxMinBytes = kPackedHeaderBytes + crypto_secretbox_NONCEBYTES + crypto_secretbox_MACBYTES;
+
+bool isSecretboxFormat(const uint8_t* packedData, size_t packedSize) {
+    return packedSize >= kPackedHeaderBytes &&
+           packedData[0] == EntryRecord::kMagic &&
+           packedData[1] == EntryRecord::kVersionSecretbox;
+}
+
+// Runs fn(unit) for every unit on a bounded set of worker threads.
+template <typename Fn>
+void runParallel(size_t units, unsigned threads, Fn fn) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = static_cast<unsigned>(std::min<size_t>(threads, units));
+
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+        for (size_t unit = next++; unit < units; unit = next++) {
+            fn(unit);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned i = 1; i < threads; ++i) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : pool) {
+        thread.join();
     }
 }
 
-std::vector<uint8_t> CryptoModule::encrypt(const std::string& masterPassword, const std::vector<uint8_t>& plaintext) {
-    // Generate random salt
-    std::vector<uint8_t> salt(crypto_pwhash_SALTBYTES);
-    randombytes_buf(salt.data(), salt.size());
+// Counting semaphore bounding how many Argon2 derivations run at once.
+class KdfSlots {
+public:
+    explicit KdfSlots(size_t slots) : free_(std::max<size_t>(1, slots)) {}
 
-    // Derive key using Argon2id
-    std::vector<uint8_t> key(crypto_secretbox_KEYBYTES);
-    if (crypto_pwhash(
+    void acquire() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        available_.wait(lock, [this] { return free_ > 0; });
+        --free_;
+    }
+
+    void release() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++free_;
+        }
+        available_.notify_one();
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable available_;
+    size_t free_;
+};
+
+const size_t kLegacyMinBytes = crypto_pwhash_SALTBYTES + crypto_secretbox_NONCEBYTES + crypto_secretbox_MACBYTES;
+
+// Argon2id MODERATE over the blob's salt; the key stays in locked memory.
+bool deriveLegacyKey(PasswordView masterPassword, const uint8_t* salt, SecureKey& key) {
+    PASSMGR_SPAN("crypto.kdf.legacy");
+    return crypto_pwhash(
         key.data(), key.size(),
-        masterPassword.c_str(), masterPassword.length(),
-        salt.data(),
+        reinterpret_cast<const char*>(masterPassword.data), masterPassword.size,
+        salt,
         crypto_pwhash_OPSLIMIT_MODERATE,
         crypto_pwhash_MEMLIMIT_MODERATE,
-        crypto_pwhash_ALG_DEFAULT) != 0) {
-        throw std::runtime_error("Key derivation failed");
+        crypto_pwhash_ALG_DEFAULT) == 0;
+}
+
+bool openLegacy(const SecureKey& key, const std::vector<uint8_t>& packedData, std::vector<uint8_t>& plaintext) {
+    if (packedData.size() < kLegacyMinBytes) {
+        return false;
+    }
+
+    const uint8_t* nonce = packedData.data() + crypto_pwhash_SALTBYTES;
+    const uint8_t* ciphertext = nonce + crypto_secretbox_NONCEBYTES;
+    const size_t ciphertextSize = packedData.size() - crypto_pwhash_SALTBYTES - crypto_secretbox_NONCEBYTES;
+
+    plaintext.resize(ciphertextSize - crypto_secretbox_MACBYTES);
+    PASSMGR_SPAN("crypto.open.legacy");
+    return crypto_secretbox_open_easy(plaintext.data(), ciphertext, ciphertextSize, nonce, key.data()) == 0;
+}
+}
+
+SecureKey::SecureKey() : id_(0) {
+    // Keys fill a 32-byte arena slot exactly, so the capacity is always kKeyBytes.
+    size_t capacity = 0;
+    data_ = SecureArena::Global().Acquire(kKeyBytes, capacity);
+}
+
+uint32_t SecureKey::id() const {
+    const uint64_t cached = id_.load(std::memory_order_relaxed);
+    if (cached) {
+        return static_cast<uint32_t>(cached);
+    }
+
+    // Keyed BLAKE2b over a fixed label: a MAC of a constant reveals nothing
+    // about the key. Racing threads compute the same value, so a relaxed
+    // store is enough.
+    static const unsigned char label[] = "passmgr.key-id";
+    unsigned char digest[crypto_generichash_BYTES_MIN];
+    crypto_generichash(digest, sizeof(digest), label, sizeof(label) - 1, data_, kKeyBytes);
+    const uint32_t value = static_cast<uint32_t>(digest[0]) | static_cast<uint32_t>(digest[1]) << 8 |
+                           static_cast<uint32_t>(digest[2]) << 16 | static_cast<uint32_t>(digest[3]) << 24;
+    id_.store(uint64_t(1) << 32 | value, std::memory_order_relaxed);
+    return value;
+}
+
+SecureKey::~SecureKey() {
+    // The arena zeroes the slot before putting it back on the free list
+    SecureArena::Global().Release(data_, kKeyBytes);
+}
+
+SecureBuffer::SecureBuffer(size_t capacity) {
+    reserve(capacity);
+}
+
+SecureBuffer::~SecureBuffer() {
+    SecureArena::Global().Release(data_, capacity_);
+}
+
+void SecureBuffer::reserve(size_t capacity) {
+    if (capacity <= capacity_) {
+        return;
+    }
+    size_t grownCapacity = 0;
+    uint8_t* grown = SecureArena::Global().Acquire(capacity, grownCapacity);
+    // Contents are not carried over: the buffer only ever holds one plaintext.
+    SecureArena::Global().Release(data_, capacity_);
+    data_ = grown;
+    capacity_ = grownCapacity;
+    size_ = 0;
+}
+
+void SecureBuffer::resize(size_t size) {
+    reserve(size);
+    size_ = size;
+}
+
+void SecureBuffer::clear() {
+    if (data_) {
+        sodium_memzero(data_, capacity_);
     }
+    size_ = 0;
+}
+
+KdfParams KdfParams::interactive() {
+    return {crypto_pwhash_OPSLIMIT_INTERACTIVE, crypto_pwhash_MEMLIMIT_INTERACTIVE};
+}
+
+KdfParams KdfParams::moderate() {
+    return {crypto_pwhash_OPSLIMIT_MODERATE, crypto_pwhash_MEMLIMIT_MODERATE};
+}
+
+KdfParams KdfParams::sensitive() {
+    return {crypto_pwhash_OPSLIMIT_SENSITIVE, crypto_pwhash_MEMLIMIT_SENSITIVE};
+}
 
-    // Generate random nonce
-    std::vector<uint8_t> nonce(crypto_secretbox_NONCEBYTES);
-    randombytes_buf(nonce.data(), nonce.size());
+std::vector<uint8_t> KdfParams::encode() const {
+    validate();
+    const uint32_t ops = static_cast<uint32_t>(opsLimit);
+    const uint32_t memKiB = static_cast<uint32_t>(memLimit / 1024);
+    std::vector<uint8_t> out(kEncodedBytes);
+    for (int i = 0; i < 4; ++i) {
+        out[i] = static_cast<uint8_t>(ops >> (8 * i));
+        out[4 + i] = static_cast<uint8_t>(memKiB >> (8 * i));
+    }
+    return out;
+}
+
+KdfParams KdfParams::decode(const uint8_t* data, size_t size) {
+    if (size != kEncodedBytes) {
+        throw std::runtime_error("Invalid key derivation parameters");
+    }
+    uint32_t ops = 0;
+    uint32_t memKiB = 0;
+    for (int i = 0; i < 4; ++i) {
+        ops |= static_cast<uint32_t>(data[i]) << (8 * i);
+        memKiB |= static_cast<uint32_t>(data[4 + i]) << (8 * i);
+    }
+    KdfParams params{ops, static_cast<size_t>(memKiB) * 1024};
+    params.validate();
+    return params;
+}
+
+void KdfParams::validate() const {
+    // The encoding stores memory in KiB and both fields as u32
+    if (opsLimit < crypto_pwhash_OPSLIMIT_MIN || opsLimit > UINT32_MAX ||
+        memLimit < crypto_pwhash_MEMLIMIT_MIN || memLimit % 1024 != 0 ||
+        memLimit / 1024 > UINT32_MAX || memLimit > crypto_pwhash_MEMLIMIT_MAX) {
+        throw std::runtime_error("Invalid key derivation parameters");
+    }
+}
+
+CryptoModule::CryptoModule() {
+    if (sodium_init() < 0) {
+        throw std::runtime_error("Libsodium initialization failed");
+    }
+}
+
+std::vector<uint8_t> CryptoModule::encrypt(PasswordView masterPassword, const std::vector<uint8_t>& plaintext) {
+    // salt ‖ nonce ‖ ciphertext, written straight into the result
+    std::vector<uint8_t> packedData(crypto_pwhash_SALTBYTES + crypto_secretbox_NONCEBYTES +
+                                    plaintext.size() + crypto_secretbox_MACBYTES);
+    uint8_t* salt = packedData.data();
+    uint8_t* nonce = salt + crypto_pwhash_SALTBYTES;
+    randombytes_buf(salt, crypto_pwhash_SALTBYTES);
+    randombytes_buf(nonce, crypto_secretbox_NONCEBYTES);
+
+    SecureKey key;
+    if (!deriveLegacyKey(masterPassword, salt, key)) {
+        throw std::runtime_error("Key derivation failed");
+    }
 
-    // Encrypt data
-    std::vector<uint8_t> ciphertext(plaintext.size() + crypto_secretbox_MACBYTES);
     if (crypto_secretbox_easy(
-        ciphertext.data(),
+        nonce + crypto_secretbox_NONCEBYTES,
         plaintext.data(), plaintext.size(),
-        nonce.data(),
+        nonce,
         key.data()) != 0) {
         throw std::runtime_error("Encryption failed");
     }
 
-    // Combine components
-    std::vector<uint8_t> packedData;
-    packedData.reserve(salt.size() + nonce.size() + ciphertext.size());
-    packedData.insert(packedData.end(), salt.begin(), salt.end());
-    packedData.insert(packedData.end(), nonce.begin(), nonce.end());
-    packedData.insert(packedData.end(), ciphertext.begin(), ciphertext.end());
-
     return packedData;
 }
 
-std::vector<uint8_t> CryptoModule::decrypt(const std::string& masterPassword, const std::vector<uint8_t>& packedData) {
-    const size_t minSize = crypto_pwhash_SALTBYTES + crypto_secretbox_NONCEBYTES + crypto_secretbox_MACBYTES;
-    if (packedData.size() < minSize) {
+std::vector<uint8_t> CryptoModule::decrypt(PasswordView masterPassword, const std::vector<uint8_t>& packedData) {
+    if (packedData.size() < kLegacyMinBytes) {
         throw std::runtime_error("Invalid packed data format");
     }
 
-    // Extract salt
-    auto saltBegin = packedData.begin();
-    auto saltEnd = saltBegin + crypto_pwhash_SALTBYTES;
-    std::vector<uint8_t> salt(saltBegin, saltEnd);
+    // Salt, nonce and ciphertext are read in place from packedData
+    SecureKey key;
+    if (!deriveLegacyKey(masterPassword, packedData.data(), key)) {
+        throw std::runtime_error("Key derivation failed");
+    }
+
+    std::vector<uint8_t> plaintext;
+    if (!openLegacy(key, packedData, plaintext)) {
+        throw std::runtime_error("Decryption failed: incorrect password or corrupted data");
+    }
+
+    return plaintext;
+}
 
-    // Extract nonce
-    auto nonceBegin = saltEnd;
-    auto nonceEnd = nonceBegin + crypto_secretbox_NONCEBYTES;
-    std::vector<uint8_t> nonce(nonceBegin, nonceEnd);
+std::vector<uint8_t> CryptoModule::generateSalt() const {
+    std::vector<uint8_t> salt(crypto_pwhash_SALTBYTES);
+    randombytes_buf(salt.data(), salt.size());
+    return salt;
+}
 
-    // Extract ciphertext
-    auto ciphertextBegin = nonceEnd;
-    std::vector<uint8_t> ciphertext(ciphertextBegin, packedData.end());
+std::shared_ptr<SecureKey> CryptoModule::deriveSessionKey(const std::string& masterPassword, const std::vector<uint8_t>& salt,
+                                                          const KdfParams& params) {
+    if (salt.size() != crypto_pwhash_SALTBYTES) {
+        throw std::runtime_error("Invalid key derivation salt");
+    }
+    params.validate();
 
-    // Re-derive key
-    std::vector<uint8_t> key(crypto_secretbox_KEYBYTES);
+    auto kek = std::make_shared<SecureKey>();
+    PASSMGR_SPAN("crypto.kdf.session");
     if (crypto_pwhash(
-        key.data(), key.size(),
+        kek->data(), kek->size(),
         masterPassword.c_str(), masterPassword.length(),
         salt.data(),
-        crypto_pwhash_OPSLIMIT_MODERATE,
-        crypto_pwhash_MEMLIMIT_MODERATE,
+        params.opsLimit,
+        params.memLimit,
         crypto_pwhash_ALG_DEFAULT) != 0) {
         throw std::runtime_error("Key derivation failed");
     }
+    return kek;
+}
 
-    // Decrypt data
-    std::vector<uint8_t> plaintext(ciphertext.size() - crypto_secretbox_MACBYTES);
-    if (crypto_secretbox_open_easy(
-        plaintext.data(),
-        ciphertext.data(), ciphertext.size(),
-        nonce.data(),
-        key.data()) != 0) {
-        throw std::runtime_error("Decryption failed: incorrect password or corrupted data");
+KdfParams CryptoModule::calibrateKdf(unsigned targetMs, size_t memoryCap) {
+    if (sodium_init() < 0) {
+        throw std::runtime_error("Libsodium initialization failed");
+    }
+    if (targetMs == 0) {
+        throw std::invalid_argument("Calibration target must be positive");
+    }
+
+    // Below 8 MiB Argon2 stops being meaningfully memory-hard; only go lower
+    // when the cap itself is lower.
+    const size_t floorBytes = std::min<size_t>(8u * 1024 * 1024, std::max<size_t>(memoryCap, crypto_pwhash_MEMLIMIT_MIN));
+    size_t memLimit = std::min<size_t>(memoryCap, crypto_pwhash_MEMLIMIT_MAX) / 1024 * 1024;
+    memLimit = std::max(memLimit, floorBytes / 1024 * 1024);
+
+    const std::string password = "calibration";
+    uint8_t salt[crypto_pwhash_SALTBYTES] = {0};
+    SecureKey key;
+    double secondsPerPass = 0;
+    for (;;) {
+        const auto start = std::chrono::steady_clock::now();
+        const int rc = crypto_pwhash(key.data(), key.size(), password.c_str(), password.size(), salt,
+                                     crypto_pwhash_OPSLIMIT_MIN, memLimit, crypto_pwhash_ALG_DEFAULT);
+        secondsPerPass = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        // Allocation failure or a single pass already over budget: halve memory
+        const bool tooSlow = rc == 0 && secondsPerPass * 1000 > targetMs;
+        if ((rc != 0 || tooSlow) && memLimit / 2 >= floorBytes) {
+            memLimit = memLimit / 2 / 1024 * 1024;
+            continue;
+        }
+        if (rc != 0) {
+            throw std::runtime_error("Key derivation failed during calibration");
+        }
+        break;
+    }
+
+    // Argon2 time grows linearly with the pass count at fixed memory
+    const double passes = targetMs / 1000.0 / std::max(secondsPerPass, 1e-6);
+    const uint64_t opsLimit = std::max<uint64_t>(crypto_pwhash_OPSLIMIT_MIN,
+                                                 std::min<uint64_t>(static_cast<uint64_t>(passes), 64));
+    return {opsLimit, memLimit};
+}
+
+std::shared_ptr<SecureKey> CryptoModule::generateDataKey() const {
+    auto key = std::make_shared<SecureKey>();
+    crypto_secretbox_keygen(key->data());
+    return key;
+}
+
+std::shared_ptr<SecureKey> CryptoModule::deriveSubkey(const SecureKey& key, uint64_t id, const char* context) const {
+    // crypto_kdf (BLAKE2b): the same key, id and 8-byte context always yield the
+    // same subkey, and subkeys for different ids or contexts are independent.
+    auto subkey = std::make_shared<SecureKey>();
+    if (crypto_kdf_derive_from_key(subkey->data(), subkey->size(), id, context, key.data()) != 0) {
+        throw std::runtime_error("Subkey derivation failed");
+    }
+    return subkey;
+}
+
+std::vector<uint8_t> CryptoModule::wrapKey(const SecureKey& kek, const SecureKey& dataKey) {
+    // Wrapped keys use the same packed format as entries, so the plaintext
+    // copy only lives for the duration of this call and is wiped afterwards.
+    std::vector<uint8_t> raw(dataKey.data(), dataKey.data() + dataKey.size());
+    std::vector<uint8_t> wrapped = encrypt(kek, raw);
+    sodium_memzero(raw.data(), raw.size());
+    return wrapped;
+}
+
+std::shared_ptr<SecureKey> CryptoModule::unwrapKey(const SecureKey& kek, const std::vector<uint8_t>& wrappedKey) {
+    std::vector<uint8_t> raw = decrypt(kek, wrappedKey);
+    if (raw.size() != SecureKey::kKeyBytes) {
+        sodium_memzero(raw.data(), raw.size());
+        throw std::runtime_error("Invalid wrapped key");
+    }
+
+    auto key = std::make_shared<SecureKey>();
+    std::copy(raw.begin(), raw.end(), key->data());
+    sodium_memzero(raw.data(), raw.size());
+    return key;
+}
+
+std::vector<uint8_t> CryptoModule::encrypt(const SecureKey& dataKey, const std::vector<uint8_t>& plaintext) {
+    std::vector<uint8_t> packedData(sealedSize(plaintext.size()));
+    if (!encrypt(dataKey, plaintext.data(), plaintext.size(), packedData.data(), packedData.size())) {
+        throw std::runtime_error("Encryption failed");
+    }
+    return packedData;
+}
+
+std::vector<uint8_t> CryptoModule::decrypt(const SecureKey& dataKey, const std::vector<uint8_t>& packedData) {
+    EntryRecord::View view;
+    const bool record = EntryRecord::Parse(packedData.data(), packedData.size(), view);
+    if (!record && !(isSecretboxFormat(packedData.data(), packedData.size()) && packedData.size() >= kSecretboxMinBytes)) {
+        throw std::runtime_error("Invalid packed data format");
+    }
+
+    std::vector<uint8_t> plaintext(openedSize(packedData.data(), packedData.size()));
+    if (!decrypt(dataKey, packedData.data(), packedData.size(), plaintext.data(), plaintext.size())) {
+        throw std::runtime_error("Decryption failed: incorrect key or corrupted data");
     }
 
     return plaintext;
-}
\ No newline at end of file
+}
+
+size_t CryptoModule::sealedSize(size_t plaintextSize) {
+    return EntryRecord::SealedSize(plaintextSize);
+}
+
+size_t CryptoModule::openedSize(const uint8_t* packedData, size_t packedSize) {
+    EntryRecord::View view;
+    if (EntryRecord::Parse(packedData, packedSize, view)) {
+        return view.PlaintextSize();
+    }
+    if (isSecretboxFormat(packedData, packedSize)) {
+        return openedSize(packedSize);
+    }
+    return 0;
+}
+
+size_t CryptoModule::openedSize(size_t packedSize) {
+    return packedSize < kSecretboxMinBytes ? 0 : packedSize - kSecretboxMinBytes;
+}
+
+bool CryptoModule::encrypt(const SecureKey& dataKey, const uint8_t* plaintext, size_t plaintextSize,
+                           uint8_t* packedOut, size_t packedCapacity) {
+    return seal(dataKey, EntryRecord::Kind::Password, plaintext, plaintextSize, packedOut, packedCapacity);
+}
+
+bool CryptoModule::decrypt(const SecureKey& dataKey, const uint8_t* packedData, size_t packedSize,
+                           uint8_t* plaintextOut, size_t plaintextCapacity) {
+    if (EntryRecord::IsCurrent(packedData, packedSize)) {
+        return open(dataKey, EntryRecord::Kind::Password, packedData, packedSize, plaintextOut, plaintextCapacity);
+    }
+
+    if (packedSize < kSecretboxMinBytes || !isSecretboxFormat(packedData, packedSize) ||
+        plaintextCapacity < openedSize(packedSize)) {
+        return false;
+    }
+
+    const uint8_t* nonce = packedData + kPackedHeaderBytes;
+    const uint8_t* ciphertext = nonce + crypto_secretbox_NONCEBYTES;
+    const size_t ciphertextSize = packedSize - kPackedHeaderBytes - crypto_secretbox_NONCEBYTES;
+
+    PASSMGR_SPAN("crypto.open");
+    if (crypto_secretbox_open_easy(plaintextOut, ciphertext, ciphertextSize, nonce, dataKey.data()) != 0) {
+        PASSMGR_COUNT("crypto.open.failed", 1);
+        return false;
+    }
+    return true;
+}
+
+bool CryptoModule::decrypt(const SecureKey& dataKey, const uint8_t* packedData, size_t packedSize,
+                           SecureBuffer& plaintext) {
+    plaintext.resize(openedSize(packedData, packedSize));
+    if (!decrypt(dataKey, packedData, packedSize, plaintext.data(), plaintext.size())) {
+        plaintext.clear();
+        return false;
+    }
+    return true;
+}
+
+std::vector<uint8_t> CryptoModule::sealEntry(const SecureKey& dataKey, const std::string& address, const std::string& notes,
+                                             const uint8_t* password, size_t passwordSize) {
+    EntryRecord::Field addressField{reinterpret_cast<const uint8_t*>(address.data()), address.size()};
+    EntryRecord::Field notesField{reinterpret_cast<const uint8_t*>(notes.data()), notes.size()};
+    EntryRecord::Field passwordField{password, passwordSize};
+
+    SecureBuffer plaintext(EntryRecord::EncodedFieldsSize(address.size(), notes.size(), passwordSize));
+    plaintext.resize(EntryRecord::EncodeFields(plaintext.data(), addressField, notesField, passwordField));
+
+    std::vector<uint8_t> packedData(sealedSize(plaintext.size()));
+    const bool sealed = seal(dataKey, EntryRecord::Kind::Entry, plaintext.data(), plaintext.size(),
+                             packedData.data(), packedData.size());
+    plaintext.clear();
+    if (!sealed) {
+        throw std::runtime_error("Encryption failed");
+    }
+    return packedData;
+}
+
+bool CryptoModule::openEntry(const SecureKey& dataKey, const uint8_t* packedData, size_t packedSize,
+                             SecureBuffer& plaintext, EntryRecord::Fields& fields) {
+    plaintext.resize(openedSize(packedData, packedSize));
+    if (!open(dataKey, EntryRecord::Kind::Entry, packedData, packedSize, plaintext.data(), plaintext.size()) ||
+        !EntryRecord::ParseFields(plaintext.data(), plaintext.size(), fields)) {
+        plaintext.clear();
+        return false;
+    }
+    return true;
+}
+
+bool CryptoModule::seal(const SecureKey& dataKey, EntryRecord::Kind kind, const uint8_t* plaintext, size_t plaintextSize,
+                        uint8_t* packedOut, size_t packedCapacity) {
+    if (packedCapacity < sealedSize(plaintextSize)) {
+        return false;
+    }
+
+    PASSMGR_SPAN("crypto.seal");
+    const size_t headerSize = EntryRecord::WriteHeader(packedOut, kind, dataKey.id());
+    uint8_t* nonce = packedOut + headerSize;
+    randombytes_buf(nonce, EntryRecord::kNonceBytes);
+
+    // The header is authenticated as associated data, so a record cannot be
+    // relabelled (kind, key id) without failing to open.
+    return crypto_aead_xchacha20poly1305_ietf_encrypt(nonce + EntryRecord::kNonceBytes, nullptr,
+                                                      plaintext, plaintextSize,
+                                                      packedOut, headerSize,
+                                                      nullptr, nonce, dataKey.data()) == 0;
+}
+
+bool CryptoModule::open(const SecureKey& dataKey, EntryRecord::Kind kind, const uint8_t* packedData, size_t packedSize,
+                        uint8_t* plaintextOut, size_t plaintextCapacity) {
+    EntryRecord::View view;
+    if (!EntryRecord::Parse(packedData, packedSize, view) || view.kind != kind ||
+        plaintextCapacity < view.PlaintextSize()) {
+        return false;
+    }
+    // Sealed under another key (e.g. the previous one during rotation):
+    // reject from the header instead of paying for a failed MAC check.
+    if (view.keyId != dataKey.id()) {
+        PASSMGR_COUNT("crypto.open.wrong_key", 1);
+        return false;
+    }
+
+    PASSMGR_SPAN("crypto.open");
+    if (crypto_aead_xchacha20poly1305_ietf_decrypt(plaintextOut, nullptr, nullptr,
+                                                   view.ciphertext, view.ciphertextSize,
+                                                   view.header, EntryRecord::kHeaderBytes,
+                                                   view.nonce, dataKey.data()) != 0) {
+        PASSMGR_COUNT("crypto.open.failed", 1);
+        return false;
+    }
+    return true;
+}
+
+std::vector<BatchDecryptResult> CryptoModule::decryptBatch(PasswordView masterPassword,
+                                                          const SecureKey* dataKey,
+                                                          const std::vector<std::vector<uint8_t>>& packedData,
+                                                          const BatchDecryptOptions& options) {
+    std::vector<BatchDecryptResult> results(packedData.size());
+
+    // Work units: one per header-format blob, one per distinct salt among legacy
+    // blobs so entries sharing a salt reuse a single derived key.
+    std::vector<std::vector<size_t>> units;
+    std::vector<bool> unitIsLegacy;
+    std::map<std::vector<uint8_t>, size_t> unitBySalt;
+    auto addLegacy = [&](size_t i) {
+        const auto& blob = packedData[i];
+        std::vector<uint8_t> salt(blob.begin(), blob.begin() + crypto_pwhash_SALTBYTES);
+        auto found = unitBySalt.find(salt);
+        if (found == unitBySalt.end()) {
+            unitBySalt.emplace(std::move(salt), units.size());
+            units.push_back({i});
+            unitIsLegacy.push_back(true);
+        } else {
+            units[found->second].push_back(i);
+        }
+    };
+    for (size_t i = 0; i < packedData.size(); ++i) {
+        const auto& blob = packedData[i];
+        if (!isLegacyFormat(blob)) {
+            units.push_back({i});
+            unitIsLegacy.push_back(false);
+        } else if (!masterPassword.empty() && blob.size() >= crypto_pwhash_SALTBYTES) {
+            // Without the master password a legacy blob cannot open; skip the KDF
+            addLegacy(i);
+        }
+    }
+
+    // A legacy blob whose random salt happens to start with a record header is
+    // only recognisable by failing to open; with the master password at hand
+    // such failures get a second, legacy attempt.
+    const bool legacyFallback = !masterPassword.empty();
+    std::vector<size_t> retry;
+
+    KdfSlots kdfSlots(options.kdfMemoryCap / crypto_pwhash_MEMLIMIT_MODERATE);
+    std::atomic<bool> canceled(false);
+    std::mutex progressMutex;
+    size_t done = 0;
+
+    auto runUnit = [&](size_t unit) {
+        if (canceled) {
+            return;
+        }
+
+        const auto& items = units[unit];
+        if (!unitIsLegacy[unit]) {
+            // The bool overload avoids an exception per undecryptable blob
+            const auto& blob = packedData[items[0]];
+            auto& result = results[items[0]];
+            result.plaintext.resize(openedSize(blob.data(), blob.size()));
+            for (const SecureKey* key : {dataKey, options.previousKey}) {
+                if (key && !result.ok) {
+                    result.ok = decrypt(*key, blob.data(), blob.size(), result.plaintext.data(), result.plaintext.size());
+                }
+            }
+            if (!result.ok) {
+                result.plaintext.clear();
+                if (legacyFallback && mayBeLegacyFormat(blob.data(), blob.size())) {
+                    // Progress is reported once the legacy attempt finishes
+                    std::lock_guard<std::mutex> lock(progressMutex);
+                    retry.push_back(items[0]);
+                    return;
+                }
+            }
+        } else {
+            SecureKey key;
+            kdfSlots.acquire();
+            const bool derived = deriveLegacyKey(masterPassword, packedData[items[0]].data(), key);
+            kdfSlots.release();
+
+            for (size_t index : items) {
+                results[index].ok = derived && openLegacy(key, packedData[index], results[index].plaintext);
+                if (!results[index].ok) {
+                    results[index].plaintext.clear();
+                }
+            }
+        }
+
+        if (options.progress) {
+            std::lock_guard<std::mutex> lock(progressMutex);
+            done += items.size();
+            if (!options.progress(done, packedData.size())) {
+                canceled = true;
+            }
+        }
+    };
+
+    runParallel(units.size(), options.threads, runUnit);
+
+    if (!retry.empty() && !canceled) {
+        units.clear();
+        unitIsLegacy.clear();
+        unitBySalt.clear();
+        std::sort(retry.begin(), retry.end());
+        for (size_t index : retry) {
+            addLegacy(index);
+        }
+        runParallel(units.size(), options.threads, runUnit);
+    }
+
+    return results;
+}
+
+std::vector<std::vector<uint8_t>> CryptoModule::encryptBatch(const SecureKey& dataKey,
+                                                            const std::vector<std::vector<uint8_t>>& plaintexts,
+                                                            unsigned threads) {
+    std::vector<std::vector<uint8_t>> packed(plaintexts.size());
+
+    // secretbox is cheap per item; hand out contiguous chunks so thread
+    // start-up and the shared counter do not dominate small entries.
+    const size_t chunk = 64;
+    const size_t chunks = (plaintexts.size() + chunk - 1) / chunk;
+    runParallel(chunks, threads, [&](size_t unit) {
+        const size_t end = std::min(plaintexts.size(), (unit + 1) * chunk);
+        for (size_t i = unit * chunk; i < end; ++i) {
+            packed[i] = encrypt(dataKey, plaintexts[i]);
+        }
+    });
+
+    return packed;
+}
+
+bool CryptoModule::isLegacyFormat(const std::vector<uint8_t>& packedData) {
+    return isLegacyFormat(packedData.data(), packedData.size());
+}
+
+bool CryptoModule::isLegacyFormat(const uint8_t* packedData, size_t packedSize) {
+    return !EntryRecord::IsCurrent(packedData, packedSize) && !isSecretboxFormat(packedData, packedSize);
+}
+
+bool CryptoModule::mayBeLegacyFormat(const uint8_t*, size_t packedSize) {
+    // Any byte pattern is a valid salt, so only the length rules a blob out
+    return packedSize >= kLegacyMinBytes;
+}
+
+bool CryptoModule::isCurrentFormat(const uint8_t* packedData, size_t packedSize) {
+    return EntryRecord::IsCurrent(packedData, packedSize);
+}
+
+bool CryptoModule::isCurrentFormat(const SecureKey& dataKey, const uint8_t* packedData, size_t packedSize) {
+    // A legacy blob posing as a record carries a random key_id, which matches
+    // with probability 2^-32
+    EntryRecord::View view;
+    return EntryRecord::Parse(packedData, packedSize, view) && view.keyId == dataKey.id();
+}
@@ -0,0 +1,278 @@
+#include "CsvImporter.h"
+#include <sodium.h>
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <stdexcept>
+using namespace std;
+
+namespace {
+
+string Lower(string text) {
+    transform(text.begin(), text.end(), text.begin(),
+              [](unsigned char c) { return static_cast<char>(tolower(c)); });
+    return text;
+}
+
+int FindColumn(const vector<string>& header, initializer_list<const char*> names) {
+    for (const char* name : names) {
+        auto it = find(header.begin(), header.end(), name);
+        if (it != header.end()) {
+            return static_cast<int>(it - header.begin());
+        }
+    }
+    return -1;
+}
+
+bool HasColumn(const vector<string>& header, const char* name) {
+    return FindColumn(header, {name}) >= 0;
+}
+
+void Wipe(string& text) {
+    if (!text.empty()) {
+        sodium_memzero(&text[0], text.size());
+    }
+    text.clear();
+}
+
+} // namespace
+
+CsvReader::CsvReader(istream& in) : in_(in) {}
+
+int CsvReader::Get() {
+    const int c = in_.rdbuf()->sbumpc();
+    if (c == char_traits<char>::eof()) {
+        return c;
+    }
+    ++bytesRead_;
+    if (c == '\n') {
+        ++line_;
+    }
+    return c;
+}
+
+bool CsvReader::ReadRecord(vector<string>& fields) {
+    fields.clear();
+
+    // 跳过空行
+    int c = Get();
+    while (c == '\r' || c == '\n') {
+        c = Get();
+    }
+    if (c == char_traits<char>::eof()) {
+        return false;
+    }
+    recordLine_ = line_;
+
+    string field;
+    bool quoted = false;
+    bool fieldStart = true;
+    for (;; c = Get()) {
+        if (quoted) {
+            if (c == char_traits<char>::eof()) {
+                throw runtime_error("引号未闭合");
+            }
+            if (c == '"') {
+                const int next = Get();
+                if (next == '"') {
+                    field += '"';
+                    continue;
+                }
+                quoted = false;
+                c = next;
+            } else {
+                field += static_cast<char>(c);
+                continue;
+            }
+        }
+
+        if (c == char_traits<char>::eof() || c == '\n') {
+            break;
+        }
+        if (c == '"' && fieldStart) {
+            quoted = true;
+            fieldStart = false;
+        } else if (c == ',') {
+            fields.push_back(move(field));
+            field.clear();
+            fieldStart = true;
+        } else if (c != '\r') {
+            field += static_cast<char>(c);
+            fieldStart = false;
+        }
+    }
+    fields.push_back(move(field));
+    return true;
+}
+
+CsvImporter::CsvImporter(PasswordVault& vault, shared_ptr<SecureKey> dataKey)
+    : vault_(vault), dataKey_(move(dataKey)) {
+    if (!dataKey_) {
+        throw invalid_argument("Invalid codebook key");
+    }
+}
+
+const char* CsvImporter::LayoutName(CsvLayout layout) {
+    switch (layout) {
+    case CsvLayout::Chrome: return "Chrome";
+    case CsvLayout::Firefox: return "Firefox";
+    case CsvLayout::KeePass: return "KeePass";
+    case CsvLayout::KeePassXC: return "KeePassXC";
+    case CsvLayout::Bitwarden: return "Bitwarden";
+    case CsvLayout::Generic: return "CSV";
+    case CsvLayout::Unknown: break;
+    }
+    return "Unknown";
+}
+
+CsvLayout CsvImporter::DetectLayout(const vector<string>& rawHeader, ColumnMap& columns) {
+    vector<string> header;
+    for (const auto& name : rawHeader) {
+        header.push_back(Lower(name));
+    }
+    // Excel 等工具导出的 UTF-8 BOM
+    if (!header.empty() && header[0].compare(0, 3, "\xEF\xBB\xBF") == 0) {
+        header[0].erase(0, 3);
+    }
+
+    columns.title = FindColumn(header, {"name", "title", "account"});
+    columns.url = FindColumn(header, {"login_uri", "url", "web site", "website"});
+    columns.username = FindColumn(header, {"login_username", "username", "login name", "user name"});
+    columns.password = FindColumn(header, {"login_password", "password"});
+    columns.notes = FindColumn(header, {"notes", "note", "comments"});
+
+    if (columns.password < 0 || (columns.url < 0 && columns.title < 0)) {
+        return CsvLayout::Unknown;
+    }
+    if (HasColumn(header, "login_uri")) return CsvLayout::Bitwarden;
+    if (HasColumn(header, "httprealm") || HasColumn(header, "formactionorigin")) return CsvLayout::Firefox;
+    if (HasColumn(header, "login name") && HasColumn(header, "web site")) return CsvLayout::KeePass;
+    if (HasColumn(header, "title") && HasColumn(header, "group")) return CsvLayout::KeePassXC;
+    if (HasColumn(header, "name") && HasColumn(header, "url")) return CsvLayout::Chrome;
+    return CsvLayout::Generic;
+}
+
+string CsvImporter::Field(const vector<string>& fields, int column) {
+    if (column < 0 || column >= static_cast<int>(fields.size())) {
+        return string();
+    }
+    return fields[column];
+}
+
+CsvImportReport CsvImporter::ImportFile(int codebook_id, const string& path, const CsvImportOptions& options) {
+    ifstream in(path, ios::binary);
+    if (!in) {
+        throw runtime_error("无法打开文件: " + path);
+    }
+
+    in.seekg(0, ios::end);
+    const uint64_t totalBytes = static_cast<uint64_t>(in.tellg());
+    in.seekg(0, ios::beg);
+    return Import(codebook_id, in, totalBytes, options);
+}
+
+CsvImportReport CsvImporter::Import(int codebook_id, istream& in, uint64_t totalBytes, const CsvImportOptions& options) {
+    CsvImportReport report;
+    CsvReader reader(in);
+    vector<string> fields;
+
+    if (!reader.ReadRecord(fields)) {
+        throw invalid_argument("CSV 文件为空");
+    }
+    ColumnMap columns;
+    report.layout = DetectLayout(fields, columns);
+    if (report.layout == CsvLayout::Unknown) {
+        throw invalid_argument("无法识别的CSV格式：需要密码列以及地址或名称列");
+    }
+
+    const size_t batchSize = max<size_t>(1, options.batchSize);
+    vector<PendingRow> rows;
+    vector<vector<uint8_t>> passwords;
+
+    for (;;) {
+        try {
+            if (!reader.ReadRecord(fields)) break;
+        } catch (const exception& e) {
+            // 格式错误只会出现在文件末尾，之前的记录照常导入
+            report.errors.push_back({reader.RecordLine(), e.what()});
+            break;
+        }
+        ++report.rowsRead;
+
+        string title = Field(fields, columns.title);
+        string url = Field(fields, columns.url);
+        string username = Field(fields, columns.username);
+        string password = Field(fields, columns.password);
+        string notes = Field(fields, columns.notes);
+        if (columns.password < static_cast<int>(fields.size())) {
+            Wipe(fields[columns.password]);
+        }
+
+        PendingRow row{reader.RecordLine(), url.empty() ? title : url, string()};
+        if (row.address.empty()) {
+            report.errors.push_back({row.line, "缺少地址"});
+            Wipe(password);
+            continue;
+        }
+        if (password.empty()) {
+            report.errors.push_back({row.line, "密码为空"});
+            continue;
+        }
+
+        // 条目没有单独的用户名字段，名称和用户名记入备注
+        if (!title.empty() && title != row.address) row.notes += "名称: " + title + "\n";
+        if (!username.empty()) row.notes += "用户名: " + username + "\n";
+        row.notes += notes;
+        if (!row.notes.empty() && row.notes.back() == '\n') row.notes.pop_back();
+
+        rows.push_back(move(row));
+        passwords.emplace_back(password.begin(), password.end());
+        Wipe(password);
+
+        if (rows.size() >= batchSize) {
+            CommitBatch(codebook_id, rows, passwords, options, report);
+            if (options.progress && !options.progress(reader.BytesRead(), totalBytes)) {
+                report.canceled = true;
+                return report;
+            }
+        }
+    }
+
+    CommitBatch(codebook_id, rows, passwords, options, report);
+    if (options.progress) {
+        options.progress(reader.BytesRead(), totalBytes);
+    }
+    return report;
+}
+
+void CsvImporter::CommitBatch(int codebook_id, vector<PendingRow>& rows,
+                              vector<vector<uint8_t>>& passwords,
+                              const CsvImportOptions& options, CsvImportReport& report) {
+    if (rows.empty()) {
+        return;
+    }
+
+    vector<vector<uint8_t>> encrypted = crypto_.encryptBatch(*dataKey_, passwords, options.threads);
+    for (auto& password : passwords) {
+        sodium_memzero(password.data(), password.size());
+    }
+
+    vector<PasswordVault::PasswordEntry> entries(rows.size());
+    for (size_t i = 0; i < rows.size(); ++i) {
+        entries[i].address = move(rows[i].address);
+        entries[i].notes = move(rows[i].notes);
+        entries[i].encrypted_password = move(encrypted[i]);
+    }
+
+    const vector<bool> inserted = vault_.AddEntries(codebook_id, entries);
+    for (size_t i = 0; i < inserted.size(); ++i) {
+        if (inserted[i]) {
+            ++report.imported;
+        } else {
+            report.errors.push_back({rows[i].line, "写入数据库失败"});
+        }
+    }
+
+    rows.clear();
+    passwords.clear();
+}
@@ -0,0 +1,132 @@
+#include "EntryRecord.h"
+#include <cstring>
+using namespace std;
+
+namespace {
+
+uint32_t GetU32(const uint8_t* in) {
+    return static_cast<uint32_t>(in[0]) | static_cast<uint32_t>(in[1]) << 8 |
+           static_cast<uint32_t>(in[2]) << 16 | static_cast<uint32_t>(in[3]) << 24;
+}
+
+void PutU32(uint8_t* out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+// LEB128：每字节 7 位，最高位表示后面还有字节；字段长度不超过 32 位，最多 5 字节
+size_t VarintSize(size_t value) {
+    size_t bytes = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        ++bytes;
+    }
+    return bytes;
+}
+
+size_t PutVarint(uint8_t* out, size_t value) {
+    size_t written = 0;
+    while (value >= 0x80) {
+        out[written++] = static_cast<uint8_t>(value | 0x80);
+        value >>= 7;
+    }
+    out[written++] = static_cast<uint8_t>(value);
+    return written;
+}
+
+bool GetField(const uint8_t*& cursor, const uint8_t* end, EntryRecord::Field& field) {
+    uint64_t size = 0;
+    for (int shift = 0;; shift += 7) {
+        if (cursor == end || shift > 28) {
+            return false;
+        }
+        const uint8_t byte = *cursor++;
+        size |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            break;
+        }
+    }
+    if (size > static_cast<uint64_t>(end - cursor)) {
+        return false;
+    }
+    field.data = cursor;
+    field.size = static_cast<size_t>(size);
+    cursor += size;
+    return true;
+}
+
+} // namespace
+
+bool EntryRecord::Parse(const uint8_t* data, size_t size, View& view) {
+    if (!IsCurrent(data, size) || size < kHeaderBytes) {
+        return false;
+    }
+
+    const uint8_t kind = data[2];
+    const uint8_t algorithm = data[3];
+    const uint8_t kdf = data[4];
+    if ((kind != static_cast<uint8_t>(Kind::Password) && kind != static_cast<uint8_t>(Kind::Entry)) ||
+        algorithm != static_cast<uint8_t>(Algorithm::XChaCha20Poly1305) ||
+        kdf != static_cast<uint8_t>(Kdf::DataKey)) {
+        return false;
+    }
+    if (size < kHeaderBytes + kNonceBytes + kTagBytes) {
+        return false;
+    }
+
+    view.kind = static_cast<Kind>(kind);
+    view.algorithm = static_cast<Algorithm>(algorithm);
+    view.kdf = static_cast<Kdf>(kdf);
+    view.keyId = GetU32(data + 5);
+    view.header = data;
+    view.nonce = data + kHeaderBytes;
+    view.ciphertext = view.nonce + kNonceBytes;
+    view.ciphertextSize = size - kHeaderBytes - kNonceBytes;
+    return true;
+}
+
+bool EntryRecord::IsCurrent(const uint8_t* data, size_t size) {
+    return size >= 2 && data[0] == kMagic && data[1] == kVersion;
+}
+
+size_t EntryRecord::SealedSize(size_t plaintextSize) {
+    return kHeaderBytes + kNonceBytes + plaintextSize + kTagBytes;
+}
+
+size_t EntryRecord::WriteHeader(uint8_t* out, Kind kind, uint32_t keyId) {
+    out[0] = kMagic;
+    out[1] = kVersion;
+    out[2] = static_cast<uint8_t>(kind);
+    out[3] = static_cast<uint8_t>(Algorithm::XChaCha20Poly1305);
+    out[4] = static_cast<uint8_t>(Kdf::DataKey);
+    PutU32(out + 5, keyId);
+    return kHeaderBytes;
+}
+
+size_t EntryRecord::EncodedFieldsSize(size_t addressSize, size_t notesSize, size_t passwordSize) {
+    return VarintSize(addressSize) + addressSize +
+           VarintSize(notesSize) + notesSize +
+           VarintSize(passwordSize) + passwordSize;
+}
+
+size_t EntryRecord::EncodeFields(uint8_t* out, const Field& address, const Field& notes, const Field& password) {
+    size_t written = 0;
+    for (const Field* field : {&address, &notes, &password}) {
+        written += PutVarint(out + written, field->size);
+        if (field->size) {
+            memcpy(out + written, field->data, field->size);
+        }
+        written += field->size;
+    }
+    return written;
+}
+
+bool EntryRecord::ParseFields(const uint8_t* data, size_t size, Fields& fields) {
+    const uint8_t* cursor = data;
+    const uint8_t* end = data + size;
+    return GetField(cursor, end, fields.address) &&
+           GetField(cursor, end, fields.notes) &&
+           GetField(cursor, end, fields.password) &&
+           cursor == end;
+}
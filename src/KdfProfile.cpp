@@ -0,0 +1,83 @@
+#include "KdfProfile.h"
+#include <sstream>
+#include <stdexcept>
+using namespace std;
+
+namespace {
+
+KdfParams ReadParams(const AppConfig& config, const string& prefix, KdfParams params) {
+    const long long ops = config.GetInt(prefix + "_ops", static_cast<long long>(params.opsLimit));
+    const long long memKiB = config.GetInt(prefix + "_mem_kib", static_cast<long long>(params.memLimit / 1024));
+    if (ops <= 0 || memKiB <= 0) {
+        throw invalid_argument("配置项 " + prefix + "_ops / " + prefix + "_mem_kib 必须为正数");
+    }
+    params.opsLimit = static_cast<uint64_t>(ops);
+    params.memLimit = static_cast<size_t>(memKiB) * 1024;
+    return params;
+}
+
+} // namespace
+
+KdfProfile KdfProfile::Default() {
+    return KdfProfile();
+}
+
+KdfProfile KdfProfile::Moderate() {
+    KdfProfile profile;
+    profile.name = "moderate";
+    profile.passwordHash = KdfParams::moderate();
+    return profile;
+}
+
+KdfProfile KdfProfile::Interactive() {
+    KdfProfile profile;
+    profile.name = "interactive";
+    profile.passwordHash = KdfParams::interactive();
+    profile.sessionKey = KdfParams::interactive();
+    return profile;
+}
+
+KdfProfile KdfProfile::Named(const string& name) {
+    if (name == "default") return Default();
+    if (name == "moderate") return Moderate();
+    if (name == "interactive") return Interactive();
+    throw invalid_argument("未知的密钥派生配置: " + name);
+}
+
+vector<string> KdfProfile::Names() {
+    return {"default", "moderate", "interactive"};
+}
+
+KdfProfile KdfProfile::FromConfig(const AppConfig& config) {
+    KdfProfile profile = Named(config.Get("kdf.profile", "default"));
+    profile.passwordHash = ReadParams(config, "kdf.hash", profile.passwordHash);
+    profile.sessionKey = ReadParams(config, "kdf.key", profile.sessionKey);
+    profile.Validate();
+    return profile;
+}
+
+KdfProfile KdfProfile::Calibrate(unsigned targetMs, size_t memoryCap) {
+    KdfProfile profile;
+    profile.name = "calibrated";
+    profile.passwordHash = CryptoModule::calibrateKdf(targetMs, memoryCap);
+    profile.sessionKey = profile.passwordHash;
+    return profile;
+}
+
+string KdfProfile::ToConfig() const {
+    ostringstream out;
+    out << "kdf.hash_ops = " << passwordHash.opsLimit << "\n"
+        << "kdf.hash_mem_kib = " << passwordHash.memLimit / 1024 << "\n"
+        << "kdf.key_ops = " << sessionKey.opsLimit << "\n"
+        << "kdf.key_mem_kib = " << sessionKey.memLimit / 1024 << "\n";
+    return out.str();
+}
+
+void KdfProfile::Validate() const {
+    try {
+        passwordHash.validate();
+        sessionKey.validate();
+    } catch (const runtime_error&) {
+        throw invalid_argument("密钥派生配置 " + name + " 的参数超出 Argon2id 允许范围");
+    }
+}
@@ -0,0 +1,177 @@
+#include "KeyRotation.h"
+#include <sodium.h>
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#include "PasswordStrength.h"
+#include "UserAuth.h"
+using namespace std;
+
+KeyRotation::KeyRotation(PasswordVault& vault, shared_ptr<SessionKeyring> keyring)
+    : vault_(vault), keyring_(move(keyring)) {
+    if (!keyring_) {
+        throw invalid_argument("Invalid session keyring");
+    }
+}
+
+bool KeyRotation::ChangeMasterPassword(const string& username,
+                                       const string& oldPassword,
+                                       const string& newPassword) {
+    if (!keyring_->CheckMasterPassword(oldPassword)) {
+        return false;
+    }
+    if (!MeetsComplexityRule(newPassword)) {
+        throw invalid_argument("Password does not meet complexity requirements");
+    }
+    // 上一次轮换未完成时旧数据密钥仍在使用，不能再被替换
+    if (Pending(username)) {
+        throw runtime_error("A key rotation is already in progress");
+    }
+
+    // 确保每个密码本都有数据密钥，并在旧主密码仍可用时迁移旧格式条目
+    const auto codebooks = vault_.GetUserCodebooks(username);
+    vector<shared_ptr<SecureKey>> oldKeys;
+    for (const auto& codebook : codebooks) {
+        oldKeys.push_back(keyring_->GetCodebookKey(vault_, codebook.id));
+        MigrateLegacyEntries(codebook.id, *oldKeys.back());
+    }
+
+    const KdfProfile& kdf = keyring_->Kdf();
+    const vector<uint8_t> salt = crypto_.generateSalt();
+    auto kek = crypto_.deriveSessionKey(newPassword, salt, kdf.sessionKey);
+
+    vector<PasswordVault::CodebookRotation> rotations;
+    for (size_t i = 0; i < codebooks.size(); ++i) {
+        PasswordVault::CodebookRotation rotation;
+        rotation.codebook_id = codebooks[i].id;
+        rotation.wrapped_key = crypto_.wrapKey(*kek, *crypto_.generateDataKey());
+        rotation.previous_wrapped_key = crypto_.wrapKey(*kek, *oldKeys[i]);
+        rotations.push_back(move(rotation));
+    }
+
+    vault_.BeginKeyRotation(username, UserAuth::HashPassword(newPassword, kdf.passwordHash), salt,
+                            kdf.sessionKey.encode(), rotations);
+    keyring_->Rekey(kek, newPassword);
+    return true;
+}
+
+bool KeyRotation::Pending(const string& username) {
+    return !vault_.GetRotationCheckpoints(username).empty();
+}
+
+RotationReport KeyRotation::Resume(const string& username, const RotationOptions& options) {
+    RotationReport report;
+    const auto checkpoints = vault_.GetRotationCheckpoints(username);
+    uint64_t total = 0;
+    for (const auto& checkpoint : checkpoints) {
+        total += static_cast<uint64_t>(checkpoint.remaining);
+    }
+    uint64_t done = 0;
+
+    for (const auto& checkpoint : checkpoints) {
+        auto codebookKey = keyring_->GetCodebookKey(vault_, checkpoint.codebook_id);
+        auto previousKey = keyring_->GetPreviousCodebookKey(vault_, checkpoint.codebook_id);
+
+        PasswordVault::EntryPage page;
+        page.next_after_id = checkpoint.last_entry_id;
+        if (previousKey) {
+            do {
+                page = vault_.GetEntries(checkpoint.codebook_id, "", page.next_after_id, max(1, options.batchSize));
+
+                // 旧格式条目需要已被替换的主密码，无法处理，保持原样
+                vector<size_t> indices;
+                vector<vector<uint8_t>> blobs;
+                for (size_t i = 0; i < page.entries.size(); ++i) {
+                    if (CryptoModule::isLegacyFormat(page.entries[i].encrypted_password)) {
+                        ++report.undecryptable;
+                        continue;
+                    }
+                    indices.push_back(i);
+                    blobs.push_back(move(page.entries[i].encrypted_password));
+                }
+
+                BatchDecryptOptions decryptOptions;
+                decryptOptions.threads = options.threads;
+                auto plaintexts = crypto_.decryptBatch(string(), previousKey.get(), blobs, decryptOptions);
+
+                vector<size_t> decrypted;
+                vector<vector<uint8_t>> rotated;
+                for (size_t j = 0; j < indices.size(); ++j) {
+                    if (plaintexts[j].ok) {
+                        decrypted.push_back(j);
+                        rotated.push_back(move(plaintexts[j].plaintext));
+                        continue;
+                    }
+                    // 轮换开始后新写入或修改的条目已经使用新数据密钥
+                    try {
+                        vector<uint8_t> plaintext = crypto_.decrypt(*codebookKey, blobs[j]);
+                        sodium_memzero(plaintext.data(), plaintext.size());
+                        ++report.alreadyRotated;
+                    } catch (const runtime_error&) {
+                        ++report.undecryptable;
+                    }
+                }
+
+                auto packed = crypto_.encryptBatch(*codebookKey, rotated, options.threads);
+                for (auto& plaintext : rotated) {
+                    sodium_memzero(plaintext.data(), plaintext.size());
+                }
+
+                vector<PasswordVault::RotatedBlob> updates;
+                for (size_t k = 0; k < decrypted.size(); ++k) {
+                    const size_t j = decrypted[k];
+                    updates.push_back({page.entries[indices[j]].id, move(blobs[j]), move(packed[k])});
+                }
+                const size_t written = vault_.CommitRotationBatch(checkpoint.codebook_id, updates, page.next_after_id);
+                report.reencrypted += written;
+                report.alreadyRotated += updates.size() - written;
+                done += page.entries.size();
+
+                if (options.progress && !options.progress(done, total)) {
+                    report.canceled = true;
+                    return report;
+                }
+            } while (page.has_more);
+        }
+
+        vault_.CompleteCodebookRotation(checkpoint.codebook_id);
+        keyring_->ForgetCodebook(checkpoint.codebook_id);
+    }
+
+    report.finished = true;
+    return report;
+}
+
+void KeyRotation::MigrateLegacyEntries(int codebook_id, const SecureKey& codebookKey) {
+    if (vault_.GetCodebookFormat(codebook_id) >= EntryRecord::kVersion) {
+        return;
+    }
+
+    vector<int> ids;
+    vector<vector<uint8_t>> legacy;
+    PasswordVault::EntryPage page;
+    do {
+        page = vault_.GetEntries(codebook_id, "", page.next_after_id, 500);
+        for (auto& entry : page.entries) {
+            // 按 key_id 而不是只按记录头挑选：恰好以记录头开头的旧格式条目同样需要迁移
+            const auto& blob = entry.encrypted_password;
+            if (!CryptoModule::isCurrentFormat(codebookKey, blob.data(), blob.size())) {
+                ids.push_back(entry.id);
+                legacy.push_back(move(entry.encrypted_password));
+            }
+        }
+    } while (page.has_more);
+
+    auto plaintexts = keyring_->DecryptBatch(codebookKey, legacy);
+    vector<PasswordVault::RotatedBlob> rewrapped;
+    for (size_t i = 0; i < plaintexts.size(); ++i) {
+        if (!plaintexts[i].ok) {
+            continue;
+        }
+        rewrapped.push_back({ids[i], move(legacy[i]), crypto_.encrypt(codebookKey, plaintexts[i].plaintext)});
+        sodium_memzero(plaintexts[i].plaintext.data(), plaintexts[i].plaintext.size());
+    }
+    vault_.UpdateEncryptedPasswords(rewrapped);
+    // 无法解密的条目换了主密码也不会变得可解，不再重复扫描
+    vault_.SetCodebookFormat(codebook_id, EntryRecord::kVersion);
+}
@@ -0,0 +1,343 @@
+#include "Metrics.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+using namespace std;
+
+namespace {
+
+// 一个线程上一个指标的数据：只有所属线程写入，导出线程读取
+struct Cell {
+    atomic<uint64_t> count;
+    atomic<uint64_t> sum;
+    atomic<uint64_t> max;
+    atomic<uint64_t> buckets[Metrics::kBuckets];
+
+    Cell() { Clear(); }
+
+    void Clear() {
+        count.store(0, memory_order_relaxed);
+        sum.store(0, memory_order_relaxed);
+        max.store(0, memory_order_relaxed);
+        for (auto& bucket : buckets) {
+            bucket.store(0, memory_order_relaxed);
+        }
+    }
+};
+
+// 单写者的累加：不需要 fetch_add 的总线锁
+inline void Bump(atomic<uint64_t>& value, uint64_t delta) {
+    value.store(value.load(memory_order_relaxed) + delta, memory_order_relaxed);
+}
+
+size_t BucketOf(uint64_t nanos) {
+    size_t bits = 0;
+#if defined(__GNUC__)
+    bits = nanos == 0 ? 0 : static_cast<size_t>(64 - __builtin_clzll(nanos));
+#else
+    while (nanos) {
+        nanos >>= 1;
+        ++bits;
+    }
+#endif
+    return bits < Metrics::kBuckets ? bits : Metrics::kBuckets - 1;
+}
+
+struct ThreadCells;
+
+struct Registry {
+    mutex lock;
+    vector<string> names;
+    vector<Metrics::Kind> kinds;
+    map<string, int> ids;
+    vector<ThreadCells*> threads;
+    // 已退出线程的累计
+    vector<unique_ptr<Cell>> retired;
+};
+
+// 与 StatementCache 相同，注册表有意不析构：线程可能在静态析构之后才退出
+Registry& registry() {
+    static auto* instance = new Registry();
+    return *instance;
+}
+
+struct ThreadCells {
+    atomic<Cell*> cells[Metrics::kMaxSeries];
+
+    ThreadCells() {
+        for (auto& cell : cells) {
+            cell.store(nullptr, memory_order_relaxed);
+        }
+        Registry& reg = registry();
+        lock_guard<mutex> guard(reg.lock);
+        reg.threads.push_back(this);
+    }
+
+    ~ThreadCells() {
+        Registry& reg = registry();
+        lock_guard<mutex> guard(reg.lock);
+        for (size_t id = 0; id < Metrics::kMaxSeries; ++id) {
+            Cell* cell = cells[id].load(memory_order_relaxed);
+            if (!cell) {
+                continue;
+            }
+            if (!reg.retired[id]) {
+                reg.retired[id].reset(new Cell());
+            }
+            Cell& total = *reg.retired[id];
+            Bump(total.count, cell->count.load(memory_order_relaxed));
+            Bump(total.sum, cell->sum.load(memory_order_relaxed));
+            total.max.store(max(total.max.load(memory_order_relaxed), cell->max.load(memory_order_relaxed)),
+                            memory_order_relaxed);
+            for (size_t b = 0; b < Metrics::kBuckets; ++b) {
+                Bump(total.buckets[b], cell->buckets[b].load(memory_order_relaxed));
+            }
+            delete cell;
+        }
+        reg.threads.erase(remove(reg.threads.begin(), reg.threads.end(), this), reg.threads.end());
+    }
+
+    // 第一次在本线程记录该指标时分配
+    Cell& At(int id) {
+        Cell* cell = cells[id].load(memory_order_relaxed);
+        if (!cell) {
+            cell = new Cell();
+            cells[id].store(cell, memory_order_release);
+        }
+        return *cell;
+    }
+};
+
+ThreadCells& Local() {
+    thread_local ThreadCells local;
+    return local;
+}
+
+void Accumulate(Metrics::Series& series, const Cell& cell) {
+    series.count += cell.count.load(memory_order_relaxed);
+    series.sum += cell.sum.load(memory_order_relaxed);
+    series.max = max(series.max, cell.max.load(memory_order_relaxed));
+    for (size_t b = 0; b < series.buckets.size(); ++b) {
+        series.buckets[b] += cell.buckets[b].load(memory_order_relaxed);
+    }
+}
+
+// 指标名只含字母、数字、点与下划线；仍然转义引号与反斜杠
+string Quoted(const string& text) {
+    string out = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+        }
+        out += c;
+    }
+    return out + "\"";
+}
+
+// 桶 i 的上界（纳秒）
+uint64_t BucketBound(size_t bucket) {
+    return bucket == 0 ? 0 : (uint64_t(1) << bucket) - 1;
+}
+
+} // namespace
+
+uint64_t Metrics::Series::Quantile(double q) const {
+    if (count == 0 || buckets.empty()) {
+        return 0;
+    }
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(ceil(q * static_cast<double>(count))));
+    uint64_t seen = 0;
+    for (size_t b = 0; b < buckets.size(); ++b) {
+        seen += buckets[b];
+        if (seen >= rank) {
+            return std::min(BucketBound(b), max);
+        }
+    }
+    return max;
+}
+
+int Metrics::Register(const char* name, Kind kind) {
+    Registry& reg = registry();
+    lock_guard<mutex> guard(reg.lock);
+    auto found = reg.ids.find(name);
+    if (found != reg.ids.end()) {
+        return found->second;
+    }
+    if (reg.names.size() >= kMaxSeries) {
+        return -1;
+    }
+
+    const int id = static_cast<int>(reg.names.size());
+    reg.names.push_back(name);
+    reg.kinds.push_back(kind);
+    reg.retired.emplace_back();
+    reg.ids.emplace(name, id);
+    return id;
+}
+
+void Metrics::RecordSpan(int id, uint64_t nanos) {
+    if (id < 0) {
+        return;
+    }
+    Cell& cell = Local().At(id);
+    Bump(cell.count, 1);
+    Bump(cell.sum, nanos);
+    if (nanos > cell.max.load(memory_order_relaxed)) {
+        cell.max.store(nanos, memory_order_relaxed);
+    }
+    Bump(cell.buckets[BucketOf(nanos)], 1);
+}
+
+void Metrics::Add(int id, uint64_t value) {
+    if (id < 0) {
+        return;
+    }
+    Cell& cell = Local().At(id);
+    Bump(cell.count, 1);
+    Bump(cell.sum, value);
+}
+
+vector<Metrics::Series> Metrics::Snapshot() {
+    Registry& reg = registry();
+    lock_guard<mutex> guard(reg.lock);
+
+    vector<Series> result(reg.names.size());
+    for (size_t id = 0; id < result.size(); ++id) {
+        Series& series = result[id];
+        series.name = reg.names[id];
+        series.kind = reg.kinds[id];
+        if (series.kind == Kind::Span) {
+            series.buckets.assign(kBuckets, 0);
+        }
+        if (reg.retired[id]) {
+            Accumulate(series, *reg.retired[id]);
+        }
+        for (ThreadCells* thread : reg.threads) {
+            if (const Cell* cell = thread->cells[id].load(memory_order_acquire)) {
+                Accumulate(series, *cell);
+            }
+        }
+    }
+
+    sort(result.begin(), result.end(), [](const Series& a, const Series& b) { return a.name < b.name; });
+    return result;
+}
+
+void Metrics::Reset() {
+    Registry& reg = registry();
+    lock_guard<mutex> guard(reg.lock);
+    // 与正在记录的线程并发时可能留下少量重置前的计数，诊断用途可以接受
+    for (auto& cell : reg.retired) {
+        if (cell) {
+            cell->Clear();
+        }
+    }
+    for (ThreadCells* thread : reg.threads) {
+        for (auto& slot : thread->cells) {
+            if (Cell* cell = slot.load(memory_order_acquire)) {
+                cell->Clear();
+            }
+        }
+    }
+}
+
+string Metrics::ToJson(const vector<Series>& series) {
+    ostringstream out;
+    out << "{\n  \"spans\": [";
+    bool first = true;
+    for (const auto& s : series) {
+        if (s.kind != Kind::Span) {
+            continue;
+        }
+        out << (first ? "\n" : ",\n") << "    {\"name\": " << Quoted(s.name)
+            << ", \"count\": " << s.count
+            << ", \"sum_ns\": " << s.sum
+            << ", \"max_ns\": " << s.max
+            << ", \"p50_ns\": " << s.Quantile(0.5)
+            << ", \"p90_ns\": " << s.Quantile(0.9)
+            << ", \"p99_ns\": " << s.Quantile(0.99)
+            << ", \"buckets\": [";
+        // 只列出非空桶：[上界纳秒, 次数]
+        bool firstBucket = true;
+        for (size_t b = 0; b < s.buckets.size(); ++b) {
+            if (s.buckets[b] == 0) {
+                continue;
+            }
+            out << (firstBucket ? "" : ", ") << "[" << BucketBound(b) << ", " << s.buckets[b] << "]";
+            firstBucket = false;
+        }
+        out << "]}";
+        first = false;
+    }
+    out << (first ? "" : "\n  ") << "],\n  \"counters\": [";
+    first = true;
+    for (const auto& s : series) {
+        if (s.kind != Kind::Counter) {
+            continue;
+        }
+        out << (first ? "\n" : ",\n") << "    {\"name\": " << Quoted(s.name)
+            << ", \"value\": " << s.sum << ", \"updates\": " << s.count << "}";
+        first = false;
+    }
+    out << (first ? "" : "\n  ") << "]\n}\n";
+    return out.str();
+}
+
+string Metrics::ToPrometheus(const vector<Series>& series) {
+    ostringstream out;
+    out.precision(9);
+
+    out << "# HELP passmgr_span_seconds Duration of instrumented operations.\n"
+        << "# TYPE passmgr_span_seconds histogram\n";
+    for (const auto& s : series) {
+        if (s.kind != Kind::Span) {
+            continue;
+        }
+        const string label = "span=" + Quoted(s.name);
+        uint64_t cumulative = 0;
+        for (size_t b = 0; b + 1 < s.buckets.size(); ++b) {
+            cumulative += s.buckets[b];
+            out << "passmgr_span_seconds_bucket{" << label << ",le=\""
+                << static_cast<double>(BucketBound(b)) / 1e9 << "\"} " << cumulative << "\n";
+        }
+        out << "passmgr_span_seconds_bucket{" << label << ",le=\"+Inf\"} " << s.count << "\n"
+            << "passmgr_span_seconds_sum{" << label << "} " << static_cast<double>(s.sum) / 1e9 << "\n"
+            << "passmgr_span_seconds_count{" << label << "} " << s.count << "\n";
+    }
+
+    out << "# HELP passmgr_events_total Instrumented event counters.\n"
+        << "# TYPE passmgr_events_total counter\n";
+    for (const auto& s : series) {
+        if (s.kind == Kind::Counter) {
+            out << "passmgr_events_total{event=" << Quoted(s.name) << "} " << s.sum << "\n";
+        }
+    }
+    return out.str();
+}
+
+void Metrics::WriteFile(const string& path) {
+    const vector<Series> series = Snapshot();
+    const bool json = path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0;
+
+    ofstream out(path, ios::binary | ios::trunc);
+    if (!out) {
+        throw runtime_error("Cannot open metrics file: " + path);
+    }
+    out << (json ? ToJson(series) : ToPrometheus(series));
+    if (!out) {
+        throw runtime_error("Writing metrics file failed: " + path);
+    }
+}
+
+bool Metrics::Enabled() {
+#ifdef PASSMGR_ENABLE_METRICS
+    return true;
+#else
+    return false;
+#endif
+}
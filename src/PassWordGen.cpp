@@ -1,19 +1,42 @@
 #include "PassWordGen.h"
 #include <sodium.h>
+#include <algorithm>
+#include <cstdint>
 #include <stdexcept>
 
-const std::string PasswordGenerator::basic_charset = 
-    "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
-    "abcdefghijklmnopqrstuvwxyz"
-    "0123456789";
+namespace {
 
-const std::string PasswordGenerator::extended_charset = 
-    "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
-    "abcdefghijklmnopqrstuvwxyz"
-    "0123456789"
-    "!@#$%^&*()-_=+[]{}|;:,.<>?";
+constexpr Charset kBasicCharset(kBasicPolicy);
+constexpr Charset kExtendedCharset(kExtendedPolicy);
 
-PasswordGenerator::PasswordGenerator(size_t length) 
+// 大块随机字节缓冲：用完一块再整块补充，避免逐字符调用 randombytes_uniform
+class RandomPool {
+public:
+    explicit RandomPool(size_t capacity) : buffer_(capacity), pos_(capacity) {}
+    ~RandomPool() { sodium_memzero(buffer_.data(), buffer_.size()); }
+
+    uint8_t next() {
+        if (pos_ == buffer_.size()) {
+            randombytes_buf(buffer_.data(), buffer_.size());
+            pos_ = 0;
+        }
+        return buffer_[pos_++];
+    }
+
+private:
+    std::vector<uint8_t> buffer_;
+    size_t pos_;
+};
+
+size_t CountClasses(unsigned classes) {
+    size_t count = 0;
+    for (; classes; classes &= classes - 1) ++count;
+    return count;
+}
+
+} // namespace
+
+PasswordGenerator::PasswordGenerator(size_t length)
     : length_(length)
 {
     if (sodium_init() < 0) {
@@ -23,33 +46,57 @@ PasswordGenerator::PasswordGenerator(size_t length)
 
 std::string PasswordGenerator::generateBasic() const
 {
-    std::string password;
-    password.reserve(length_);
-    
-    const auto& charset = basic_charset;
-    const size_t charset_size = charset.size();
-    
-    //利用 libsodium: randombytes 生成随机密码
-    for (size_t i = 0; i < length_; ++i) {
-        uint32_t random_index = randombytes_uniform(charset_size);
-        password += charset[random_index];
-    }
-    
-    return password;
+    return generate(kBasicCharset);
 }
 
 std::string PasswordGenerator::generateExtended() const
 {
-    std::string password;
-    password.reserve(length_);
-    
-    const auto& charset = extended_charset;
+    return generate(kExtendedCharset);
+}
+
+std::string PasswordGenerator::generate(const Charset& charset) const
+{
+    return std::move(generateBatch(1, charset).front());
+}
+
+std::vector<std::string> PasswordGenerator::generateBatch(size_t count, const Charset& charset) const
+{
+    const CharsetPolicy& policy = charset.policy();
     const size_t charset_size = charset.size();
-    
-    for (size_t i = 0; i < length_; ++i) {
-        uint32_t random_index = randombytes_uniform(charset_size);
-        password += charset[random_index];
+    if (charset_size == 0) {
+        throw std::invalid_argument("字符集为空");
+    }
+    if ((policy.required & ~policy.classes) != 0) {
+        throw std::invalid_argument("必需的字符类别不在字符集中");
+    }
+    if (CountClasses(policy.required) > length_) {
+        throw std::invalid_argument("密码长度不足以包含所有必需的字符类别");
     }
-    
-    return password;
-}
\ No newline at end of file
+
+    // 拒绝采样：只接受 [0, limit) 内的字节，limit 是 charset_size 的整数倍，
+    // 取模后每个字符的概率完全相同
+    const unsigned limit = 256 - 256 % charset_size;
+
+    // 按期望消耗的字节数一次取足（上限 64 KiB，不够时再补充）
+    const size_t expected = count * length_ * 256 / limit + 64;
+    RandomPool pool(std::min<size_t>(expected, 64 * 1024));
+
+    std::vector<std::string> passwords(count);
+    for (auto& password : passwords) {
+        password.resize(length_);
+        unsigned seen = 0;
+        do {
+            seen = 0;
+            for (size_t i = 0; i < length_; ++i) {
+                uint8_t byte = pool.next();
+                while (byte >= limit) {
+                    byte = pool.next();
+                }
+                const size_t index = byte % charset_size;
+                password[i] = charset.at(index);
+                seen |= charset.classAt(index);
+            }
+        } while ((seen & policy.required) != policy.required);
+    }
+    return passwords;
+}
@@ -1,171 +1,320 @@
 #include "PassWordVault.h"
+#include "Metrics.h"
 #include <stdexcept>
 #include <algorithm>
 #include <cstdint>
+#include <cctype>
 #include <regex>
+#include <set>
 using namespace std;
 
+namespace {
+
+// 全文搜索时参与排序的候选条目数上限
+const int kSearchCandidates = 200;
+
+// 所有语句都经由这里执行，启用指标时逐次计时
+inline int Step(sqlite3_stmt* stmt) {
+    PASSMGR_SPAN("sqlite.vault.step");
+    return sqlite3_step(stmt);
+}
+
+string LowerAscii(string text) {
+    transform(text.begin(), text.end(), text.begin(),
+              [](unsigned char c) { return static_cast<char>(tolower(c)); });
+    return text;
+}
+
+} // namespace
+
 PasswordVault::PasswordVault(sqlite3* db) : db_(db) {
     if (!db_) {
         throw invalid_argument("Invalid database connection");
     }
+    statements_ = StatementCache::ForConnection(db_);
+    changes_ = ChangeBus::ForConnection(db_);
 }
 
-bool PasswordVault::CreateCodebook(const string& username, const string& name) {
+PasswordVault::Codebook PasswordVault::CreateCodebook(const string& username, const string& name,
+                                                      const string& created_time) {
     if (!ValidateCodebookName(name)) {
         throw invalid_argument("密码本名称不合法！（仅允许数字，字母，汉字和常用符号）");
     }
 
+    // 一条语句完成插入并取回新行；名称已存在时 DO NOTHING 不返回任何行
     const char* sql = R"(
-        INSERT INTO Codebook (username, codebook_name)
-        VALUES (?, ?)
+        INSERT INTO Codebook (username, codebook_name, created_time)
+        VALUES (?, ?, COALESCE(NULLIF(?, ''), CURRENT_TIMESTAMP))
         ON CONFLICT(username, codebook_name) DO NOTHING
+        RETURNING codebook_id, created_time
     )";
     
-    sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        throw runtime_error("Prepare failed: " + string(sqlite3_errmsg(db_)));
-    }
+    auto stmt = statements_->Prepare(sql);
 
     sqlite3_bind_text(stmt, 1, username.c_str(), -1, SQLITE_STATIC);
     sqlite3_bind_text(stmt, 2, name.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 3, created_time.c_str(), -1, SQLITE_STATIC);
     
-    bool success = sqlite3_step(stmt) == SQLITE_DONE;
-    sqlite3_finalize(stmt);
-    return success;
-}
-
-bool PasswordVault::DeleteCodebook(int codebook_id) {
-    if (!CheckCodebookExists(codebook_id)) {
-        return false;
+    Codebook created;
+    created.id = -1;
+    int rc = Step(stmt);
+    if (rc == SQLITE_ROW) {
+        created.id = sqlite3_column_int(stmt, 0);
+        created.name = name;
+        created.created_time = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+        created.modified_time = created.created_time;
+        // 必须执行到 SQLITE_DONE：停在 ROW 时直接复位虽会提交，但跳过 WAL 自动检查点，WAL 文件会无限增长
+        rc = Step(stmt);
     }
-
-    if (!BeginTransaction()) {
-        throw runtime_error("Failed to start transaction");
+    if (rc != SQLITE_DONE) {
+        throw runtime_error("Create codebook failed: " + string(sqlite3_errmsg(db_)));
     }
 
-    try {
-        // 删除关联条目
-        const char* deleteEntriesSql = "DELETE FROM PasswordEntry WHERE codebook_id = ?";
-        sqlite3_stmt* stmt;
-        
-        if (sqlite3_prepare_v2(db_, deleteEntriesSql, -1, &stmt, nullptr) != SQLITE_OK) {
-            RollbackTransaction();
-            throw runtime_error("Prepare failed: " + string(sqlite3_errmsg(db_)));
-        }
-        
-        sqlite3_bind_int(stmt, 1, codebook_id);
-        if (sqlite3_step(stmt) != SQLITE_DONE) {
-            sqlite3_finalize(stmt);
-            RollbackTransaction();
-            throw runtime_error("Delete entries failed: " + string(sqlite3_errmsg(db_)));
-        }
-        sqlite3_finalize(stmt);
+    if (created.id >= 0) {
+        PublishChanges();
+    }
+    return created;
+}
 
-        // 删除密码本
-        const char* deleteCodebookSql = "DELETE FROM Codebook WHERE codebook_id = ?";
-        if (sqlite3_prepare_v2(db_, deleteCodebookSql, -1, &stmt, nullptr) != SQLITE_OK) {
-            RollbackTransaction();
-            throw runtime_error("Prepare failed: " + string(sqlite3_errmsg(db_)));
-        }
-        
-        sqlite3_bind_int(stmt, 1, codebook_id);
-        if (sqlite3_step(stmt) != SQLITE_DONE) {
-            sqlite3_finalize(stmt);
-            RollbackTransaction();
-            throw runtime_error("Delete codebook failed: " + string(sqlite3_errmsg(db_)));
-        }
-        sqlite3_finalize(stmt);
+bool PasswordVault::DeleteCodebook(int codebook_id) {
+    // 条目、审计缓存与轮换检查点由外键 ON DELETE CASCADE 一并删除
+    const char* sql = "DELETE FROM Codebook WHERE codebook_id = ? RETURNING codebook_id";
+    auto stmt = statements_->Prepare(sql);
 
-        if (!CommitTransaction()) {
-            throw runtime_error("Commit failed: " + string(sqlite3_errmsg(db_)));
-        }
-        return true;
+    sqlite3_bind_int(stmt, 1, codebook_id);
+    int rc = Step(stmt);
+    const bool deleted = rc == SQLITE_ROW;
+    if (deleted) {
+        // 与 CreateCodebook 相同，执行到 SQLITE_DONE 才提交并触发 WAL 检查点
+        rc = Step(stmt);
+    }
+    if (rc != SQLITE_DONE) {
+        throw runtime_error("Delete codebook failed: " + string(sqlite3_errmsg(db_)));
+    }
 
-    } catch (...) {
-        RollbackTransaction();
-        throw;
+    if (deleted) {
+        PublishChanges();
     }
+    return deleted;
 }
 
 int PasswordVault::GetCodebookId(const std::string& username, const std::string& codebookName)
 {
     const char* sql = "SELECT codebook_id FROM Codebook WHERE username = ? AND codebook_name = ?";
-    sqlite3_stmt* stmt;
-    
-    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        throw std::runtime_error("Prepare failed: " + std::string(sqlite3_errmsg(db_)));
-    }
+    auto stmt = statements_->Prepare(sql);
     
     sqlite3_bind_text(stmt, 1, username.c_str(), -1, SQLITE_STATIC);
     sqlite3_bind_text(stmt, 2, codebookName.c_str(), -1, SQLITE_STATIC);
     
     int codebookId = -1;
-    if (sqlite3_step(stmt) == SQLITE_ROW) {
+    if (Step(stmt) == SQLITE_ROW) {
         codebookId = sqlite3_column_int(stmt, 0);
     }
     
-    sqlite3_finalize(stmt);
     return codebookId;
 }
 
 vector<PasswordVault::Codebook> PasswordVault::GetUserCodebooks(const string& username) const {
     const char* sql = R"(
-        SELECT codebook_id, codebook_name, created_time
+        SELECT codebook_id, codebook_name, created_time, updated_seq,
+               entry_count, total_bytes, COALESCE(modified_time, created_time)
         FROM Codebook
         WHERE username = ?
         ORDER BY created_time DESC
     )";
     
-    sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        throw runtime_error("Prepare failed: " + string(sqlite3_errmsg(db_)));
-    }
+    auto stmt = statements_->Prepare(sql);
 
     sqlite3_bind_text(stmt, 1, username.c_str(), -1, SQLITE_STATIC);
     
     vector<Codebook> codebooks;
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
+    while (Step(stmt) == SQLITE_ROW) {
         Codebook cb;
         cb.id = sqlite3_column_int(stmt, 0);
         cb.name = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
         cb.created_time = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
+        cb.updated_seq = sqlite3_column_int64(stmt, 3);
+        cb.entry_count = sqlite3_column_int(stmt, 4);
+        cb.total_bytes = sqlite3_column_int64(stmt, 5);
+        cb.modified_time = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 6));
         codebooks.push_back(cb);
     }
 
-    sqlite3_finalize(stmt);
     return codebooks;
 }
 
+bool PasswordVault::GetCodebookKey(int codebook_id, vector<uint8_t>& wrapped_key) {
+    const char* sql = "SELECT wrapped_key FROM Codebook WHERE codebook_id = ?";
+    auto stmt = statements_->Prepare(sql);
+
+    sqlite3_bind_int(stmt, 1, codebook_id);
+
+    bool found = false;
+    if (Step(stmt) == SQLITE_ROW && sqlite3_column_type(stmt, 0) != SQLITE_NULL) {
+        const void* blob_data = sqlite3_column_blob(stmt, 0);
+        int blob_size = sqlite3_column_bytes(stmt, 0);
+        wrapped_key.assign(static_cast<const uint8_t*>(blob_data), static_cast<const uint8_t*>(blob_data) + blob_size);
+        found = true;
+    }
+
+    return found;
+}
+
+bool PasswordVault::SetCodebookKey(int codebook_id, const vector<uint8_t>& wrapped_key) {
+    // 只在尚未设置时写入，避免并发打开同一密码本时互相覆盖
+    const char* sql = "UPDATE Codebook SET wrapped_key = ? WHERE codebook_id = ? AND wrapped_key IS NULL";
+    auto stmt = statements_->Prepare(sql);
+
+    sqlite3_bind_blob(stmt, 1, wrapped_key.data(), wrapped_key.size(), SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 2, codebook_id);
+
+    bool success = Step(stmt) == SQLITE_DONE;
+    int rowsAffected = sqlite3_changes(db_);
+    if (success && rowsAffected > 0) {
+        PublishChanges();
+    }
+    return success && rowsAffected > 0;
+}
+
+int PasswordVault::GetCodebookFormat(int codebook_id) {
+    auto stmt = statements_->Prepare("SELECT format_version FROM Codebook WHERE codebook_id = ?");
+    sqlite3_bind_int(stmt, 1, codebook_id);
+    return Step(stmt) == SQLITE_ROW ? sqlite3_column_int(stmt, 0) : 0;
+}
+
+bool PasswordVault::SetCodebookFormat(int codebook_id, int format_version) {
+    const char* sql = "UPDATE Codebook SET format_version = ?1 WHERE codebook_id = ?2 AND format_version IS NOT ?1";
+    auto stmt = statements_->Prepare(sql);
+
+    sqlite3_bind_int(stmt, 1, format_version);
+    sqlite3_bind_int(stmt, 2, codebook_id);
+    return Step(stmt) == SQLITE_DONE && sqlite3_changes(db_) > 0;
+}
+
+bool PasswordVault::HasCodebooksBelowFormat(const string& username, int format_version) {
+    const char* sql = "SELECT EXISTS(SELECT 1 FROM Codebook WHERE username = ? AND format_version < ?)";
+    auto stmt = statements_->Prepare(sql);
+
+    sqlite3_bind_text(stmt, 1, username.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 2, format_version);
+    return Step(stmt) == SQLITE_ROW && sqlite3_column_int(stmt, 0) != 0;
+}
+
 bool PasswordVault::AddEntry(int codebook_id,
     const std::string& address,
     const std::vector<uint8_t>& encrypted_password,
     const std::string& notes)
 {
-    const std::vector<uint8_t>& public_key = {1};
+    // public_key 列已不使用（密文自带记录头），写入空 BLOB 以满足 NOT NULL
     const char* sql = R"(
     INSERT INTO PasswordEntry 
     (codebook_id, address, public_key, encrypted_password, notes)
-    VALUES (?, ?, ?, ?, ?)
+    VALUES (?, ?, X'', ?, ?)
     )";
 
-    sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-    throw std::runtime_error("Prepare failed: " + std::string(sqlite3_errmsg(db_)));
-    }
+    auto stmt = statements_->Prepare(sql);
 
     // 正确绑定二进制数据 [关键修改]
     sqlite3_bind_int(stmt, 1, codebook_id);
     sqlite3_bind_text(stmt, 2, address.c_str(), -1, SQLITE_STATIC);
-    sqlite3_bind_blob(stmt, 3, public_key.data(), public_key.size(), SQLITE_STATIC);
-    sqlite3_bind_blob(stmt, 4, encrypted_password.data(), encrypted_password.size(), SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 5, notes.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_blob(stmt, 3, encrypted_password.data(), encrypted_password.size(), SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 4, notes.c_str(), -1, SQLITE_STATIC);
 
-    int rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
+    int rc = Step(stmt);
+    if (rc == SQLITE_DONE) {
+        PublishChanges();
+    }
     return rc == SQLITE_DONE;
 }
 
+vector<bool> PasswordVault::AddEntries(int codebook_id, const vector<PasswordEntry>& entries) {
+    vector<bool> inserted(entries.size(), false);
+    if (entries.empty()) {
+        return inserted;
+    }
+
+    if (!BeginTransaction()) {
+        throw runtime_error("Failed to start transaction");
+    }
+
+    try {
+        const char* sql = R"(
+        INSERT INTO PasswordEntry 
+        (codebook_id, address, public_key, encrypted_password, notes, created_time)
+        VALUES (?, ?, X'', ?, ?, COALESCE(NULLIF(?, ''), CURRENT_TIMESTAMP))
+        )";
+        auto stmt = statements_->Prepare(sql);
+
+        sqlite3_bind_int(stmt, 1, codebook_id);
+        for (size_t i = 0; i < entries.size(); ++i) {
+            const auto& entry = entries[i];
+            sqlite3_bind_text(stmt, 2, entry.address.c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_blob(stmt, 3, entry.encrypted_password.data(), entry.encrypted_password.size(), SQLITE_STATIC);
+            sqlite3_bind_text(stmt, 4, entry.notes.c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_text(stmt, 5, entry.created_time.c_str(), -1, SQLITE_STATIC);
+
+            // 约束错误只作用于当前语句，事务保持有效
+            const int rc = Step(stmt);
+            if (rc != SQLITE_DONE && sqlite3_get_autocommit(db_)) {
+                throw runtime_error("Insert entry failed: " + string(sqlite3_errmsg(db_)));
+            }
+            inserted[i] = rc == SQLITE_DONE;
+            sqlite3_reset(stmt);
+        }
+
+        if (!CommitTransaction()) {
+            throw runtime_error("Commit failed: " + string(sqlite3_errmsg(db_)));
+        }
+        PublishChanges();
+        return inserted;
+
+    } catch (...) {
+        RollbackTransaction();
+        throw;
+    }
+}
+
+size_t PasswordVault::UpdateEncryptedPasswords(const vector<RotatedBlob>& blobs) {
+    if (blobs.empty()) {
+        return 0;
+    }
+
+    if (!BeginTransaction()) {
+        throw runtime_error("Failed to start transaction");
+    }
+
+    try {
+        // 与 CommitRotationBatch 相同，只替换仍是读取时密文的条目，不覆盖期间的修改
+        const char* sql = "UPDATE PasswordEntry SET encrypted_password = ?1 WHERE entry_id = ?2 AND encrypted_password = ?3";
+        auto stmt = statements_->Prepare(sql);
+
+        size_t updated = 0;
+        for (const auto& blob : blobs) {
+            sqlite3_bind_blob(stmt, 1, blob.encrypted_password.data(), static_cast<int>(blob.encrypted_password.size()), SQLITE_STATIC);
+            sqlite3_bind_int(stmt, 2, blob.entry_id);
+            sqlite3_bind_blob(stmt, 3, blob.previous.data(), static_cast<int>(blob.previous.size()), SQLITE_STATIC);
+            const int rc = Step(stmt);
+            sqlite3_reset(stmt);
+            if (rc != SQLITE_DONE) {
+                throw runtime_error("Update entry failed: " + string(sqlite3_errmsg(db_)));
+            }
+            updated += static_cast<size_t>(sqlite3_changes(db_));
+        }
+
+        if (!CommitTransaction()) {
+            throw runtime_error("Commit failed: " + string(sqlite3_errmsg(db_)));
+        }
+        if (updated > 0) {
+            PublishChanges();
+        }
+        return updated;
+
+    } catch (...) {
+        RollbackTransaction();
+        throw;
+    }
+}
+
 bool PasswordVault::DeleteEntry(int entry_id) {
     if (!BeginTransaction()) {
         throw std::runtime_error("Failed to start transaction");
@@ -173,27 +322,24 @@ bool PasswordVault::DeleteEntry(int entry_id) {
 
     try {
         // 删除条目
-        sqlite3_stmt* stmt;
         const char* sql = "DELETE FROM PasswordEntry WHERE entry_id = ?";
-        
-        if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-            throw std::runtime_error("Prepare failed: " + std::string(sqlite3_errmsg(db_)));
-        }
+        auto stmt = statements_->Prepare(sql);
         
         sqlite3_bind_int(stmt, 1, entry_id);
-        if (sqlite3_step(stmt) != SQLITE_DONE) {
-            sqlite3_finalize(stmt);
+        if (Step(stmt) != SQLITE_DONE) {
             RollbackTransaction();
             throw std::runtime_error("Delete entry failed: " + std::string(sqlite3_errmsg(db_)));
         }
         
-        sqlite3_finalize(stmt);
-        
         if (!CommitTransaction()) {
             throw std::runtime_error("Commit failed: " + std::string(sqlite3_errmsg(db_)));
         }
         
-        return sqlite3_changes(db_) > 0;
+        const bool deleted = sqlite3_changes(db_) > 0;
+        if (deleted) {
+            PublishChanges();
+        }
+        return deleted;
 
     } catch (...) {
         RollbackTransaction();
@@ -201,117 +347,714 @@ bool PasswordVault::DeleteEntry(int entry_id) {
     }
 }
 
-vector<PasswordVault::PasswordEntry> PasswordVault::GetEntries(int codebook_id, 
-                                                             const string& filter,
-                                                             int page, 
-                                                             int page_size) 
+PasswordVault::EntryPage PasswordVault::GetEntries(int codebook_id, 
+                                                 const string& filter,
+                                                 int after_id, 
+                                                 int page_size) 
 {
+    // 键集分页：沿 idx_codebook(codebook_id, entry_id) 定位，任意一页的代价与第一页相同
     const char* sql = R"(
-        SELECT entry_id, address, public_key, encrypted_password, notes, created_time
+        SELECT entry_id, address, encrypted_password, notes, created_time
         FROM PasswordEntry
-        WHERE codebook_id = ? 
+        WHERE codebook_id = ?1 AND entry_id > ?2
+          AND (?3 = '' OR address LIKE ?4 ESCAPE '\' OR notes LIKE ?4 ESCAPE '\')
+        ORDER BY entry_id
+        LIMIT ?5
     )";
 
-    sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        throw runtime_error("Prepare failed: " + string(sqlite3_errmsg(db_)));
+    auto stmt = statements_->Prepare(sql);
+    BindEntryQuery(stmt, codebook_id, filter, after_id, page_size);
+
+    EntryPage page;
+    while (Step(stmt) == SQLITE_ROW) {
+        if (static_cast<int>(page.entries.size()) == page_size) {
+            page.has_more = true;
+            break;
+        }
+
+        PasswordEntry entry;
+        entry.id = sqlite3_column_int(stmt, 0);
+        entry.address = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+        const void* blob_data = sqlite3_column_blob(stmt, 2);
+        int blob_size = sqlite3_column_bytes(stmt, 2);
+        entry.encrypted_password.assign(static_cast<const unsigned char*>(blob_data), static_cast<const unsigned char*>(blob_data) + blob_size);
+        const unsigned char* notes = sqlite3_column_text(stmt, 3);
+        entry.notes = notes ? reinterpret_cast<const char*>(notes) : "";
+        entry.created_time = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 4));
+        page.entries.push_back(entry);
     }
 
-    string filter_pattern = "%" + filter + "%";
-    int offset = page * page_size;
+    page.next_after_id = page.entries.empty() ? after_id : page.entries.back().id;
+    return page;
+}
 
-    sqlite3_bind_int(stmt, 1, codebook_id);
-    sqlite3_bind_text(stmt, 2, filter_pattern.c_str(), -1, SQLITE_STATIC);
-    sqlite3_bind_int(stmt, 3, page_size);
-    sqlite3_bind_int(stmt, 4, offset);
+PasswordVault::EntryPage PasswordVault::GetEntrySummaries(int codebook_id,
+                                                        const string& filter,
+                                                        int after_id,
+                                                        int page_size) {
+    const char* sql = R"(
+        SELECT entry_id, address, notes, created_time
+        FROM PasswordEntry
+        WHERE codebook_id = ?1 AND entry_id > ?2
+          AND (?3 = '' OR address LIKE ?4 ESCAPE '\' OR notes LIKE ?4 ESCAPE '\')
+        ORDER BY entry_id
+        LIMIT ?5
+    )";
+
+    auto stmt = statements_->Prepare(sql);
+    BindEntryQuery(stmt, codebook_id, filter, after_id, page_size);
+
+    EntryPage page;
+    while (Step(stmt) == SQLITE_ROW) {
+        if (static_cast<int>(page.entries.size()) == page_size) {
+            page.has_more = true;
+            break;
+        }
 
-    vector<PasswordEntry> entries;
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
         PasswordEntry entry;
         entry.id = sqlite3_column_int(stmt, 0);
         entry.address = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-        entry.public_key = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
-        const void* blob_data = sqlite3_column_blob(stmt, 3);
-        int blob_size = sqlite3_column_bytes(stmt, 3);
-        entry.encrypted_password.assign(static_cast<const unsigned char*>(blob_data), static_cast<const unsigned char*>(blob_data) + blob_size);
-        entry.notes = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 4));
-        entry.created_time = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 5));
-        entries.push_back(entry);
+        const unsigned char* notes = sqlite3_column_text(stmt, 2);
+        entry.notes = notes ? reinterpret_cast<const char*>(notes) : "";
+        entry.created_time = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
+        page.entries.push_back(entry);
+    }
+
+    page.next_after_id = page.entries.empty() ? after_id : page.entries.back().id;
+    return page;
+}
+
+vector<PasswordVault::PasswordEntry> PasswordVault::Search(int codebook_id, const string& query, int limit) {
+    if (limit <= 0) {
+        throw invalid_argument("Search limit must be positive");
+    }
+
+    const size_t begin = query.find_first_not_of(" \t");
+    const string trimmed = begin == string::npos
+        ? string() : query.substr(begin, query.find_last_not_of(" \t") - begin + 1);
+    const size_t characters = count_if(trimmed.begin(), trimmed.end(),
+                                       [](char c) { return (static_cast<unsigned char>(c) & 0xC0) != 0x80; });
+    if (characters < 3 || !HasSearchIndex()) {
+        return GetEntrySummaries(codebook_id, trimmed, 0, limit).entries;
+    }
+
+    // 整个查询作为一个短语：trigram 分词下等价于（不区分大小写的）子串匹配
+    string phrase = "\"";
+    for (char c : trimmed) {
+        phrase += c;
+        if (c == '"') phrase += '"';
+    }
+    phrase += '"';
+
+    // bm25 需要逐行读取短语位置，命中数万行时要上百毫秒；这里先查地址列、
+    // 不足 limit 条再查备注列，每次只取最新的一批候选，在内存中按命中位置排序
+    const char* sql = R"(
+        SELECT e.entry_id, e.address, e.notes, e.created_time
+        FROM PasswordEntryFts f
+        JOIN PasswordEntry e ON e.entry_id = f.rowid
+        WHERE PasswordEntryFts MATCH ?1 AND e.codebook_id = ?2
+        ORDER BY f.rowid DESC
+        LIMIT ?3
+    )";
+
+    const string needle = LowerAscii(trimmed);
+    vector<pair<int, PasswordEntry>> ranked;
+    set<int> seen;
+    for (const char* column : {"{address} : ", "{notes} : "}) {
+        if (static_cast<int>(ranked.size()) >= limit) {
+            break;
+        }
+
+        auto stmt = statements_->Prepare(sql);
+        sqlite3_bind_text(stmt, 1, (column + phrase).c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_int(stmt, 2, codebook_id);
+        sqlite3_bind_int(stmt, 3, max(limit, kSearchCandidates));
+
+        while (Step(stmt) == SQLITE_ROW) {
+            PasswordEntry entry;
+            entry.id = sqlite3_column_int(stmt, 0);
+            entry.address = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+            const unsigned char* notes = sqlite3_column_text(stmt, 2);
+            entry.notes = notes ? reinterpret_cast<const char*>(notes) : "";
+            entry.created_time = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
+
+            // 0: 地址以查询开头（忽略协议和 www.） 1: 地址包含 2: 仅备注命中
+            const string address = LowerAscii(entry.address);
+            size_t host = address.find("://");
+            host = host == string::npos ? 0 : host + 3;
+            if (address.compare(host, 4, "www.") == 0) host += 4;
+            const size_t pos = address.find(needle);
+            const int score = pos == host ? 0 : pos != string::npos ? 1 : 2;
+
+            // 地址和备注都命中的条目已在第一轮出现
+            if (!seen.insert(entry.id).second) {
+                continue;
+            }
+            ranked.emplace_back(score, move(entry));
+        }
+    }
+
+    stable_sort(ranked.begin(), ranked.end(),
+                [](const pair<int, PasswordEntry>& a, const pair<int, PasswordEntry>& b) { return a.first < b.first; });
+    vector<PasswordEntry> results;
+    for (size_t i = 0; i < ranked.size() && static_cast<int>(i) < limit; ++i) {
+        results.push_back(move(ranked[i].second));
+    }
+    return results;
+}
+
+PasswordVault::AuditPage PasswordVault::GetAuditRecords(int codebook_id, int after_id, int page_size) {
+    // 按密码本分页可以沿 idx_codebook 顺序读取；跨密码本按 entry_id 排序则每页都要重新排序剩余条目
+    const char* sql = R"(
+        SELECT e.entry_id, e.codebook_id, e.address, e.encrypted_password,
+               a.blob_hash, a.key_tag, a.breach_tag, a.sealed_result
+        FROM PasswordEntry e
+        LEFT JOIN AuditCache a ON a.entry_id = e.entry_id
+        WHERE e.codebook_id = ?1 AND e.entry_id > ?2
+        ORDER BY e.entry_id
+        LIMIT ?3
+    )";
+
+    auto stmt = statements_->Prepare(sql);
+    sqlite3_bind_int(stmt, 1, codebook_id);
+    sqlite3_bind_int(stmt, 2, after_id);
+    sqlite3_bind_int(stmt, 3, page_size + 1);
+
+    auto column_blob = [&stmt](int column) {
+        const auto* data = static_cast<const uint8_t*>(sqlite3_column_blob(stmt, column));
+        return data ? vector<uint8_t>(data, data + sqlite3_column_bytes(stmt, column)) : vector<uint8_t>();
+    };
+
+    AuditPage page;
+    while (Step(stmt) == SQLITE_ROW) {
+        if (static_cast<int>(page.records.size()) == page_size) {
+            page.has_more = true;
+            break;
+        }
+
+        AuditRecord record;
+        record.entry_id = sqlite3_column_int(stmt, 0);
+        record.codebook_id = sqlite3_column_int(stmt, 1);
+        record.address = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
+        record.encrypted_password = column_blob(3);
+        record.cached = sqlite3_column_type(stmt, 4) != SQLITE_NULL;
+        if (record.cached) {
+            record.blob_hash = column_blob(4);
+            record.key_tag = column_blob(5);
+            record.breach_tag = column_blob(6);
+            record.sealed_result = column_blob(7);
+        }
+        page.records.push_back(move(record));
+    }
+
+    page.next_after_id = page.records.empty() ? after_id : page.records.back().entry_id;
+    return page;
+}
+
+bool PasswordVault::SaveAuditRecords(const vector<AuditRecord>& records) {
+    if (records.empty()) {
+        return true;
+    }
+
+    if (!BeginTransaction()) {
+        throw runtime_error("Failed to start transaction");
     }
 
-    sqlite3_finalize(stmt);
-    return entries;
+    try {
+        const char* sql = R"(
+            INSERT INTO AuditCache (entry_id, blob_hash, key_tag, breach_tag, sealed_result)
+            VALUES (?1, ?2, ?3, ?4, ?5)
+            ON CONFLICT(entry_id) DO UPDATE SET
+                blob_hash = excluded.blob_hash,
+                key_tag = excluded.key_tag,
+                breach_tag = excluded.breach_tag,
+                sealed_result = excluded.sealed_result
+        )";
+        auto stmt = statements_->Prepare(sql);
+
+        for (const auto& record : records) {
+            sqlite3_bind_int(stmt, 1, record.entry_id);
+            sqlite3_bind_blob(stmt, 2, record.blob_hash.data(), static_cast<int>(record.blob_hash.size()), SQLITE_STATIC);
+            sqlite3_bind_blob(stmt, 3, record.key_tag.data(), static_cast<int>(record.key_tag.size()), SQLITE_STATIC);
+            if (record.breach_tag.empty()) {
+                sqlite3_bind_null(stmt, 4);
+            } else {
+                sqlite3_bind_blob(stmt, 4, record.breach_tag.data(), static_cast<int>(record.breach_tag.size()), SQLITE_STATIC);
+            }
+            sqlite3_bind_blob(stmt, 5, record.sealed_result.data(), static_cast<int>(record.sealed_result.size()), SQLITE_STATIC);
+
+            // 外键失败说明条目在审计期间已被删除，跳过即可
+            const int rc = Step(stmt);
+            sqlite3_reset(stmt);
+            if (rc != SQLITE_DONE && (rc & 0xFF) != SQLITE_CONSTRAINT) {
+                throw runtime_error("Save audit cache failed: " + string(sqlite3_errmsg(db_)));
+            }
+        }
+
+        if (!CommitTransaction()) {
+            throw runtime_error("Commit failed: " + string(sqlite3_errmsg(db_)));
+        }
+        return true;
+
+    } catch (...) {
+        RollbackTransaction();
+        throw;
+    }
+}
+
+void PasswordVault::BeginKeyRotation(const string& username,
+                                     const string& password_hash,
+                                     const vector<uint8_t>& kdf_salt,
+                                     const vector<uint8_t>& kdf_params,
+                                     const vector<CodebookRotation>& codebooks) {
+    if (!BeginTransaction()) {
+        throw runtime_error("Failed to start transaction");
+    }
+
+    try {
+        {
+            const char* sql = "UPDATE User SET password_hash = ?, kdf_salt = ?, kdf_params = ? WHERE username = ?";
+            auto stmt = statements_->Prepare(sql);
+            sqlite3_bind_text(stmt, 1, password_hash.c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_blob(stmt, 2, kdf_salt.data(), static_cast<int>(kdf_salt.size()), SQLITE_STATIC);
+            sqlite3_bind_blob(stmt, 3, kdf_params.data(), static_cast<int>(kdf_params.size()), SQLITE_STATIC);
+            sqlite3_bind_text(stmt, 4, username.c_str(), -1, SQLITE_STATIC);
+            if (Step(stmt) != SQLITE_DONE || sqlite3_changes(db_) != 1) {
+                throw runtime_error("Update user failed: " + string(sqlite3_errmsg(db_)));
+            }
+        }
+
+        {
+            const char* sql = R"(
+                UPDATE Codebook SET wrapped_key = ?, previous_wrapped_key = ?
+                WHERE codebook_id = ? AND username = ?
+            )";
+            auto stmt = statements_->Prepare(sql);
+            auto checkpoint = statements_->Prepare(
+                "INSERT OR REPLACE INTO KeyRotation (codebook_id, last_entry_id) VALUES (?, 0)");
+
+            for (const auto& codebook : codebooks) {
+                sqlite3_bind_blob(stmt, 1, codebook.wrapped_key.data(), static_cast<int>(codebook.wrapped_key.size()), SQLITE_STATIC);
+                sqlite3_bind_blob(stmt, 2, codebook.previous_wrapped_key.data(), static_cast<int>(codebook.previous_wrapped_key.size()), SQLITE_STATIC);
+                sqlite3_bind_int(stmt, 3, codebook.codebook_id);
+                sqlite3_bind_text(stmt, 4, username.c_str(), -1, SQLITE_STATIC);
+                const int rc = Step(stmt);
+                sqlite3_reset(stmt);
+                if (rc != SQLITE_DONE || sqlite3_changes(db_) != 1) {
+                    throw runtime_error("Update codebook key failed: " + string(sqlite3_errmsg(db_)));
+                }
+
+                sqlite3_bind_int(checkpoint, 1, codebook.codebook_id);
+                const int checkpointRc = Step(checkpoint);
+                sqlite3_reset(checkpoint);
+                if (checkpointRc != SQLITE_DONE) {
+                    throw runtime_error("Create rotation checkpoint failed: " + string(sqlite3_errmsg(db_)));
+                }
+            }
+        }
+
+        // 准备期间其他窗口可能为新打开的密码本写入了旧会话密钥包裹的数据密钥，
+        // 提交后将无法解包，放弃本次修改
+        {
+            const char* sql = "SELECT COUNT(*) FROM Codebook WHERE username = ? AND wrapped_key IS NOT NULL";
+            auto stmt = statements_->Prepare(sql);
+            sqlite3_bind_text(stmt, 1, username.c_str(), -1, SQLITE_STATIC);
+            if (Step(stmt) != SQLITE_ROW ||
+                sqlite3_column_int(stmt, 0) != static_cast<int>(codebooks.size())) {
+                throw runtime_error("Codebooks changed during key rotation");
+            }
+        }
+
+        if (!CommitTransaction()) {
+            throw runtime_error("Commit failed: " + string(sqlite3_errmsg(db_)));
+        }
+        PublishChanges();
+
+    } catch (...) {
+        RollbackTransaction();
+        throw;
+    }
+}
+
+bool PasswordVault::GetPreviousCodebookKey(int codebook_id, vector<uint8_t>& wrapped_key) {
+    const char* sql = "SELECT previous_wrapped_key FROM Codebook WHERE codebook_id = ?";
+    auto stmt = statements_->Prepare(sql);
+
+    sqlite3_bind_int(stmt, 1, codebook_id);
+
+    bool found = false;
+    if (Step(stmt) == SQLITE_ROW && sqlite3_column_type(stmt, 0) != SQLITE_NULL) {
+        const uint8_t* blob_data = static_cast<const uint8_t*>(sqlite3_column_blob(stmt, 0));
+        wrapped_key.assign(blob_data, blob_data + sqlite3_column_bytes(stmt, 0));
+        found = true;
+    }
+
+    return found;
+}
+
+vector<PasswordVault::RotationCheckpoint> PasswordVault::GetRotationCheckpoints(const string& username) {
+    const char* sql = R"(
+        SELECT r.codebook_id, r.last_entry_id,
+               (SELECT COUNT(*) FROM PasswordEntry e
+                WHERE e.codebook_id = r.codebook_id AND e.entry_id > r.last_entry_id)
+        FROM KeyRotation r
+        JOIN Codebook c ON c.codebook_id = r.codebook_id
+        WHERE c.username = ?
+        ORDER BY r.codebook_id
+    )";
+    auto stmt = statements_->Prepare(sql);
+    sqlite3_bind_text(stmt, 1, username.c_str(), -1, SQLITE_STATIC);
+
+    vector<RotationCheckpoint> checkpoints;
+    while (Step(stmt) == SQLITE_ROW) {
+        RotationCheckpoint checkpoint;
+        checkpoint.codebook_id = sqlite3_column_int(stmt, 0);
+        checkpoint.last_entry_id = sqlite3_column_int(stmt, 1);
+        checkpoint.remaining = sqlite3_column_int(stmt, 2);
+        checkpoints.push_back(checkpoint);
+    }
+    return checkpoints;
+}
+
+size_t PasswordVault::CommitRotationBatch(int codebook_id, const vector<RotatedBlob>& blobs, int last_entry_id) {
+    if (!BeginTransaction()) {
+        throw runtime_error("Failed to start transaction");
+    }
+
+    try {
+        // 只替换仍是读取时密文的条目：重新加密期间被修改的条目已由新数据密钥写入
+        const char* sql = R"(
+            UPDATE PasswordEntry SET encrypted_password = ?1
+            WHERE entry_id = ?2 AND codebook_id = ?3 AND encrypted_password = ?4
+        )";
+        auto stmt = statements_->Prepare(sql);
+
+        size_t updated = 0;
+        for (const auto& blob : blobs) {
+            sqlite3_bind_blob(stmt, 1, blob.encrypted_password.data(), static_cast<int>(blob.encrypted_password.size()), SQLITE_STATIC);
+            sqlite3_bind_int(stmt, 2, blob.entry_id);
+            sqlite3_bind_int(stmt, 3, codebook_id);
+            sqlite3_bind_blob(stmt, 4, blob.previous.data(), static_cast<int>(blob.previous.size()), SQLITE_STATIC);
+            const int rc = Step(stmt);
+            sqlite3_reset(stmt);
+            if (rc != SQLITE_DONE) {
+                throw runtime_error("Update entry failed: " + string(sqlite3_errmsg(db_)));
+            }
+            updated += static_cast<size_t>(sqlite3_changes(db_));
+        }
+
+        auto checkpoint = statements_->Prepare(
+            "UPDATE KeyRotation SET last_entry_id = ? WHERE codebook_id = ?");
+        sqlite3_bind_int(checkpoint, 1, last_entry_id);
+        sqlite3_bind_int(checkpoint, 2, codebook_id);
+        if (Step(checkpoint) != SQLITE_DONE) {
+            throw runtime_error("Update rotation checkpoint failed: " + string(sqlite3_errmsg(db_)));
+        }
+
+        if (!CommitTransaction()) {
+            throw runtime_error("Commit failed: " + string(sqlite3_errmsg(db_)));
+        }
+        if (updated > 0) {
+            PublishChanges();
+        }
+        return updated;
+
+    } catch (...) {
+        RollbackTransaction();
+        throw;
+    }
+}
+
+bool PasswordVault::CompleteCodebookRotation(int codebook_id) {
+    if (!BeginTransaction()) {
+        throw runtime_error("Failed to start transaction");
+    }
+
+    try {
+        auto clear = statements_->Prepare("UPDATE Codebook SET previous_wrapped_key = NULL WHERE codebook_id = ?");
+        sqlite3_bind_int(clear, 1, codebook_id);
+        if (Step(clear) != SQLITE_DONE) {
+            throw runtime_error("Clear previous key failed: " + string(sqlite3_errmsg(db_)));
+        }
+
+        auto remove = statements_->Prepare("DELETE FROM KeyRotation WHERE codebook_id = ?");
+        sqlite3_bind_int(remove, 1, codebook_id);
+        if (Step(remove) != SQLITE_DONE) {
+            throw runtime_error("Delete rotation checkpoint failed: " + string(sqlite3_errmsg(db_)));
+        }
+
+        if (!CommitTransaction()) {
+            throw runtime_error("Commit failed: " + string(sqlite3_errmsg(db_)));
+        }
+        return true;
+
+    } catch (...) {
+        RollbackTransaction();
+        throw;
+    }
+}
+
+int64_t PasswordVault::CurrentSeq() {
+    auto stmt = statements_->Prepare("SELECT value FROM ChangeSeq WHERE id = 0");
+    return Step(stmt) == SQLITE_ROW ? sqlite3_column_int64(stmt, 0) : 0;
+}
+
+PasswordVault::ChangeSet PasswordVault::GetChangesSince(int codebook_id, int64_t seq) {
+    // 先取序号再查差量：期间提交的写入可能已包含在结果中，下次会被重复返回，但不会遗漏
+    ChangeSet changes;
+    changes.seq = CurrentSeq();
+    if (changes.seq <= seq) {
+        return changes;
+    }
+
+    {
+        // 起点之后的墓碑可能已被清理，无法得到完整的删除列表
+        auto stmt = statements_->Prepare("SELECT tombstone_seq FROM Codebook WHERE codebook_id = ?");
+        sqlite3_bind_int(stmt, 1, codebook_id);
+        if (Step(stmt) == SQLITE_ROW && seq < sqlite3_column_int64(stmt, 0)) {
+            changes.complete = false;
+            return changes;
+        }
+    }
+
+    {
+        const char* sql = R"(
+            SELECT entry_id, address, notes, created_time
+            FROM PasswordEntry
+            WHERE codebook_id = ? AND updated_seq > ?
+            ORDER BY entry_id
+        )";
+        auto stmt = statements_->Prepare(sql);
+        sqlite3_bind_int(stmt, 1, codebook_id);
+        sqlite3_bind_int64(stmt, 2, seq);
+
+        while (Step(stmt) == SQLITE_ROW) {
+            PasswordEntry entry;
+            entry.id = sqlite3_column_int(stmt, 0);
+            entry.address = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+            const unsigned char* notes = sqlite3_column_text(stmt, 2);
+            entry.notes = notes ? reinterpret_cast<const char*>(notes) : "";
+            entry.created_time = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
+            changes.changed.push_back(move(entry));
+        }
+    }
+
+    const char* sql = "SELECT entry_id FROM PasswordEntryTombstone WHERE codebook_id = ? AND deleted_seq > ?";
+    auto stmt = statements_->Prepare(sql);
+    sqlite3_bind_int(stmt, 1, codebook_id);
+    sqlite3_bind_int64(stmt, 2, seq);
+    while (Step(stmt) == SQLITE_ROW) {
+        changes.deleted.push_back(sqlite3_column_int(stmt, 0));
+    }
+    return changes;
+}
+
+void PasswordVault::PublishChanges() {
+    // 处于外层事务中时尚未提交，由外层（连接池写线程）提交后统一发布
+    if (!sqlite3_get_autocommit(db_)) {
+        return;
+    }
+    changes_->Publish(CurrentSeq());
+}
+
+bool PasswordVault::HasSearchIndex() {
+    if (has_search_index_ < 0) {
+        auto stmt = statements_->Prepare(
+            "SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = 'PasswordEntryFts'");
+        has_search_index_ = Step(stmt) == SQLITE_ROW ? 1 : 0;
+    }
+    return has_search_index_ == 1;
+}
+
+int PasswordVault::CountEntries(int codebook_id, const string& filter) {
+    const char* sql = R"(
+        SELECT COUNT(*)
+        FROM PasswordEntry
+        WHERE codebook_id = ?1
+          AND (?2 = '' OR address LIKE ?3 ESCAPE '\' OR notes LIKE ?3 ESCAPE '\')
+    )";
+
+    auto stmt = statements_->Prepare(sql);
+
+    const string filter_pattern = "%" + EscapeLikePattern(filter) + "%";
+    sqlite3_bind_int(stmt, 1, codebook_id);
+    sqlite3_bind_text(stmt, 2, filter.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 3, filter_pattern.c_str(), -1, SQLITE_TRANSIENT);
+
+    int count = 0;
+    if (Step(stmt) == SQLITE_ROW) {
+        count = sqlite3_column_int(stmt, 0);
+    }
+    return count;
+}
+
+void PasswordVault::BindEntryQuery(sqlite3_stmt* stmt, int codebook_id, const string& filter,
+                                   int after_id, int page_size) {
+    if (page_size <= 0) {
+        throw invalid_argument("Page size must be positive");
+    }
+
+    // 多取一行用于判断是否还有下一页
+    const string filter_pattern = "%" + EscapeLikePattern(filter) + "%";
+    sqlite3_bind_int(stmt, 1, codebook_id);
+    sqlite3_bind_int(stmt, 2, after_id);
+    sqlite3_bind_text(stmt, 3, filter.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 4, filter_pattern.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int(stmt, 5, page_size + 1);
+}
+
+string PasswordVault::EscapeLikePattern(const string& text) {
+    string escaped;
+    escaped.reserve(text.size());
+    for (char c : text) {
+        if (c == '%' || c == '_' || c == '\\') {
+            escaped += '\\';
+        }
+        escaped += c;
+    }
+    return escaped;
+}
+
+bool PasswordVault::GetEncryptedPassword(int entry_id, vector<uint8_t>& encrypted_password) {
+    return VisitEncryptedPassword(entry_id, [&encrypted_password](int, const uint8_t* blob, size_t size) {
+        encrypted_password.assign(blob, blob + size);
+    });
+}
+
+bool PasswordVault::VisitEncryptedPassword(int entry_id, const BlobVisitor& visit) {
+    const char* sql = "SELECT encrypted_password FROM PasswordEntry WHERE entry_id = ?";
+    auto stmt = statements_->Prepare(sql);
+
+    sqlite3_bind_int(stmt, 1, entry_id);
+
+    if (Step(stmt) != SQLITE_ROW) {
+        return false;
+    }
+    visit(entry_id, static_cast<const uint8_t*>(sqlite3_column_blob(stmt, 0)),
+          static_cast<size_t>(sqlite3_column_bytes(stmt, 0)));
+    return true;
+}
+
+PasswordVault::BlobPage PasswordVault::VisitEntryBlobs(int codebook_id, const BlobVisitor& visit,
+                                                       int after_id, int page_size) {
+    // 与 GetEntries 相同的键集分页，多取一行判断是否还有下一页
+    const char* sql = R"(
+        SELECT entry_id, encrypted_password
+        FROM PasswordEntry
+        WHERE codebook_id = ? AND entry_id > ?
+        ORDER BY entry_id
+        LIMIT ?
+    )";
+    auto stmt = statements_->Prepare(sql);
+    sqlite3_bind_int(stmt, 1, codebook_id);
+    sqlite3_bind_int(stmt, 2, after_id);
+    sqlite3_bind_int(stmt, 3, page_size + 1);
+
+    BlobPage page;
+    page.next_after_id = after_id;
+    int visited = 0;
+    while (Step(stmt) == SQLITE_ROW) {
+        if (visited == page_size) {
+            page.has_more = true;
+            break;
+        }
+
+        // sqlite3_column_blob 返回的指针在下一次 step 前有效，回调中直接使用
+        const int entry_id = sqlite3_column_int(stmt, 0);
+        visit(entry_id, static_cast<const uint8_t*>(sqlite3_column_blob(stmt, 1)),
+              static_cast<size_t>(sqlite3_column_bytes(stmt, 1)));
+        page.next_after_id = entry_id;
+        ++visited;
+    }
+    return page;
 }
 
 bool PasswordVault::UpdateEntry(int entry_id,
     const std::string& new_address,
-    const std::string& new_public_key,
-    const std::string& new_encrypted_password,
+    const std::vector<uint8_t>& new_encrypted_password,
     const std::string& new_notes) 
 {
     // 验证输入参数
     if (new_address.empty() || new_address.length() > 253) {
         throw std::invalid_argument("Address must be 1-253 characters");
     }
-    if (new_public_key.empty() || new_public_key.length() > 4096) {
-        throw std::invalid_argument("Public key is invalid");
-    }
-    if (new_encrypted_password.empty() || new_encrypted_password.length() > 512) {
+    if (new_encrypted_password.empty() || new_encrypted_password.size() > 512) {
         throw std::invalid_argument("Encrypted password is invalid");
     }
 
     const char* sql = R"(
         UPDATE PasswordEntry SET
         address = ?,
-        public_key = ?,
+        public_key = X'',
         encrypted_password = ?,
         notes = ?
         WHERE entry_id = ?
         )";
 
-    sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        throw std::runtime_error("Prepare failed: " + std::string(sqlite3_errmsg(db_)));
-    }
+    auto stmt = statements_->Prepare(sql);
 
-    // 绑定参数
+    // 密文必须按 BLOB 绑定：按文本绑定会在第一个 0 字节处截断
     sqlite3_bind_text(stmt, 1, new_address.c_str(), -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 2, new_public_key.c_str(), -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 3, new_encrypted_password.c_str(), -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 4, new_notes.c_str(), -1, SQLITE_STATIC);
-    sqlite3_bind_int(stmt, 5, entry_id);
+    sqlite3_bind_blob(stmt, 2, new_encrypted_password.data(), static_cast<int>(new_encrypted_password.size()), SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 3, new_notes.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 4, entry_id);
 
-    bool success = sqlite3_step(stmt) == SQLITE_DONE;
+    bool success = Step(stmt) == SQLITE_DONE;
     int rowsAffected = sqlite3_changes(db_);
-    sqlite3_finalize(stmt);
+    if (success && rowsAffected > 0) {
+        PublishChanges();
+    }
 
     return success && (rowsAffected > 0);
 }
 
-// 事务处理方法
+bool PasswordVault::RunInTransaction(const function<bool()>& body) {
+    if (!BeginTransaction()) {
+        throw runtime_error("Failed to start transaction");
+    }
+
+    try {
+        if (!body()) {
+            RollbackTransaction();
+            return false;
+        }
+        if (!CommitTransaction()) {
+            throw runtime_error("Commit failed: " + string(sqlite3_errmsg(db_)));
+        }
+    } catch (...) {
+        RollbackTransaction();
+        throw;
+    }
+    PublishChanges();
+    return true;
+}
+
+// 事务处理方法（同样走语句缓存，避免每次解析）
+// 用 SAVEPOINT 而不是 BEGIN：单独调用时与普通事务相同，
+// 在连接池写线程的成组事务中调用时则成为嵌套的保存点
 bool PasswordVault::BeginTransaction() {
-    return sqlite3_exec(db_, "BEGIN TRANSACTION", nullptr, nullptr, nullptr) == SQLITE_OK;
+    auto stmt = statements_->Prepare("SAVEPOINT vault_txn");
+    return Step(stmt) == SQLITE_DONE;
 }
 
 bool PasswordVault::CommitTransaction() {
-    return sqlite3_exec(db_, "COMMIT", nullptr, nullptr, nullptr) == SQLITE_OK;
+    auto stmt = statements_->Prepare("RELEASE vault_txn");
+    return Step(stmt) == SQLITE_DONE;
 }
 
 bool PasswordVault::RollbackTransaction() {
-    return sqlite3_exec(db_, "ROLLBACK", nullptr, nullptr, nullptr) == SQLITE_OK;
+    auto rollback = statements_->Prepare("ROLLBACK TO vault_txn");
+    const bool rolledBack = Step(rollback) == SQLITE_DONE;
+    auto release = statements_->Prepare("RELEASE vault_txn");
+    return Step(release) == SQLITE_DONE && rolledBack;
 }
 
 bool PasswordVault::CheckCodebookExists(int codebook_id) {
     const char* sql = "SELECT 1 FROM Codebook WHERE codebook_id = ?";
-    sqlite3_stmt* stmt;
-    
-    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        throw runtime_error("Prepare failed: " + string(sqlite3_errmsg(db_)));
-    }
+    auto stmt = statements_->Prepare(sql);
     
     sqlite3_bind_int(stmt, 1, codebook_id);
-    bool exists = (sqlite3_step(stmt) == SQLITE_ROW);
-    sqlite3_finalize(stmt);
+    bool exists = (Step(stmt) == SQLITE_ROW);
     
     return exists;
 }
@@ -322,7 +1065,8 @@ bool PasswordVault::ValidateCodebookName(const std::string& name) {
     // 匹配规则：
     // 1. 允许的ASCII字符：字母、数字、下划线、连字符、常见符号
     // 2. 允许的中文字符：通过UTF-8的三字节编码范围进行匹配
-    const std::regex pattern(
+    // 正则只在第一次调用时编译
+    static const std::regex pattern(
         R"(^([A-Za-z0-9_\-\@\$!%\*\#\?&]|[\xE4-\xE9][\x80-\xBF]{2}){1,100}$)"
     );
 
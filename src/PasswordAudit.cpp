@@ -0,0 +1,233 @@
+#include "PasswordAudit.h"
+#include <sodium.h>
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+using namespace std;
+
+namespace {
+
+const size_t kBlobHashBytes = 16;
+const size_t kKeyTagBytes = 8;
+const char kKeyTagMessage[] = "AuditCache";
+// 缓存结果的明文：entry_id (u32) ‖ 密码摘要 ‖ 是否已泄露
+const size_t kResultBytes = 4 + crypto_generichash_BYTES + 1;
+
+// 密文摘要只用于判断条目是否被修改过，不需要密钥
+vector<uint8_t> BlobHash(const vector<uint8_t>& blob) {
+    vector<uint8_t> hash(kBlobHashBytes);
+    crypto_generichash(hash.data(), hash.size(), blob.data(), blob.size(), nullptr, 0);
+    return hash;
+}
+
+// 审计结果以 secretbox 封装为 nonce ‖ 密文后才写入缓存；entry_id 一同封装，结果不能挪给其他条目
+vector<uint8_t> SealResult(const SecureKey& key, int entryId, const vector<uint8_t>& passwordHash, bool breached) {
+    uint8_t plain[kResultBytes];
+    for (int i = 0; i < 4; ++i) {
+        plain[i] = static_cast<uint8_t>(static_cast<uint32_t>(entryId) >> (8 * i));
+    }
+    copy(passwordHash.begin(), passwordHash.end(), plain + 4);
+    plain[kResultBytes - 1] = breached ? 1 : 0;
+
+    vector<uint8_t> sealed(crypto_secretbox_NONCEBYTES + crypto_secretbox_MACBYTES + kResultBytes);
+    randombytes_buf(sealed.data(), crypto_secretbox_NONCEBYTES);
+    crypto_secretbox_easy(sealed.data() + crypto_secretbox_NONCEBYTES, plain, sizeof(plain),
+                          sealed.data(), key.data());
+    sodium_memzero(plain, sizeof(plain));
+    return sealed;
+}
+
+// 长度不符、审计密钥已变化或不属于该条目时返回 false，条目按未缓存处理
+bool OpenResult(const SecureKey& key, int entryId, const vector<uint8_t>& sealed,
+                vector<uint8_t>& passwordHash, bool& breached) {
+    if (sealed.size() != crypto_secretbox_NONCEBYTES + crypto_secretbox_MACBYTES + kResultBytes) {
+        return false;
+    }
+    uint8_t plain[kResultBytes];
+    if (crypto_secretbox_open_easy(plain, sealed.data() + crypto_secretbox_NONCEBYTES,
+                                   sealed.size() - crypto_secretbox_NONCEBYTES, sealed.data(), key.data()) != 0) {
+        return false;
+    }
+    uint32_t storedId = 0;
+    for (int i = 0; i < 4; ++i) {
+        storedId |= static_cast<uint32_t>(plain[i]) << (8 * i);
+    }
+    const bool ok = storedId == static_cast<uint32_t>(entryId);
+    if (ok) {
+        passwordHash.assign(plain + 4, plain + 4 + crypto_generichash_BYTES);
+        breached = plain[kResultBytes - 1] != 0;
+    }
+    sodium_memzero(plain, sizeof(plain));
+    return ok;
+}
+
+} // namespace
+
+PasswordAuditor::PasswordAuditor(PasswordVault& vault, shared_ptr<SessionKeyring> keyring,
+                                 shared_ptr<const PasswordDictionary> dictionary)
+    : vault_(vault), keyring_(move(keyring)), estimator_(move(dictionary)) {
+    if (!keyring_) {
+        throw invalid_argument("Invalid session keyring");
+    }
+}
+
+StrengthAuditReport PasswordAuditor::AuditStrength(int codebook_id, const AuditOptions& options) {
+    StrengthAuditReport report;
+    const uint64_t total = static_cast<uint64_t>(vault_.CountEntries(codebook_id));
+    auto codebookKey = keyring_->GetCodebookKey(vault_, codebook_id);
+
+    PasswordVault::EntryPage page;
+    do {
+        page = vault_.GetEntries(codebook_id, "", page.next_after_id, max(1, options.pageSize));
+        vector<vector<uint8_t>> blobs;
+        for (auto& entry : page.entries) {
+            blobs.push_back(move(entry.encrypted_password));
+        }
+        auto plaintexts = keyring_->DecryptBatch(*codebookKey, blobs);
+
+        for (size_t i = 0; i < page.entries.size(); ++i) {
+            if (!plaintexts[i].ok) {
+                ++report.undecryptable;
+                continue;
+            }
+            const auto& entry = page.entries[i];
+            string password(plaintexts[i].plaintext.begin(), plaintexts[i].plaintext.end());
+            sodium_memzero(plaintexts[i].plaintext.data(), plaintexts[i].plaintext.size());
+
+            const StrengthResult result = estimator_.Estimate(password, {entry.address, entry.notes});
+            if (!password.empty()) {
+                sodium_memzero(&password[0], password.size());
+            }
+            ++report.audited;
+            if (result.score < options.minScore) {
+                report.weak.push_back({entry.id, entry.address, result.score, result.entropyBits, result.warning});
+            }
+        }
+
+        if (options.progress && !options.progress(report.audited + report.undecryptable, total)) {
+            report.canceled = true;
+            break;
+        }
+    } while (page.has_more);
+
+    stable_sort(report.weak.begin(), report.weak.end(),
+                [](const WeakPassword& a, const WeakPassword& b) { return a.entropyBits < b.entropyBits; });
+    return report;
+}
+
+ReuseAuditReport PasswordAuditor::AuditReuse(const string& username, const BreachStore* breaches,
+                                             const AuditOptions& options) {
+    ReuseAuditReport report;
+    report.breachChecked = breaches != nullptr;
+    const auto codebooks = vault_.GetUserCodebooks(username);
+    uint64_t total = 0;
+    for (const auto& codebook : codebooks) {
+        total += static_cast<uint64_t>(vault_.CountEntries(codebook.id));
+    }
+    auto auditKey = keyring_->DeriveAuditKey();
+    // 摘要用审计密钥本身，封装缓存结果用由它派生的独立子密钥
+    auto resultKey = CryptoModule().deriveSubkey(*auditKey, 1, "auditres");
+
+    // 审计密钥的标识取固定消息的带密钥摘要：主密码变化后旧缓存自动失效，且不泄露密钥本身
+    vector<uint8_t> keyTag(kKeyTagBytes);
+    crypto_generichash(keyTag.data(), keyTag.size(), reinterpret_cast<const uint8_t*>(kKeyTagMessage),
+                       sizeof(kKeyTagMessage) - 1, auditKey->data(), auditKey->size());
+    const vector<uint8_t> breachTag = breaches ? breaches->Tag() : vector<uint8_t>();
+
+    unordered_map<string, vector<AuditedEntry>> groups;
+    for (const auto& codebook : codebooks) {
+        shared_ptr<SecureKey> codebookKey;
+        PasswordVault::AuditPage page;
+        do {
+            page = vault_.GetAuditRecords(codebook.id, page.next_after_id, max(1, options.pageSize));
+
+            // 缓存仍有效的条目不解密，其余条目批量解密后重新计算；摘要与泄露标记只在内存中使用
+            vector<size_t> stale;
+            vector<vector<uint8_t>> blobs;
+            vector<vector<uint8_t>> passwordHashes(page.records.size());
+            vector<bool> breached(page.records.size(), false);
+            for (size_t i = 0; i < page.records.size(); ++i) {
+                auto& record = page.records[i];
+                vector<uint8_t> blobHash = BlobHash(record.encrypted_password);
+                bool wasBreached = false;
+                const bool fresh = record.cached && record.blob_hash == blobHash && record.key_tag == keyTag &&
+                                   (!breaches || record.breach_tag == breachTag) &&
+                                   OpenResult(*resultKey, record.entry_id, record.sealed_result,
+                                              passwordHashes[i], wasBreached);
+                breached[i] = wasBreached;
+                if (!fresh) {
+                    record.blob_hash = move(blobHash);
+                    stale.push_back(i);
+                    blobs.push_back(move(record.encrypted_password));
+                }
+            }
+
+            vector<bool> undecryptable(page.records.size(), false);
+            vector<PasswordVault::AuditRecord> updated;
+            if (!stale.empty()) {
+                if (!codebookKey) {
+                    codebookKey = keyring_->GetCodebookKey(vault_, codebook.id);
+                }
+                auto plaintexts = keyring_->DecryptBatch(*codebookKey, blobs);
+
+                for (size_t j = 0; j < stale.size(); ++j) {
+                    auto& record = page.records[stale[j]];
+                    auto& plaintext = plaintexts[j].plaintext;
+                    if (!plaintexts[j].ok) {
+                        undecryptable[stale[j]] = true;
+                        continue;
+                    }
+
+                    auto& passwordHash = passwordHashes[stale[j]];
+                    passwordHash.assign(crypto_generichash_BYTES, 0);
+                    crypto_generichash(passwordHash.data(), passwordHash.size(),
+                                       plaintext.data(), plaintext.size(), auditKey->data(), auditKey->size());
+                    breached[stale[j]] = breaches &&
+                                         breaches->Contains(BreachStore::Hash(plaintext.data(), plaintext.size()));
+                    sodium_memzero(plaintext.data(), plaintext.size());
+                    record.key_tag = keyTag;
+                    record.breach_tag = breachTag;
+                    record.sealed_result = SealResult(*resultKey, record.entry_id, passwordHash, breached[stale[j]]);
+
+                    ++report.decrypted;
+                    updated.push_back(record);
+                }
+                vault_.SaveAuditRecords(updated);
+            }
+
+            for (size_t i = 0; i < page.records.size(); ++i) {
+                if (undecryptable[i]) {
+                    ++report.undecryptable;
+                    continue;
+                }
+                const auto& record = page.records[i];
+                AuditedEntry entry{record.entry_id, record.codebook_id, record.address};
+                if (breaches && breached[i]) {
+                    report.breached.push_back(entry);
+                }
+                groups[string(passwordHashes[i].begin(), passwordHashes[i].end())].push_back(move(entry));
+                ++report.audited;
+            }
+
+            if (options.progress && !options.progress(report.audited + report.undecryptable, total)) {
+                report.canceled = true;
+                break;
+            }
+        } while (page.has_more);
+
+        if (report.canceled) {
+            break;
+        }
+    }
+
+    for (auto& group : groups) {
+        if (group.second.size() > 1) {
+            report.reused.push_back(move(group.second));
+        }
+    }
+    sort(report.reused.begin(), report.reused.end(),
+         [](const vector<AuditedEntry>& a, const vector<AuditedEntry>& b) {
+             return a.size() != b.size() ? a.size() > b.size() : a.front().entryId < b.front().entryId;
+         });
+    return report;
+}
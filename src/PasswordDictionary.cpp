@@ -0,0 +1,238 @@
+#include "PasswordDictionary.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+using namespace std;
+
+namespace {
+
+const char kMagic[4] = {'P', 'M', 'D', 'T'};
+const uint32_t kVersion = 1;
+const size_t kHeaderBytes = 20;
+const uint32_t kMaxNodes = 1u << 24;   // 边里只有 24 位存子节点序号
+
+// 未提供字典文件时使用的常见密码与单词，按常见程度排序
+const char* const kBuiltinWords[] = {
+    "123456", "password", "123456789", "12345678", "12345", "qwerty", "1234567", "111111",
+    "1234567890", "123123", "abc123", "1234", "password1", "iloveyou", "000000", "qwerty123",
+    "dragon", "monkey", "654321", "666666", "123321", "1qaz2wsx", "123qwe", "qwertyuiop",
+    "superman", "asdfghjkl", "princess", "letmein", "welcome", "football", "baseball", "sunshine",
+    "master", "shadow", "michael", "jennifer", "admin", "administrator", "login", "passw0rd",
+    "trustno1", "whatever", "starwars", "computer", "internet", "hello", "freedom", "charlie",
+    "jordan", "hunter", "killer", "soccer", "batman", "thomas", "robert", "daniel",
+    "andrew", "joshua", "matthew", "jessica", "ashley", "nicole", "michelle", "amanda",
+    "secret", "summer", "winter", "spring", "autumn", "flower", "orange", "banana",
+    "apple", "cheese", "cookie", "pepper", "ginger", "buster", "tigger", "maggie",
+    "ranger", "harley", "hockey", "tennis", "golf", "love", "lovely", "loveme",
+    "angel", "angels", "forever", "friend", "friends", "family", "mother", "father",
+    "sister", "brother", "baby", "babygirl", "happy", "money", "silver", "golden",
+    "diamond", "purple", "yellow", "blue", "green", "black", "white", "red",
+    "pass", "pass123", "test", "test123", "guest", "root", "user", "default",
+    "changeme", "system", "server", "oracle", "mysql", "database", "backup", "qazwsx",
+    "zxcvbnm", "asdf", "asdfgh", "zaq12wsx", "1q2w3e4r", "1q2w3e", "q1w2e3r4", "abcdef",
+    "abcd1234", "aa123456", "a123456", "woaini", "woaini1314", "woaiwojia", "aini",
+    "520520", "5201314", "1314520", "888888", "168168", "147258369", "159357", "147258",
+    "789456", "112233", "121212", "222222", "555555", "777777", "999999", "100200",
+    "zhang", "wang", "chen", "yang", "huang", "zhao", "zhou", "liu", "xiao",
+    "qq123456", "baidu", "taobao", "weixin", "wechat", "alipay", "google", "facebook",
+    "twitter", "github", "microsoft", "windows", "linux", "ubuntu", "android", "iphone",
+    "samsung", "huawei", "xiaomi", "apple123", "mustang", "ferrari", "porsche", "corvette",
+    "matrix", "phoenix", "thunder", "tiger", "lion", "eagle", "falcon", "wolf",
+    "bear", "horse", "dolphin", "panda", "kitty", "hello123", "welcome1", "letmein1",
+    "china", "beijing", "shanghai", "guangzhou", "shenzhen", "london", "paris", "tokyo",
+    "america", "canada", "dallas", "chicago", "boston", "austin", "jackson", "dakota",
+    "pokemon", "naruto", "minecraft", "fortnite", "gaming", "player", "legend", "warrior",
+    "ninja", "pirate", "knight", "wizard", "magic", "rocket", "planet", "galaxy",
+    "music", "guitar", "piano", "rock", "metal", "party", "beach", "ocean",
+    "school", "student", "teacher", "doctor", "office", "company", "account", "manager",
+    "mypass", "mypassword", "nopassword", "letmeinnow", "iloveu", "loveyou", "monday", "friday",
+    "january", "february", "march", "april", "june", "july", "august", "september",
+    "october", "november", "december",
+};
+
+// 临时 trie：节点按创建顺序编号，子节点按字符有序
+struct BuildNode {
+    map<uint8_t, uint32_t> children;
+    uint32_t rank = 0;
+};
+
+void PutU32(vector<uint8_t>& out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+}
+
+bool FileExists(const string& path) {
+    ifstream in(path, ios::binary);
+    return static_cast<bool>(in);
+}
+
+} // namespace
+
+vector<uint8_t> PasswordDictionary::Compile(const vector<string>& words) {
+    vector<BuildNode> nodes(1);
+    uint32_t wordCount = 0;
+    uint32_t edgeCount = 0;
+
+    for (size_t i = 0; i < words.size(); ++i) {
+        if (words[i].empty()) continue;
+
+        uint32_t node = kRoot;
+        for (char c : words[i]) {
+            const uint8_t label = static_cast<uint8_t>(tolower(static_cast<unsigned char>(c)));
+            auto it = nodes[node].children.find(label);
+            if (it != nodes[node].children.end()) {
+                node = it->second;
+                continue;
+            }
+            if (nodes.size() >= kMaxNodes) {
+                throw runtime_error("词表过大，字典节点数超出上限");
+            }
+            const uint32_t child = static_cast<uint32_t>(nodes.size());
+            nodes[node].children.emplace(label, child);
+            nodes.emplace_back();
+            ++edgeCount;
+            node = child;
+        }
+        if (nodes[node].rank == 0) {
+            nodes[node].rank = static_cast<uint32_t>(i + 1);
+            ++wordCount;
+        }
+    }
+
+    const uint32_t nodeCount = static_cast<uint32_t>(nodes.size());
+    vector<uint8_t> out(kMagic, kMagic + sizeof(kMagic));
+    out.reserve(kHeaderBytes + 4 * (2 * static_cast<size_t>(nodeCount) + 1 + edgeCount));
+    PutU32(out, kVersion);
+    PutU32(out, nodeCount);
+    PutU32(out, edgeCount);
+    PutU32(out, wordCount);
+
+    uint32_t firstEdge = 0;
+    for (const auto& node : nodes) {
+        PutU32(out, firstEdge);
+        firstEdge += static_cast<uint32_t>(node.children.size());
+    }
+    PutU32(out, firstEdge);
+    for (const auto& node : nodes) {
+        PutU32(out, node.rank);
+    }
+    for (const auto& node : nodes) {
+        for (const auto& child : node.children) {
+            PutU32(out, static_cast<uint32_t>(child.first) << 24 | child.second);
+        }
+    }
+    return out;
+}
+
+void PasswordDictionary::CompileFile(const vector<string>& words, const string& path) {
+    const vector<uint8_t> bytes = Compile(words);
+    ofstream out(path, ios::binary | ios::trunc);
+    out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<streamsize>(bytes.size()));
+    if (!out) {
+        throw runtime_error("无法写入字典文件: " + path);
+    }
+}
+
+shared_ptr<const PasswordDictionary> PasswordDictionary::Open(const string& path) {
+    shared_ptr<PasswordDictionary> dictionary(new PasswordDictionary());
+    dictionary->file_ = MappedFile(path);
+    dictionary->Attach(dictionary->file_.Data(), dictionary->file_.Size());
+    return dictionary;
+}
+
+shared_ptr<const PasswordDictionary> PasswordDictionary::FromBytes(vector<uint8_t> bytes) {
+    shared_ptr<PasswordDictionary> dictionary(new PasswordDictionary());
+    dictionary->bytes_ = move(bytes);
+    dictionary->Attach(dictionary->bytes_.data(), dictionary->bytes_.size());
+    return dictionary;
+}
+
+shared_ptr<const PasswordDictionary> PasswordDictionary::Default() {
+    static once_flag once;
+    static shared_ptr<const PasswordDictionary> dictionary;
+    call_once(once, [] {
+        const string path = "passmgr.dict";
+        if (FileExists(path)) {
+            try {
+                dictionary = Open(path);
+                return;
+            } catch (const exception&) {
+                // 字典文件损坏时退回内置词表
+            }
+        }
+        dictionary = FromBytes(Compile(vector<string>(begin(kBuiltinWords), end(kBuiltinWords))));
+    });
+    return dictionary;
+}
+
+void PasswordDictionary::Attach(const uint8_t* data, size_t size) {
+    if (size < kHeaderBytes || memcmp(data, kMagic, sizeof(kMagic)) != 0) {
+        throw runtime_error("不是有效的字典文件");
+    }
+    if (Load(data + 4, 0) != kVersion) {
+        throw runtime_error("不支持的字典文件版本");
+    }
+    nodeCount_ = Load(data + 4, 1);
+    edgeCount_ = Load(data + 4, 2);
+    wordCount_ = Load(data + 4, 3);
+
+    const uint64_t expected = kHeaderBytes + 4 * (2 * static_cast<uint64_t>(nodeCount_) + 1 + edgeCount_);
+    if (nodeCount_ == 0 || nodeCount_ > kMaxNodes || expected != size) {
+        throw runtime_error("字典文件已损坏");
+    }
+    firstEdge_ = data + kHeaderBytes;
+    rank_ = firstEdge_ + 4 * (static_cast<size_t>(nodeCount_) + 1);
+    edges_ = rank_ + 4 * static_cast<size_t>(nodeCount_);
+
+    // 查找时不再做边界检查，加载时一次性校验全部偏移
+    uint32_t previous = 0;
+    for (uint32_t i = 0; i <= nodeCount_; ++i) {
+        const uint32_t first = Load(firstEdge_, i);
+        if (first < previous || first > edgeCount_) {
+            throw runtime_error("字典文件已损坏");
+        }
+        previous = first;
+    }
+    if (previous != edgeCount_) {
+        throw runtime_error("字典文件已损坏");
+    }
+    for (uint32_t i = 0; i < edgeCount_; ++i) {
+        if ((Load(edges_, i) & (kMaxNodes - 1)) >= nodeCount_) {
+            throw runtime_error("字典文件已损坏");
+        }
+    }
+}
+
+uint32_t PasswordDictionary::Load(const uint8_t* base, uint32_t index) const {
+    const uint8_t* p = base + 4 * static_cast<size_t>(index);
+    return static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 |
+           static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24;
+}
+
+uint32_t PasswordDictionary::Child(uint32_t node, uint8_t label) const {
+    uint32_t low = Load(firstEdge_, node);
+    uint32_t high = Load(firstEdge_, node + 1);
+    while (low < high) {
+        const uint32_t mid = low + (high - low) / 2;
+        const uint32_t edge = Load(edges_, mid);
+        const uint8_t midLabel = static_cast<uint8_t>(edge >> 24);
+        if (midLabel == label) {
+            return edge & (kMaxNodes - 1);
+        }
+        if (midLabel < label) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return kNoNode;
+}
+
+uint32_t PasswordDictionary::Rank(uint32_t node) const {
+    return Load(rank_, node);
+}
@@ -0,0 +1,610 @@
+#include "PasswordStrength.h"
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <limits>
+#include <regex>
+#include <stdexcept>
+using namespace std;
+
+namespace {
+
+const size_t kMaxAnalyzedBytes = 100;
+// zxcvbn 的常数：分解中每多一段至少增加的猜测次数、单段最少猜测次数、年份间隔下限
+const double kMinGuessesBeforeGrowingSequenceLog10 = 4.0;
+const double kMinSubmatchGuessesSingleLog10 = 1.0;
+const double kMinSubmatchGuessesMultiLog10 = 1.69897;   // log10(50)
+const double kMinYearSpace = 20;
+// 标准键盘：47 个按键（含上档共 94 个起点），每个按键平均约 4.6 个相邻按键
+const double kKeyboardStartsLog10 = 1.97313;             // log10(94)
+const double kKeyboardDegreeLog10 = 0.66276;             // log10(4.6)
+const double kLog10Two = 0.30103;
+const double kInf = numeric_limits<double>::infinity();
+
+double Log10Sum(double a, double b) {
+    if (a == -kInf) return b;
+    if (b == -kInf) return a;
+    const double high = max(a, b);
+    return high + log10(1 + pow(10.0, min(a, b) - high));
+}
+
+double Log10Factorial(size_t n) {
+    return lgamma(static_cast<double>(n) + 1) / log(10.0);
+}
+
+double Log10Binomial(size_t n, size_t k) {
+    return Log10Factorial(n) - Log10Factorial(k) - Log10Factorial(n - k);
+}
+
+// 在 a + b 个位置中选出 1..min(a, b) 个变体位置的组合数之和
+double Log10Variations(size_t a, size_t b) {
+    double total = -kInf;
+    for (size_t i = 1; i <= min(a, b); ++i) {
+        total = Log10Sum(total, Log10Binomial(a + b, i));
+    }
+    return total;
+}
+
+double UppercaseVariationsLog10(const string& token) {
+    size_t upper = 0;
+    size_t lower = 0;
+    for (unsigned char c : token) {
+        if (isupper(c)) ++upper;
+        else if (islower(c)) ++lower;
+    }
+    if (upper == 0) return 0;
+    // 全大写、首字母大写、末字母大写是最常见的三种变化
+    if (lower == 0) return kLog10Two;
+    if (upper == 1 && (isupper(static_cast<unsigned char>(token.front())) ||
+                       isupper(static_cast<unsigned char>(token.back())))) {
+        return kLog10Two;
+    }
+    return Log10Variations(upper, lower);
+}
+
+// l33t 替换：符号或数字可能代表的字母
+const char* L33tLetters(unsigned char c) {
+    switch (c) {
+    case '4': case '@': return "a";
+    case '8': return "b";
+    case '(': case '{': case '[': case '<': return "c";
+    case '3': return "e";
+    case '6': case '9': return "g";
+    case '1': case '|': return "il";
+    case '!': return "i";
+    case '7': return "lt";
+    case '0': return "o";
+    case '$': case '5': return "s";
+    case '+': return "t";
+    case '%': return "x";
+    case '2': return "z";
+    default: return "";
+    }
+}
+
+double L33tVariationsLog10(const string& lowerToken, const vector<pair<char, char>>& subs) {
+    double total = 0;
+    for (size_t i = 0; i < subs.size(); ++i) {
+        if (find(subs.begin(), subs.begin() + i, subs[i]) != subs.begin() + i) continue;
+        const size_t subbed = count(lowerToken.begin(), lowerToken.end(), subs[i].first);
+        const size_t unsubbed = count(lowerToken.begin(), lowerToken.end(), subs[i].second);
+        total += subbed == 0 || unsubbed == 0 ? kLog10Two : Log10Variations(subbed, unsubbed);
+    }
+    return total;
+}
+
+struct KeyPosition {
+    int row = -1;
+    int col = 0;
+    bool shifted = false;
+};
+
+// 行首的空格使各行按实际键位错开：q 位于 1、2 之下，a 位于 q、w 之下
+const array<KeyPosition, 256>& KeyboardLayout() {
+    static const array<KeyPosition, 256> layout = [] {
+        const char* const rows[2][4] = {
+            {"`1234567890-=", " qwertyuiop[]\\", " asdfghjkl;'", " zxcvbnm,./"},
+            {"~!@#$%^&*()_+", " QWERTYUIOP{}|", " ASDFGHJKL:\"", " ZXCVBNM<>?"},
+        };
+        array<KeyPosition, 256> keys;
+        for (int shifted = 0; shifted < 2; ++shifted) {
+            for (int row = 0; row < 4; ++row) {
+                for (int col = 0; rows[shifted][row][col]; ++col) {
+                    const unsigned char c = static_cast<unsigned char>(rows[shifted][row][col]);
+                    if (c == ' ') continue;
+                    keys[c].row = row;
+                    keys[c].col = col;
+                    keys[c].shifted = shifted == 1;
+                }
+            }
+        }
+        return keys;
+    }();
+    return layout;
+}
+
+// 两个按键相邻时返回方向（0-5），否则返回 -1
+int KeyDirection(const KeyPosition& a, const KeyPosition& b) {
+    if (a.row < 0 || b.row < 0) return -1;
+    const int dr = b.row - a.row;
+    const int dc = b.col - a.col;
+    if (dr == 0 && dc == -1) return 0;
+    if (dr == 0 && dc == 1) return 1;
+    if (dr == -1 && dc == 0) return 2;
+    if (dr == -1 && dc == 1) return 3;
+    if (dr == 1 && dc == -1) return 4;
+    if (dr == 1 && dc == 0) return 5;
+    return -1;
+}
+
+void MatchSpatial(const string& password, vector<StrengthMatch>& matches) {
+    const auto& layout = KeyboardLayout();
+    const size_t n = password.size();
+    size_t i = 0;
+    while (i + 1 < n) {
+        size_t j = i + 1;
+        int lastDirection = -1;
+        size_t turns = 0;
+        size_t shifted = layout[static_cast<unsigned char>(password[i])].shifted ? 1 : 0;
+        for (; j < n; ++j) {
+            const auto& previous = layout[static_cast<unsigned char>(password[j - 1])];
+            const auto& current = layout[static_cast<unsigned char>(password[j])];
+            const int direction = KeyDirection(previous, current);
+            if (direction < 0) break;
+            if (direction != lastDirection) {
+                ++turns;
+                lastDirection = direction;
+            }
+            if (current.shifted) ++shifted;
+        }
+
+        const size_t length = j - i;
+        if (length >= 3) {
+            double guesses = -kInf;
+            for (size_t k = 2; k <= length; ++k) {
+                for (size_t t = 1; t <= min(turns, k - 1); ++t) {
+                    guesses = Log10Sum(guesses, Log10Binomial(k - 1, t - 1) + kKeyboardStartsLog10 +
+                                                t * kKeyboardDegreeLog10);
+                }
+            }
+            if (shifted > 0) {
+                guesses += shifted == length ? kLog10Two : Log10Variations(shifted, length - shifted);
+            }
+            StrengthMatch match{StrengthMatch::Spatial, i, j, guesses};
+            matches.push_back(match);
+        }
+        i = j;
+    }
+}
+
+int CharClassOf(unsigned char c) {
+    if (islower(c)) return 1;
+    if (isupper(c)) return 2;
+    if (isdigit(c)) return 3;
+    return 0;
+}
+
+// 步长固定（|步长| <= 5）的连续字符，如 abc、13579、zyx
+void MatchSequences(const string& password, vector<StrengthMatch>& matches) {
+    const size_t n = password.size();
+    size_t i = 0;
+    while (i + 2 < n) {
+        const unsigned char first = static_cast<unsigned char>(password[i]);
+        const int charClass = CharClassOf(first);
+        const int delta = static_cast<unsigned char>(password[i + 1]) - first;
+        size_t j = i + 1;
+        if (charClass != 0 && delta != 0 && abs(delta) <= 5) {
+            while (j < n && CharClassOf(static_cast<unsigned char>(password[j])) == charClass &&
+                   static_cast<unsigned char>(password[j]) - static_cast<unsigned char>(password[j - 1]) == delta) {
+                ++j;
+            }
+        }
+
+        if (j - i >= 3) {
+            double base = strchr("aAzZ019", first) ? 4 : charClass == 3 ? 10 : 26;
+            if (delta < 0) base *= 2;
+            StrengthMatch match{StrengthMatch::Sequence, i, j, log10(base * (j - i))};
+            matches.push_back(match);
+            i = j - 1;
+        } else {
+            ++i;
+        }
+    }
+}
+
+int ReferenceYear() {
+    static const int year = 1970 + static_cast<int>(time(nullptr) / 31556952);
+    return year;
+}
+
+double YearSpaceLog10(int year) {
+    return log10(max<double>(abs(year - ReferenceYear()), kMinYearSpace));
+}
+
+int ParseDigits(const string& text, size_t begin, size_t count) {
+    int value = 0;
+    for (size_t i = begin; i < begin + count; ++i) {
+        value = value * 10 + (text[i] - '0');
+    }
+    return value;
+}
+
+// 两位年份按离参考年份更近的世纪解释
+int ExpandYear(int year) {
+    if (year >= 100) return year;
+    return abs(1900 + year - ReferenceYear()) < abs(2000 + year - ReferenceYear()) ? 1900 + year : 2000 + year;
+}
+
+bool ValidDay(int day, int month) {
+    return month >= 1 && month <= 12 && day >= 1 && day <= 31;
+}
+
+// 纯数字串 digits 中的日期，返回最小的年份间隔（对数），无效时返回负值
+double DateGuessesLog10(const string& digits, bool yearFirst, size_t yearDigits) {
+    const size_t n = digits.size();
+    double best = -1;
+    auto consider = [&](int year, int month, int day) {
+        year = ExpandYear(year);
+        if (year < 1900 || year > 2099 || !ValidDay(day, month)) return;
+        const double guesses = log10(365.0) + YearSpaceLog10(year);
+        if (best < 0 || guesses < best) best = guesses;
+    };
+    if (yearFirst) {
+        const int year = ParseDigits(digits, 0, yearDigits);
+        consider(year, ParseDigits(digits, yearDigits, 2), ParseDigits(digits, yearDigits + 2, 2));
+    } else {
+        const int year = ParseDigits(digits, n - yearDigits, yearDigits);
+        const int a = ParseDigits(digits, 0, 2);
+        const int b = ParseDigits(digits, 2, 2);
+        consider(year, b, a);   // 日月年
+        consider(year, a, b);   // 月日年
+    }
+    return best;
+}
+
+void MatchDates(const string& password, vector<StrengthMatch>& matches) {
+    const size_t n = password.size();
+    auto allDigits = [&](size_t begin, size_t count) {
+        for (size_t i = begin; i < begin + count; ++i) {
+            if (!isdigit(static_cast<unsigned char>(password[i]))) return false;
+        }
+        return true;
+    };
+
+    for (size_t i = 0; i < n; ++i) {
+        // 年份 19xx / 20xx
+        if (i + 4 <= n && allDigits(i, 4)) {
+            const int year = ParseDigits(password, i, 4);
+            if (year >= 1900 && year <= 2099) {
+                StrengthMatch match{StrengthMatch::Date, i, i + 4, YearSpaceLog10(year)};
+                matches.push_back(match);
+            }
+        }
+        // 不带分隔符的 6 / 8 位日期
+        for (size_t length : {6, 8}) {
+            if (i + length > n || !allDigits(i, length)) continue;
+            const string digits = password.substr(i, length);
+            const size_t yearDigits = length - 4;
+            const double yearFirst = DateGuessesLog10(digits, true, yearDigits);
+            const double yearLast = DateGuessesLog10(digits, false, yearDigits);
+            const double guesses = yearFirst < 0 ? yearLast : yearLast < 0 ? yearFirst : min(yearFirst, yearLast);
+            if (guesses >= 0) {
+                StrengthMatch match{StrengthMatch::Date, i, i + length, guesses};
+                matches.push_back(match);
+            }
+        }
+        // yyyy-mm-dd、dd/mm/yyyy 等带分隔符的日期
+        if (i + 10 <= n) {
+            const string token = password.substr(i, 10);
+            string digits;
+            char separator = 0;
+            bool yearFirst = false;
+            if (allDigits(i, 4) && allDigits(i + 5, 2) && allDigits(i + 8, 2) && token[4] == token[7]) {
+                separator = token[4];
+                digits = token.substr(0, 4) + token.substr(5, 2) + token.substr(8, 2);
+                yearFirst = true;
+            } else if (allDigits(i, 2) && allDigits(i + 3, 2) && allDigits(i + 6, 4) && token[2] == token[5]) {
+                separator = token[2];
+                digits = token.substr(0, 2) + token.substr(3, 2) + token.substr(6, 4);
+            }
+            if (separator && strchr("-/._ ", separator)) {
+                const double guesses = DateGuessesLog10(digits, yearFirst, 4);
+                if (guesses >= 0) {
+                    StrengthMatch match{StrengthMatch::Date, i, i + 10, guesses + log10(4.0)};
+                    matches.push_back(match);
+                }
+            }
+        }
+    }
+}
+
+void MatchUserWords(const string& password, const string& lower, const vector<string>& userWords,
+                    vector<StrengthMatch>& matches) {
+    for (size_t i = 0; i < userWords.size(); ++i) {
+        const string& word = userWords[i];
+        for (size_t pos = lower.find(word); pos != string::npos; pos = lower.find(word, pos + 1)) {
+            StrengthMatch match{StrengthMatch::UserInput, pos, pos + word.size(),
+                                log10(static_cast<double>(i + 1)) +
+                                UppercaseVariationsLog10(password.substr(pos, word.size()))};
+            match.rank = static_cast<uint32_t>(i + 1);
+            matches.push_back(match);
+        }
+    }
+}
+
+vector<string> SplitUserInputs(const vector<string>& inputs) {
+    static const char* const kIgnored[] = {"www", "http", "https", "com", "net", "org"};
+    vector<string> words;
+    auto add = [&words](string word) {
+        if (word.size() < 3) return;
+        if (find(begin(kIgnored), end(kIgnored), word) != end(kIgnored)) return;
+        if (find(words.begin(), words.end(), word) == words.end()) words.push_back(move(word));
+    };
+
+    for (const auto& input : inputs) {
+        string lower;
+        for (char c : input) lower += static_cast<char>(tolower(static_cast<unsigned char>(c)));
+        add(lower);
+        // 按非字母数字拆开，站点地址中的域名、用户名中的片段都单独计入
+        string word;
+        for (char c : lower) {
+            const unsigned char u = static_cast<unsigned char>(c);
+            if (isalnum(u) || u >= 0x80) {
+                word += c;
+            } else {
+                add(word);
+                word.clear();
+            }
+        }
+        add(word);
+    }
+    return words;
+}
+
+double BruteforceGuessesLog10(size_t length) {
+    return max(static_cast<double>(length),
+               length == 1 ? log10(11.0) : log10(51.0));
+}
+
+struct DictionaryWalk {
+    const PasswordDictionary& dictionary;
+    const string& password;
+    const string& lower;
+    bool reversed;
+    size_t start;
+    vector<pair<char, char>> subs;
+    vector<StrengthMatch>& matches;
+
+    void Visit(uint32_t node, size_t pos) {
+        const uint32_t rank = pos > start ? dictionary.Rank(node) : 0;
+        if (rank > 0) {
+            const string token = password.substr(start, pos - start);
+            const string lowerToken = lower.substr(start, pos - start);
+            double guesses = log10(static_cast<double>(rank)) + UppercaseVariationsLog10(token);
+            if (!subs.empty()) guesses += L33tVariationsLog10(lowerToken, subs);
+            if (reversed) guesses += kLog10Two;
+
+            const size_t n = password.size();
+            StrengthMatch match{StrengthMatch::Dictionary,
+                                reversed ? n - pos : start, reversed ? n - start : pos, guesses};
+            match.rank = rank;
+            match.reversed = reversed;
+            match.l33t = !subs.empty();
+            matches.push_back(match);
+        }
+        if (pos == lower.size()) return;
+
+        const unsigned char c = static_cast<unsigned char>(lower[pos]);
+        const uint32_t child = dictionary.Child(node, c);
+        if (child != PasswordDictionary::kNoNode) {
+            Visit(child, pos + 1);
+        }
+        for (const char* letter = L33tLetters(c); *letter; ++letter) {
+            const uint32_t substituted = dictionary.Child(node, static_cast<uint8_t>(*letter));
+            if (substituted == PasswordDictionary::kNoNode) continue;
+            subs.emplace_back(static_cast<char>(c), *letter);
+            Visit(substituted, pos + 1);
+            subs.pop_back();
+        }
+    }
+};
+
+const char* WarningFor(const StrengthMatch& match) {
+    switch (match.pattern) {
+    case StrengthMatch::Dictionary:
+        if (match.rank <= 10 && !match.l33t && !match.reversed) return "这是最常用的密码之一";
+        if (match.l33t) return "用符号代替字母（如 @ 代替 a）并不能增加多少强度";
+        if (match.reversed) return "倒序拼写常见单词很容易被猜到";
+        return "包含常见单词或常用密码";
+    case StrengthMatch::UserInput: return "包含用户名或站点名称";
+    case StrengthMatch::Spatial: return "键盘上相邻的按键很容易被猜到";
+    case StrengthMatch::Sequence: return "连续的字符（如 abc、123）很容易被猜到";
+    case StrengthMatch::Repeat: return "重复的字符或片段很容易被猜到";
+    case StrengthMatch::Date: return "日期和年份很容易被猜到";
+    case StrengthMatch::Bruteforce: break;
+    }
+    return "密码太短";
+}
+
+} // namespace
+
+bool MeetsComplexityRule(const string& password) {
+    static const regex pattern(R"((?=.*\d)(?=.*[a-z])(?=.*[A-Z]).{8,32})");
+    return regex_match(password, pattern);
+}
+
+StrengthEstimator::StrengthEstimator(shared_ptr<const PasswordDictionary> dictionary)
+    : dictionary_(move(dictionary)) {
+    if (!dictionary_) {
+        throw invalid_argument("Invalid password dictionary");
+    }
+}
+
+const char* StrengthEstimator::ScoreName(int score) {
+    static const char* const kNames[] = {"极弱", "弱", "一般", "较强", "强"};
+    return kNames[max(0, min(score, 4))];
+}
+
+StrengthResult StrengthEstimator::Estimate(const string& password, const vector<string>& userInputs) const {
+    const vector<string> userWords = SplitUserInputs(userInputs);
+    // 与 zxcvbn 一样截断后只给前缀评分；超出部分未经匹配器检查，不能当作随机字符计分
+    StrengthResult result = EstimatePrefix(password.substr(0, kMaxAnalyzedBytes), userWords, false);
+
+    result.entropyBits = result.guessesLog10 * log2(10.0);
+    const double thresholds[] = {log10(1e3 + 5), log10(1e6 + 5), log10(1e8 + 5), log10(1e10 + 5)};
+    result.score = static_cast<int>(upper_bound(begin(thresholds), end(thresholds), result.guessesLog10) - begin(thresholds));
+
+    if (result.score < 3) {
+        // 以覆盖最长的可识别模式作为主要弱点
+        const StrengthMatch* longest = nullptr;
+        for (const auto& match : result.sequence) {
+            if (match.pattern == StrengthMatch::Bruteforce) continue;
+            if (!longest || match.end - match.begin > longest->end - longest->begin) longest = &match;
+        }
+        result.warning = longest ? WarningFor(*longest) : "密码太短";
+    }
+    return result;
+}
+
+void StrengthEstimator::MatchDictionary(const string& password, const string& lower, bool reversed,
+                                        vector<StrengthMatch>& matches) const {
+    DictionaryWalk walk{*dictionary_, password, lower, reversed, 0, {}, matches};
+    for (walk.start = 0; walk.start < lower.size(); ++walk.start) {
+        walk.Visit(PasswordDictionary::kRoot, walk.start);
+    }
+}
+
+void StrengthEstimator::MatchRepeats(const string& password, const vector<string>& userWords,
+                                     vector<StrengthMatch>& matches) const {
+    const size_t n = password.size();
+    size_t i = 0;
+    while (i + 1 < n) {
+        // 找出从 i 开始覆盖最长的重复：块长 block，重复 times 次
+        size_t bestBlock = 0;
+        size_t bestTimes = 0;
+        for (size_t block = 1; block <= (n - i) / 2; ++block) {
+            size_t times = 1;
+            while (i + (times + 1) * block <= n &&
+                   password.compare(i + times * block, block, password, i, block) == 0) {
+                ++times;
+            }
+            if (times >= 2 && times * block > bestTimes * bestBlock) {
+                bestBlock = block;
+                bestTimes = times;
+            }
+        }
+
+        if (bestTimes == 0) {
+            ++i;
+            continue;
+        }
+        // 重复块本身的猜测次数递归估计，整段再乘以重复次数
+        const double base = EstimatePrefix(password.substr(i, bestBlock), userWords, true).guessesLog10;
+        StrengthMatch match{StrengthMatch::Repeat, i, i + bestBlock * bestTimes,
+                            base + log10(static_cast<double>(bestTimes))};
+        matches.push_back(match);
+        i += bestBlock * bestTimes;
+    }
+}
+
+StrengthResult StrengthEstimator::EstimatePrefix(const string& password, const vector<string>& userWords,
+                                                 bool excludeAdditive) const {
+    const size_t n = password.size();
+    StrengthResult result;
+    if (n == 0) {
+        return result;
+    }
+
+    string lower(password);
+    for (char& c : lower) c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+
+    vector<StrengthMatch> matches;
+    MatchDictionary(password, lower, false, matches);
+    MatchDictionary(string(password.rbegin(), password.rend()), string(lower.rbegin(), lower.rend()), true, matches);
+    MatchUserWords(password, lower, userWords, matches);
+    MatchSpatial(password, matches);
+    MatchSequences(password, matches);
+    MatchDates(password, matches);
+    MatchRepeats(password, userWords, matches);
+
+    for (auto& match : matches) {
+        const double minimum = match.end - match.begin == 1 ? kMinSubmatchGuessesSingleLog10
+                                                            : kMinSubmatchGuessesMultiLog10;
+        match.guessesLog10 = max(match.guessesLog10, minimum);
+    }
+    sort(matches.begin(), matches.end(),
+         [](const StrengthMatch& a, const StrengthMatch& b) { return a.end < b.end; });
+
+    // best[k * (n + 1) + l]：前 k 个字节分解为 l 段时的最优解（zxcvbn 的 most_guessable_match_sequence）
+    struct Cell {
+        double g = kInf;      // l! * Π + 附加项（对数）
+        double pi = 0;        // 各段猜测次数之积（对数）
+        int match = -1;       // matches 中的下标，-1 表示暴力破解段
+        size_t begin = 0;     // 该段的起点
+    };
+    vector<Cell> best((n + 1) * (n + 1));
+    auto cell = [&](size_t k, size_t l) -> Cell& { return best[k * (n + 1) + l]; };
+    auto update = [&](size_t k, size_t l, double pi, int match, size_t begin) {
+        double g = Log10Factorial(l) + pi;
+        if (!excludeAdditive) {
+            g = Log10Sum(g, (l - 1) * kMinGuessesBeforeGrowingSequenceLog10);
+        }
+        for (size_t shorter = 1; shorter <= l; ++shorter) {
+            if (cell(k, shorter).g <= g) return;
+        }
+        Cell& target = cell(k, l);
+        target.g = g;
+        target.pi = pi;
+        target.match = match;
+        target.begin = begin;
+    };
+
+    size_t next = 0;
+    for (size_t k = 1; k <= n; ++k) {
+        for (; next < matches.size() && matches[next].end == k; ++next) {
+            const StrengthMatch& match = matches[next];
+            if (match.begin == 0) {
+                update(k, 1, match.guessesLog10, static_cast<int>(next), 0);
+                continue;
+            }
+            for (size_t l = 1; l <= match.begin; ++l) {
+                const Cell& previous = cell(match.begin, l);
+                if (previous.g == kInf) continue;
+                update(k, l + 1, previous.pi + match.guessesLog10, static_cast<int>(next), match.begin);
+            }
+        }
+
+        // 暴力破解段不与前一个暴力破解段相邻（相邻时合并成一段更优）
+        update(k, 1, BruteforceGuessesLog10(k), -1, 0);
+        for (size_t i = 1; i < k; ++i) {
+            for (size_t l = 1; l <= i; ++l) {
+                const Cell& previous = cell(i, l);
+                if (previous.g == kInf || previous.match < 0) continue;
+                update(k, l + 1, previous.pi + BruteforceGuessesLog10(k - i), -1, i);
+            }
+        }
+    }
+
+    size_t bestLength = 1;
+    for (size_t l = 1; l <= n; ++l) {
+        if (cell(n, l).g < cell(n, bestLength).g) bestLength = l;
+    }
+    result.guessesLog10 = cell(n, bestLength).g;
+
+    for (size_t k = n, l = bestLength; k > 0; --l) {
+        const Cell& current = cell(k, l);
+        if (current.match >= 0) {
+            result.sequence.push_back(matches[current.match]);
+        } else {
+            StrengthMatch match{StrengthMatch::Bruteforce, current.begin, k, BruteforceGuessesLog10(k - current.begin)};
+            result.sequence.push_back(match);
+        }
+        k = current.begin;
+    }
+    reverse(result.sequence.begin(), result.sequence.end());
+    return result;
+}
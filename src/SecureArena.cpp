@@ -0,0 +1,142 @@
+#include "SecureArena.h"
+#include <sodium.h>
+#include <algorithm>
+#include <stdexcept>
+using namespace std;
+
+namespace {
+
+const size_t kClassCount = 7;
+const size_t kClassBytes[kClassCount] = {32, 64, 128, 256, 512, 1024, 4096};
+
+} // namespace
+
+SecureArena::SecureArena(size_t chunkBytes)
+    : chunkBytes_(chunkBytes < kMaxSlotBytes ? kMaxSlotBytes : chunkBytes), freeSlots_(kClassCount) {
+    if (sodium_init() < 0) {
+        throw runtime_error("Libsodium initialization failed");
+    }
+}
+
+SecureArena::~SecureArena() {
+    for (const auto& chunk : chunks_) {
+        // sodium_free 先清零再解锁释放
+        sodium_free(chunk.data);
+    }
+}
+
+SecureArena& SecureArena::Global() {
+    static SecureArena* arena = new SecureArena();
+    return *arena;
+}
+
+size_t SecureArena::ClassIndex(size_t size) {
+    size_t index = 0;
+    while (index < kClassCount && kClassBytes[index] < size) {
+        ++index;
+    }
+    return index;
+}
+
+void SecureArena::Refill(size_t classIndex) {
+    uint8_t* data = static_cast<uint8_t*>(sodium_malloc(chunkBytes_));
+    if (!data) {
+        throw runtime_error("Secure memory allocation failed");
+    }
+    // sodium_malloc 用固定字节填充新区域，槽位约定以全零交出
+    sodium_memzero(data, chunkBytes_);
+
+    const size_t slotBytes = kClassBytes[classIndex];
+    chunks_.push_back({data, slotBytes});
+    ++stats_.chunks;
+    ++stats_.chunkAllocations;
+    stats_.reservedBytes += chunkBytes_;
+
+    // 倒序压入，先交出低地址的槽位
+    auto& slots = freeSlots_[classIndex];
+    for (size_t offset = (chunkBytes_ / slotBytes) * slotBytes; offset > 0; offset -= slotBytes) {
+        slots.push_back(data + offset - slotBytes);
+    }
+}
+
+uint8_t* SecureArena::Acquire(size_t size, size_t& capacity) {
+    const size_t classIndex = ClassIndex(max<size_t>(size, 1));
+
+    lock_guard<mutex> lock(mutex_);
+    uint8_t* slot = nullptr;
+    if (classIndex == kClassCount) {
+        slot = static_cast<uint8_t*>(sodium_malloc(size));
+        if (!slot) {
+            throw runtime_error("Secure memory allocation failed");
+        }
+        sodium_memzero(slot, size);
+        capacity = size;
+        ++stats_.oversized;
+        ++stats_.chunkAllocations;
+        stats_.reservedBytes += size;
+    } else {
+        auto& slots = freeSlots_[classIndex];
+        if (slots.empty()) {
+            Refill(classIndex);
+        }
+        slot = slots.back();
+        slots.pop_back();
+        capacity = kClassBytes[classIndex];
+    }
+
+    ++stats_.acquired;
+    ++stats_.liveSlots;
+    stats_.liveBytes += capacity;
+    stats_.peakLiveSlots = max(stats_.peakLiveSlots, stats_.liveSlots);
+    return slot;
+}
+
+void SecureArena::Release(uint8_t* slot, size_t capacity) {
+    if (!slot) {
+        return;
+    }
+
+    lock_guard<mutex> lock(mutex_);
+    --stats_.liveSlots;
+    stats_.liveBytes -= capacity;
+    if (capacity > kMaxSlotBytes) {
+        sodium_free(slot);
+        --stats_.oversized;
+        stats_.reservedBytes -= capacity;
+        return;
+    }
+
+    sodium_memzero(slot, capacity);
+    freeSlots_[ClassIndex(capacity)].push_back(slot);
+}
+
+size_t SecureArena::Trim() {
+    lock_guard<mutex> lock(mutex_);
+    size_t released = 0;
+
+    for (auto chunk = chunks_.begin(); chunk != chunks_.end();) {
+        auto& slots = freeSlots_[ClassIndex(chunk->slotBytes)];
+        const uint8_t* begin = chunk->data;
+        const uint8_t* end = chunk->data + chunkBytes_;
+        auto inChunk = [begin, end](const uint8_t* slot) { return slot >= begin && slot < end; };
+
+        const size_t total = chunkBytes_ / chunk->slotBytes;
+        if (static_cast<size_t>(count_if(slots.begin(), slots.end(), inChunk)) != total) {
+            ++chunk;
+            continue;
+        }
+
+        slots.erase(remove_if(slots.begin(), slots.end(), inChunk), slots.end());
+        sodium_free(chunk->data);
+        chunk = chunks_.erase(chunk);
+        --stats_.chunks;
+        stats_.reservedBytes -= chunkBytes_;
+        released += chunkBytes_;
+    }
+    return released;
+}
+
+SecureArena::Stats SecureArena::GetStats() const {
+    lock_guard<mutex> lock(mutex_);
+    return stats_;
+}
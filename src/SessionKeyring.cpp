@@ -0,0 +1,223 @@
+#include "SessionKeyring.h"
+#include <sodium.h>
+#include <algorithm>
+#include <stdexcept>
+using namespace std;
+
+namespace {
+
+shared_ptr<const SecureBuffer> CopyToSecureBuffer(const string& text) {
+    auto buffer = make_shared<SecureBuffer>(text.size());
+    buffer->resize(text.size());
+    copy(text.begin(), text.end(), buffer->data());
+    return buffer;
+}
+
+} // namespace
+
+SessionKeyring::SessionKeyring(shared_ptr<SecureKey> kek, const string& masterPassword, const KdfProfile& kdf)
+    : kek_(move(kek)), kdf_(kdf) {
+    if (!kek_) {
+        throw invalid_argument("Invalid session key");
+    }
+    masterPassword_ = CopyToSecureBuffer(masterPassword);
+    passwordTag_ = PasswordTag(*kek_, masterPassword);
+}
+
+SessionKeyring::~SessionKeyring() {
+    DropMasterPassword();
+}
+
+shared_ptr<SecureKey> SessionKeyring::GetCodebookKey(PasswordVault& vault, int codebook_id) {
+    lock_guard<mutex> lock(mutex_);
+    return LoadCodebookKey(vault, codebook_id);
+}
+
+shared_ptr<SecureKey> SessionKeyring::CachedCodebookKey(int codebook_id) const {
+    lock_guard<mutex> lock(mutex_);
+    auto cached = codebookKeys_.find(codebook_id);
+    return cached == codebookKeys_.end() ? nullptr : cached->second;
+}
+
+shared_ptr<SecureKey> SessionKeyring::FindCodebookKey(PasswordVault& vault, int codebook_id) {
+    lock_guard<mutex> lock(mutex_);
+    return LoadCodebookKey(vault, codebook_id, false);
+}
+
+shared_ptr<SecureKey> SessionKeyring::GetPreviousCodebookKey(PasswordVault& vault, int codebook_id) {
+    lock_guard<mutex> lock(mutex_);
+    auto previous = previousKeys_.find(LoadCodebookKey(vault, codebook_id).get());
+    return previous == previousKeys_.end() ? nullptr : previous->second;
+}
+
+shared_ptr<SecureKey> SessionKeyring::LoadCodebookKey(PasswordVault& vault, int codebook_id, bool create) {
+    auto cached = codebookKeys_.find(codebook_id);
+    if (cached != codebookKeys_.end()) {
+        return cached->second;
+    }
+
+    vector<uint8_t> wrapped;
+    if (!vault.GetCodebookKey(codebook_id, wrapped)) {
+        if (!create) {
+            return nullptr;
+        }
+        auto dataKey = crypto_.generateDataKey();
+        if (vault.SetCodebookKey(codebook_id, crypto_.wrapKey(*kek_, *dataKey))) {
+            codebookKeys_[codebook_id] = dataKey;
+            return dataKey;
+        }
+        // 其他窗口已先行写入，使用已保存的密钥
+        if (!vault.GetCodebookKey(codebook_id, wrapped)) {
+            throw runtime_error("Codebook key unavailable");
+        }
+    }
+
+    auto dataKey = crypto_.unwrapKey(*kek_, wrapped);
+    vector<uint8_t> previousWrapped;
+    if (vault.GetPreviousCodebookKey(codebook_id, previousWrapped)) {
+        previousKeys_[dataKey.get()] = crypto_.unwrapKey(*kek_, previousWrapped);
+    }
+    codebookKeys_[codebook_id] = dataKey;
+    return dataKey;
+}
+
+void SessionKeyring::ForgetCodebook(int codebook_id) {
+    lock_guard<mutex> lock(mutex_);
+    auto cached = codebookKeys_.find(codebook_id);
+    if (cached == codebookKeys_.end()) {
+        return;
+    }
+    previousKeys_.erase(cached->second.get());
+    codebookKeys_.erase(cached);
+}
+
+void SessionKeyring::Rekey(shared_ptr<SecureKey> kek, const string& masterPassword) {
+    if (!kek) {
+        throw invalid_argument("Invalid session key");
+    }
+
+    vector<uint8_t> tag = PasswordTag(*kek, masterPassword);
+    lock_guard<mutex> lock(mutex_);
+    kek_ = move(kek);
+    passwordTag_ = move(tag);
+    masterPassword_.reset();
+    previousKeys_.clear();
+    codebookKeys_.clear();
+}
+
+vector<uint8_t> SessionKeyring::PasswordTag(const SecureKey& kek, const string& password) const {
+    auto key = crypto_.deriveSubkey(kek, 2, "pmverify");
+    vector<uint8_t> tag(crypto_generichash_BYTES);
+    crypto_generichash(tag.data(), tag.size(), reinterpret_cast<const unsigned char*>(password.data()),
+                       password.size(), key->data(), key->size());
+    return tag;
+}
+
+bool SessionKeyring::CheckMasterPassword(const string& password) const {
+    shared_ptr<SecureKey> kek;
+    vector<uint8_t> expected;
+    {
+        lock_guard<mutex> lock(mutex_);
+        kek = kek_;
+        expected = passwordTag_;
+    }
+    const vector<uint8_t> tag = PasswordTag(*kek, password);
+    return sodium_memcmp(tag.data(), expected.data(), tag.size()) == 0;
+}
+
+void SessionKeyring::DropMasterPassword() {
+    // SecureBuffer 归还槽位前清零；仍在解密的调用持有引用，结束后才释放
+    lock_guard<mutex> lock(mutex_);
+    masterPassword_.reset();
+}
+
+shared_ptr<const SecureBuffer> SessionKeyring::LegacyPassword() const {
+    lock_guard<mutex> lock(mutex_);
+    return masterPassword_;
+}
+
+shared_ptr<SecureKey> SessionKeyring::PreviousKeyFor(const SecureKey& codebookKey) const {
+    lock_guard<mutex> lock(mutex_);
+    auto previous = previousKeys_.find(&codebookKey);
+    return previous == previousKeys_.end() ? nullptr : previous->second;
+}
+
+vector<uint8_t> SessionKeyring::Decrypt(const SecureKey& codebookKey, const vector<uint8_t>& packedData) {
+    auto decryptLegacy = [&] {
+        auto password = LegacyPassword();
+        if (!password) {
+            throw runtime_error("Decryption failed: legacy data requires the master password");
+        }
+        return crypto_.decrypt(*password, packedData);
+    };
+    if (CryptoModule::isLegacyFormat(packedData)) {
+        return decryptLegacy();
+    }
+
+    try {
+        return crypto_.decrypt(codebookKey, packedData);
+    } catch (const runtime_error&) {
+        // 轮换尚未处理到的条目仍由旧数据密钥加密
+        auto previous = PreviousKeyFor(codebookKey);
+        if (previous) {
+            try {
+                return crypto_.decrypt(*previous, packedData);
+            } catch (const runtime_error&) {
+            }
+        }
+        // 也可能是恰好以记录头开头的旧格式数据
+        if (!CryptoModule::mayBeLegacyFormat(packedData.data(), packedData.size()) || !LegacyPassword()) {
+            throw;
+        }
+        return decryptLegacy();
+    }
+}
+
+bool SessionKeyring::Decrypt(const SecureKey& codebookKey, const uint8_t* packedData, size_t packedSize,
+                             SecureBuffer& plaintext) {
+    if (!CryptoModule::isLegacyFormat(packedData, packedSize)) {
+        if (crypto_.decrypt(codebookKey, packedData, packedSize, plaintext)) {
+            return true;
+        }
+        auto previous = PreviousKeyFor(codebookKey);
+        if (previous && crypto_.decrypt(*previous, packedData, packedSize, plaintext)) {
+            return true;
+        }
+        // 也可能是恰好以记录头开头的旧格式数据
+        if (!CryptoModule::mayBeLegacyFormat(packedData, packedSize)) {
+            return false;
+        }
+    }
+
+    auto password = LegacyPassword();
+    if (!password) {
+        plaintext.clear();
+        return false;
+    }
+    try {
+        vector<uint8_t> legacy = crypto_.decrypt(*password, vector<uint8_t>(packedData, packedData + packedSize));
+        plaintext.resize(legacy.size());
+        copy(legacy.begin(), legacy.end(), plaintext.data());
+        sodium_memzero(legacy.data(), legacy.size());
+        return true;
+    } catch (const runtime_error&) {
+        plaintext.clear();
+        return false;
+    }
+}
+
+vector<BatchDecryptResult> SessionKeyring::DecryptBatch(const SecureKey& codebookKey,
+                                                        const vector<vector<uint8_t>>& packedData,
+                                                        const BatchDecryptOptions& options) {
+    // 数据密钥之后依次回退到旧数据密钥与旧格式
+    auto previous = PreviousKeyFor(codebookKey);
+    auto password = LegacyPassword();
+    BatchDecryptOptions fallback = options;
+    fallback.previousKey = previous.get();
+    return crypto_.decryptBatch(password ? PasswordView(*password) : PasswordView(), &codebookKey, packedData, fallback);
+}
+
+shared_ptr<SecureKey> SessionKeyring::DeriveAuditKey() const {
+    lock_guard<mutex> lock(mutex_);
+    return crypto_.deriveSubkey(*kek_, 1, "pmaudit_");
+}
@@ -0,0 +1,111 @@
+#include "StatementCache.h"
+#include <map>
+#include <stdexcept>
+#include <utility>
+using namespace std;
+
+namespace {
+mutex registryMutex;
+// 有意不析构：静态存储期的连接可能在程序退出时才关闭，此时注册表仍须可用
+map<sqlite3*, shared_ptr<StatementCache>>& registry() {
+    static auto* caches = new map<sqlite3*, shared_ptr<StatementCache>>();
+    return *caches;
+}
+}
+
+StatementCache::Statement::Statement(shared_ptr<StatementCache> cache, string sql, sqlite3_stmt* stmt)
+    : cache_(move(cache)), sql_(move(sql)), stmt_(stmt) {
+}
+
+StatementCache::Statement::Statement(Statement&& other) noexcept
+    : cache_(move(other.cache_)), sql_(move(other.sql_)), stmt_(other.stmt_) {
+    other.stmt_ = nullptr;
+}
+
+StatementCache::Statement::~Statement() {
+    if (stmt_) {
+        cache_->Return(sql_, stmt_);
+    }
+}
+
+shared_ptr<StatementCache> StatementCache::ForConnection(sqlite3* db) {
+    if (!db) {
+        throw invalid_argument("Invalid database connection");
+    }
+
+    lock_guard<mutex> lock(registryMutex);
+    auto& cache = registry()[db];
+    if (!cache) {
+        cache.reset(new StatementCache(db));
+    }
+    return cache;
+}
+
+void StatementCache::ReleaseConnection(sqlite3* db) {
+    shared_ptr<StatementCache> cache;
+    {
+        lock_guard<mutex> lock(registryMutex);
+        auto found = registry().find(db);
+        if (found == registry().end()) {
+            return;
+        }
+        cache = move(found->second);
+        registry().erase(found);
+    }
+
+    // 立即释放空闲语句；仍被租用的语句在归还时随最后一个引用一起释放
+    lock_guard<mutex> lock(cache->mutex_);
+    for (auto& entry : cache->idle_) {
+        for (sqlite3_stmt* stmt : entry.second) {
+            sqlite3_finalize(stmt);
+        }
+    }
+    cache->idle_.clear();
+}
+
+StatementCache::StatementCache(sqlite3* db) : db_(db) {
+}
+
+StatementCache::~StatementCache() {
+    for (auto& entry : idle_) {
+        for (sqlite3_stmt* stmt : entry.second) {
+            sqlite3_finalize(stmt);
+        }
+    }
+}
+
+StatementCache::Statement StatementCache::Prepare(const string& sql) {
+    {
+        lock_guard<mutex> lock(mutex_);
+        auto found = idle_.find(sql);
+        if (found != idle_.end() && !found->second.empty()) {
+            sqlite3_stmt* stmt = found->second.back();
+            found->second.pop_back();
+            return Statement(shared_from_this(), sql, stmt);
+        }
+    }
+
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v3(db_, sql.c_str(), static_cast<int>(sql.size()) + 1,
+                           SQLITE_PREPARE_PERSISTENT, &stmt, nullptr) != SQLITE_OK) {
+        throw runtime_error("Prepare failed: " + string(sqlite3_errmsg(db_)));
+    }
+    return Statement(shared_from_this(), sql, stmt);
+}
+
+size_t StatementCache::IdleCount() const {
+    lock_guard<mutex> lock(mutex_);
+    size_t count = 0;
+    for (const auto& entry : idle_) {
+        count += entry.second.size();
+    }
+    return count;
+}
+
+void StatementCache::Return(const string& sql, sqlite3_stmt* stmt) {
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+
+    lock_guard<mutex> lock(mutex_);
+    idle_[sql].push_back(stmt);
+}
@@ -1,27 +1,63 @@
 #include "UserAuth.h"
+#include "PasswordStrength.h"
+#include "ChangeBus.h"
+#include "ConnectionPool.h"
+#include "Metrics.h"
 #include <sodium.h>
-#include <regex>
 #include <algorithm>
 
-UserAuth::UserAuth(const std::string& db_path) : db_(nullptr) {
+namespace {
+
+// 所有语句都经由这里执行，启用指标时逐次计时
+inline int Step(sqlite3_stmt* stmt) {
+    PASSMGR_SPAN("sqlite.auth.step");
+    return sqlite3_step(stmt);
+}
+
+} // namespace
+
+UserAuth::UserAuth(const std::string& db_path, const ConnectionProfile& profile, const KdfProfile& kdf)
+    : db_(nullptr), kdf_(kdf) {
     if (sodium_init() < 0) {
         throw std::runtime_error("Libsodium initialization failed");
     }
+    kdf_.Validate();
     
+    // 连接会被界面线程与后台任务线程共用，显式使用串行化模式
     if (sqlite3_open_v2(db_path.c_str(), &db_, 
-                       SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE,
+                       SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_FULLMUTEX,
                        nullptr) != SQLITE_OK) {
         throw std::runtime_error("Database open failed: " + std::string(sqlite3_errmsg(db_)));
     }
+
+    try {
+        // 日志模式、缓存与外键约束都是连接级设置，每次打开连接时应用
+        profile.Apply(db_);
+    } catch (...) {
+        sqlite3_close_v2(db_);
+        throw;
+    }
+    statements_ = StatementCache::ForConnection(db_);
     
     if (!CreateTables()) {
+        statements_.reset();
+        StatementCache::ReleaseConnection(db_);
+        ChangeBus::ReleaseConnection(db_);
         sqlite3_close_v2(db_);
         throw std::runtime_error("Table creation failed");
     }
+
+    // 读连接在建表之后按需打开，写线程在第一次写入时启动
+    ConnectionPool::Attach(db_, profile);
 }
 
 UserAuth::~UserAuth() {
     if (db_) {
+        // 先停止写线程、关闭读连接，再释放缓存的预编译语句，连接才能真正关闭
+        ConnectionPool::ReleaseConnection(db_);
+        statements_.reset();
+        StatementCache::ReleaseConnection(db_);
+        ChangeBus::ReleaseConnection(db_);
         sqlite3_close_v2(db_);
     }
 }
@@ -30,7 +66,9 @@ bool UserAuth::CreateTables() {
     const char* sql = R"(
         CREATE TABLE IF NOT EXISTS User (
             username TEXT PRIMARY KEY,
-            password_hash TEXT NOT NULL
+            password_hash TEXT NOT NULL,
+            kdf_salt BLOB,
+            kdf_params BLOB
         );
         
         CREATE TABLE IF NOT EXISTS Codebook (
@@ -38,6 +76,15 @@ bool UserAuth::CreateTables() {
             username TEXT NOT NULL,
             codebook_name TEXT NOT NULL,
             created_time DATETIME DEFAULT CURRENT_TIMESTAMP,
+            wrapped_key BLOB,
+            previous_wrapped_key BLOB,
+            updated_seq INTEGER NOT NULL DEFAULT 0,
+            entry_count INTEGER NOT NULL DEFAULT 0,
+            total_bytes INTEGER NOT NULL DEFAULT 0,
+            modified_time DATETIME,
+            tombstone_seq INTEGER NOT NULL DEFAULT 0,
+            -- 全部条目都已转换到的密文格式版本，0 表示尚未检查；达到当前版本后打开密码本时不再扫描
+            format_version INTEGER NOT NULL DEFAULT 0,
             FOREIGN KEY(username) REFERENCES User(username) ON DELETE CASCADE,
             UNIQUE(username, codebook_name)
         );
@@ -47,16 +94,43 @@ bool UserAuth::CreateTables() {
             codebook_id INTEGER NOT NULL,
             created_time DATETIME DEFAULT CURRENT_TIMESTAMP,
             address TEXT NOT NULL CHECK(length(address) <= 253),
+            -- 已不使用：新条目写入空 BLOB，保留该列以兼容已有数据库
             public_key BLOB NOT NULL CHECK(length(public_key) <= 4096),
             encrypted_password BLOB NOT NULL CHECK(length(encrypted_password) <= 512),
             notes TEXT CHECK(length(notes) <= 1024),
+            updated_seq INTEGER NOT NULL DEFAULT 0,
             FOREIGN KEY(codebook_id) REFERENCES Codebook(codebook_id) ON DELETE CASCADE
         );
         
         CREATE INDEX IF NOT EXISTS idx_codebook ON PasswordEntry(codebook_id);
-        PRAGMA foreign_keys = ON;
+        -- 密码本列表按用户过滤、按创建时间排序，不需要临时排序
+        CREATE INDEX IF NOT EXISTS idx_codebook_user_created ON Codebook(username, created_time);
+
+        -- 密码审计缓存：密文不变时复用上次的审计结果，无需再次解密。
+        -- 结果（明文摘要与是否已泄露）以审计密钥封装，只有数据库文件时看不出哪些条目密码相同或已泄露
+        CREATE TABLE IF NOT EXISTS AuditCache (
+            entry_id INTEGER PRIMARY KEY,
+            blob_hash BLOB NOT NULL,
+            key_tag BLOB NOT NULL,
+            breach_tag BLOB,
+            sealed_result BLOB NOT NULL,
+            FOREIGN KEY(entry_id) REFERENCES PasswordEntry(entry_id) ON DELETE CASCADE
+        );
+
+        -- 密钥轮换检查点：每个尚未完成重新加密的密码本一行，记录已提交到的 entry_id
+        CREATE TABLE IF NOT EXISTS KeyRotation (
+            codebook_id INTEGER PRIMARY KEY,
+            last_entry_id INTEGER NOT NULL DEFAULT 0,
+            FOREIGN KEY(codebook_id) REFERENCES Codebook(codebook_id) ON DELETE CASCADE
+        );
     )";
 
+    // 旧版本的审计缓存以明文保存摘要与泄露标记；缓存随时可以重建，直接删除后按新结构创建
+    if (HasColumn("AuditCache", "breached") &&
+        sqlite3_exec(db_, "DROP TABLE AuditCache", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        return false;
+    }
+
     char* errMsg = nullptr;
     int rc = sqlite3_exec(db_, sql, nullptr, nullptr, &errMsg);
     if (rc != SQLITE_OK) {
@@ -64,10 +138,245 @@ bool UserAuth::CreateTables() {
         sqlite3_free(errMsg);
         return false;
     }
-    return true;
+    return MigrateSchema();
+}
+
+bool UserAuth::MigrateSchema() {
+    // 统计列由条目触发器维护；旧数据库补列时先删掉不维护统计的旧触发器，重建后回填
+    const bool missingStats = !HasColumn("Codebook", "entry_count");
+    // 旧的删除触发器不清理墓碑，同样需要重建
+    const bool missingPruning = !HasColumn("Codebook", "tombstone_seq");
+
+    // 旧数据库缺少密钥层级与变更跟踪所需的列，按需补齐
+    struct Column { const char* table; const char* name; const char* ddl; };
+    const Column columns[] = {
+        {"User", "kdf_salt", "ALTER TABLE User ADD COLUMN kdf_salt BLOB"},
+        {"User", "kdf_params", "ALTER TABLE User ADD COLUMN kdf_params BLOB"},
+        {"Codebook", "wrapped_key", "ALTER TABLE Codebook ADD COLUMN wrapped_key BLOB"},
+        {"Codebook", "previous_wrapped_key", "ALTER TABLE Codebook ADD COLUMN previous_wrapped_key BLOB"},
+        {"Codebook", "updated_seq", "ALTER TABLE Codebook ADD COLUMN updated_seq INTEGER NOT NULL DEFAULT 0"},
+        {"PasswordEntry", "updated_seq", "ALTER TABLE PasswordEntry ADD COLUMN updated_seq INTEGER NOT NULL DEFAULT 0"},
+        {"Codebook", "entry_count", "ALTER TABLE Codebook ADD COLUMN entry_count INTEGER NOT NULL DEFAULT 0"},
+        {"Codebook", "total_bytes", "ALTER TABLE Codebook ADD COLUMN total_bytes INTEGER NOT NULL DEFAULT 0"},
+        {"Codebook", "modified_time", "ALTER TABLE Codebook ADD COLUMN modified_time DATETIME"},
+        {"Codebook", "tombstone_seq", "ALTER TABLE Codebook ADD COLUMN tombstone_seq INTEGER NOT NULL DEFAULT 0"},
+        {"Codebook", "format_version", "ALTER TABLE Codebook ADD COLUMN format_version INTEGER NOT NULL DEFAULT 0"},
+    };
+
+    for (const auto& column : columns) {
+        if (HasColumn(column.table, column.name)) {
+            continue;
+        }
+        if (sqlite3_exec(db_, column.ddl, nullptr, nullptr, nullptr) != SQLITE_OK) {
+            return false;
+        }
+    }
+
+    if (missingStats) {
+        const char* dropTriggers = R"(
+            DROP TRIGGER IF EXISTS PasswordEntry_seq_insert;
+            DROP TRIGGER IF EXISTS PasswordEntry_seq_update;
+            DROP TRIGGER IF EXISTS PasswordEntry_seq_delete;
+        )";
+        if (sqlite3_exec(db_, dropTriggers, nullptr, nullptr, nullptr) != SQLITE_OK) {
+            return false;
+        }
+    } else if (missingPruning) {
+        if (sqlite3_exec(db_, "DROP TRIGGER IF EXISTS PasswordEntry_seq_delete", nullptr, nullptr, nullptr) != SQLITE_OK) {
+            return false;
+        }
+    }
+    if (!CreateChangeTracking()) {
+        return false;
+    }
+    if (missingStats) {
+        const char* backfill = R"(
+            UPDATE Codebook SET
+                entry_count = (SELECT COUNT(*) FROM PasswordEntry e WHERE e.codebook_id = Codebook.codebook_id),
+                total_bytes = (SELECT COALESCE(SUM(length(CAST(e.address AS BLOB)) + length(e.encrypted_password)
+                                                   + COALESCE(length(CAST(e.notes AS BLOB)), 0)), 0)
+                               FROM PasswordEntry e WHERE e.codebook_id = Codebook.codebook_id)
+        )";
+        if (sqlite3_exec(db_, backfill, nullptr, nullptr, nullptr) != SQLITE_OK) {
+            return false;
+        }
+    }
+    return CreateSearchIndex();
+}
+
+bool UserAuth::CreateChangeTracking() {
+    // 全库共用一个单调递增的变更序号：条目与密码本每次插入或修改都取一个新序号写入 updated_seq，
+    // 删除的条目记入墓碑表，界面据此只取回自上次以来的差量。
+    // 触发器自身写 updated_seq 时新旧值不同，不会再次触发。
+    // 更新密码本序号的同一条语句顺带维护条目数、条目总字节数（地址、密文与备注）与最后修改时间，
+    // 列出密码本时不必扫描条目表。
+    // 墓碑只保留最近 10000 个序号内的删除：每次删除时顺带清理同一密码本中更早的墓碑，
+    // 并把密码本的 tombstone_seq 推进到清理线，起点早于它的差量查询需要重新加载。
+    const char* sql = R"(
+        CREATE TABLE IF NOT EXISTS ChangeSeq (
+            id INTEGER PRIMARY KEY CHECK(id = 0),
+            value INTEGER NOT NULL
+        );
+        INSERT OR IGNORE INTO ChangeSeq (id, value) VALUES (0, 0);
+
+        CREATE TABLE IF NOT EXISTS PasswordEntryTombstone (
+            entry_id INTEGER PRIMARY KEY,
+            codebook_id INTEGER NOT NULL,
+            deleted_seq INTEGER NOT NULL
+        );
+
+        CREATE INDEX IF NOT EXISTS idx_entry_seq ON PasswordEntry(codebook_id, updated_seq);
+        CREATE INDEX IF NOT EXISTS idx_tombstone_seq ON PasswordEntryTombstone(codebook_id, deleted_seq);
+
+        CREATE TRIGGER IF NOT EXISTS PasswordEntry_seq_insert AFTER INSERT ON PasswordEntry BEGIN
+            UPDATE ChangeSeq SET value = value + 1 WHERE id = 0;
+            UPDATE PasswordEntry SET updated_seq = (SELECT value FROM ChangeSeq WHERE id = 0)
+            WHERE entry_id = new.entry_id;
+            UPDATE Codebook SET updated_seq = (SELECT value FROM ChangeSeq WHERE id = 0),
+                entry_count = entry_count + 1,
+                total_bytes = total_bytes + length(CAST(new.address AS BLOB)) + length(new.encrypted_password)
+                              + COALESCE(length(CAST(new.notes AS BLOB)), 0),
+                modified_time = CURRENT_TIMESTAMP
+            WHERE codebook_id = new.codebook_id;
+        END;
+
+        CREATE TRIGGER IF NOT EXISTS PasswordEntry_seq_update AFTER UPDATE ON PasswordEntry
+        WHEN new.updated_seq IS old.updated_seq BEGIN
+            UPDATE ChangeSeq SET value = value + 1 WHERE id = 0;
+            UPDATE PasswordEntry SET updated_seq = (SELECT value FROM ChangeSeq WHERE id = 0)
+            WHERE entry_id = new.entry_id;
+            -- 条目移到其他密码本时先从原密码本扣除
+            UPDATE Codebook SET updated_seq = (SELECT value FROM ChangeSeq WHERE id = 0),
+                entry_count = entry_count - 1,
+                total_bytes = total_bytes - length(CAST(old.address AS BLOB)) - length(old.encrypted_password)
+                              - COALESCE(length(CAST(old.notes AS BLOB)), 0),
+                modified_time = CURRENT_TIMESTAMP
+            WHERE codebook_id = old.codebook_id AND old.codebook_id IS NOT new.codebook_id;
+            UPDATE Codebook SET updated_seq = (SELECT value FROM ChangeSeq WHERE id = 0),
+                entry_count = entry_count + (old.codebook_id IS NOT new.codebook_id),
+                total_bytes = total_bytes + length(CAST(new.address AS BLOB)) + length(new.encrypted_password)
+                              + COALESCE(length(CAST(new.notes AS BLOB)), 0)
+                              - CASE WHEN old.codebook_id IS new.codebook_id
+                                     THEN length(CAST(old.address AS BLOB)) + length(old.encrypted_password)
+                                          + COALESCE(length(CAST(old.notes AS BLOB)), 0)
+                                     ELSE 0 END,
+                modified_time = CURRENT_TIMESTAMP
+            WHERE codebook_id = new.codebook_id;
+        END;
+
+        CREATE TRIGGER IF NOT EXISTS PasswordEntry_seq_delete AFTER DELETE ON PasswordEntry BEGIN
+            UPDATE ChangeSeq SET value = value + 1 WHERE id = 0;
+            INSERT OR REPLACE INTO PasswordEntryTombstone (entry_id, codebook_id, deleted_seq)
+            VALUES (old.entry_id, old.codebook_id, (SELECT value FROM ChangeSeq WHERE id = 0));
+            DELETE FROM PasswordEntryTombstone
+            WHERE codebook_id = old.codebook_id
+              AND deleted_seq <= (SELECT value FROM ChangeSeq WHERE id = 0) - 10000;
+            UPDATE Codebook SET updated_seq = (SELECT value FROM ChangeSeq WHERE id = 0),
+                entry_count = entry_count - 1,
+                total_bytes = total_bytes - length(CAST(old.address AS BLOB)) - length(old.encrypted_password)
+                              - COALESCE(length(CAST(old.notes AS BLOB)), 0),
+                modified_time = CURRENT_TIMESTAMP,
+                tombstone_seq = MAX(tombstone_seq, (SELECT value FROM ChangeSeq WHERE id = 0) - 10000)
+            WHERE codebook_id = old.codebook_id;
+        END;
+
+        CREATE TRIGGER IF NOT EXISTS Codebook_seq_insert AFTER INSERT ON Codebook BEGIN
+            UPDATE ChangeSeq SET value = value + 1 WHERE id = 0;
+            UPDATE Codebook SET updated_seq = (SELECT value FROM ChangeSeq WHERE id = 0)
+            WHERE codebook_id = new.codebook_id;
+        END;
+
+        CREATE TRIGGER IF NOT EXISTS Codebook_seq_update AFTER UPDATE ON Codebook
+        WHEN new.updated_seq IS old.updated_seq BEGIN
+            UPDATE ChangeSeq SET value = value + 1 WHERE id = 0;
+            UPDATE Codebook SET updated_seq = (SELECT value FROM ChangeSeq WHERE id = 0)
+            WHERE codebook_id = new.codebook_id;
+        END;
+
+        -- 密码本删除后不会再有人查询它的差量，连同墓碑一起清理
+        CREATE TRIGGER IF NOT EXISTS Codebook_seq_delete AFTER DELETE ON Codebook BEGIN
+            UPDATE ChangeSeq SET value = value + 1 WHERE id = 0;
+            DELETE FROM PasswordEntryTombstone WHERE codebook_id = old.codebook_id;
+        END;
+    )";
+
+    return sqlite3_exec(db_, sql, nullptr, nullptr, nullptr) == SQLITE_OK;
+}
+
+bool UserAuth::CreateSearchIndex() {
+    // 地址与备注的 FTS5 trigram 全文索引（外部内容表，不重复存储文本），由触发器保持同步
+    const char* sql = R"(
+        CREATE VIRTUAL TABLE PasswordEntryFts USING fts5(
+            address, notes,
+            content='PasswordEntry', content_rowid='entry_id',
+            tokenize='trigram'
+        );
+
+        CREATE TRIGGER IF NOT EXISTS PasswordEntry_fts_insert AFTER INSERT ON PasswordEntry BEGIN
+            INSERT INTO PasswordEntryFts(rowid, address, notes)
+            VALUES (new.entry_id, new.address, new.notes);
+        END;
+
+        CREATE TRIGGER IF NOT EXISTS PasswordEntry_fts_delete AFTER DELETE ON PasswordEntry BEGIN
+            INSERT INTO PasswordEntryFts(PasswordEntryFts, rowid, address, notes)
+            VALUES ('delete', old.entry_id, old.address, old.notes);
+        END;
+
+        CREATE TRIGGER IF NOT EXISTS PasswordEntry_fts_update AFTER UPDATE OF address, notes ON PasswordEntry BEGIN
+            INSERT INTO PasswordEntryFts(PasswordEntryFts, rowid, address, notes)
+            VALUES ('delete', old.entry_id, old.address, old.notes);
+            INSERT INTO PasswordEntryFts(rowid, address, notes)
+            VALUES (new.entry_id, new.address, new.notes);
+        END;
+
+        INSERT INTO PasswordEntryFts(PasswordEntryFts) VALUES ('rebuild');
+    )";
+
+    {
+        auto stmt = statements_->Prepare(
+            "SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = 'PasswordEntryFts'");
+        if (Step(stmt) == SQLITE_ROW) {
+            return true;
+        }
+    }
+
+    // 首次创建时为已有条目建立索引；SQLite 未编译 FTS5 时跳过，搜索退回 LIKE 扫描
+    char* errMsg = nullptr;
+    if (sqlite3_exec(db_, "SAVEPOINT create_search_index", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    if (sqlite3_exec(db_, sql, nullptr, nullptr, &errMsg) != SQLITE_OK) {
+        const bool missingModule = errMsg && std::string(errMsg).find("no such module") != std::string::npos;
+        sqlite3_free(errMsg);
+        sqlite3_exec(db_, "ROLLBACK TO create_search_index; RELEASE create_search_index", nullptr, nullptr, nullptr);
+        return missingModule;
+    }
+    return sqlite3_exec(db_, "RELEASE create_search_index", nullptr, nullptr, nullptr) == SQLITE_OK;
+}
+
+bool UserAuth::HasColumn(const std::string& table, const std::string& column) {
+    const std::string sql = "PRAGMA table_info(" + table + ")";
+    auto stmt = statements_->Prepare(sql);
+
+    bool found = false;
+    while (Step(stmt) == SQLITE_ROW) {
+        if (column == reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1))) {
+            found = true;
+            break;
+        }
+    }
+    return found;
 }
 
 bool UserAuth::Register(const std::string& username, const std::string& password) {
+    ValidateRegistration(username, password);
+    if (CheckUserExists(username)) {
+        return false;
+    }
+    return CreateUser(username, HashPassword(password, kdf_.passwordHash));
+}
+
+void UserAuth::ValidateRegistration(const std::string& username, const std::string& password) {
     if (username.empty() || username.length() > 50) {
         throw std::invalid_argument("Username must be 1-50 characters");
     }
@@ -75,116 +384,233 @@ bool UserAuth::Register(const std::string& username, const std::string& password
     if (!ValidatePassword(password)) {
         throw std::invalid_argument("Password does not meet complexity requirements");
     }
+}
 
+bool UserAuth::CreateUser(const std::string& username, const std::string& passwordHash) {
     if (CheckUserExists(username)) {
         return false;
     }
 
-    std::string hash = GenerateHash(password);
-    
-    sqlite3_stmt* stmt;
     const char* sql = "INSERT INTO User (username, password_hash) VALUES (?, ?)";
-    
-    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        throw std::runtime_error("Prepare statement failed: " + std::string(sqlite3_errmsg(db_)));
-    }
+    auto stmt = statements_->Prepare(sql);
 
     sqlite3_bind_text(stmt, 1, username.c_str(), -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 2, hash.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, passwordHash.c_str(), -1, SQLITE_STATIC);
 
-    bool success = sqlite3_step(stmt) == SQLITE_DONE;
-    sqlite3_finalize(stmt);
+    bool success = Step(stmt) == SQLITE_DONE;
     return success;
 }
 
-bool UserAuth::Login(const std::string& username, const std::string& password, 
-                   std::vector<CodebookInfo>& codebooks) {
-    std::string stored_hash;
-    if (!GetUserHash(username, stored_hash)) {
+bool UserAuth::Login(const std::string& username, const std::string& password) {
+    PASSMGR_SPAN("auth.login");
+    Credentials credentials;
+    LoginResult result;
+    if (!LoadCredentials(db_, username, credentials) || !VerifyPassword(credentials, password, result)) {
+        PASSMGR_COUNT("auth.login.failed", 1);
         return false;
     }
-    
-    if (crypto_pwhash_str_verify(stored_hash.c_str(),
-                                password.c_str(),
-                                password.length()) != 0) {
+    if (!result.newPasswordHash.empty()) {
+        CompleteLogin(username, result);
+    }
+    return true;
+}
+
+bool UserAuth::LoadCredentials(sqlite3* db, const std::string& username, Credentials& credentials) {
+    const char* sql = "SELECT password_hash, kdf_salt, kdf_params FROM User WHERE username = ?";
+    auto stmt = StatementCache::ForConnection(db)->Prepare(sql);
+
+    sqlite3_bind_text(stmt, 1, username.c_str(), -1, SQLITE_STATIC);
+
+    if (Step(stmt) != SQLITE_ROW) {
         return false;
     }
-    
-    return GetUserCodebooks(username, codebooks);
+
+    credentials.passwordHash = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+    const auto* salt = static_cast<const uint8_t*>(sqlite3_column_blob(stmt, 1));
+    credentials.kdfSalt.assign(salt, salt + sqlite3_column_bytes(stmt, 1));
+    credentials.kdfParams = KdfParams::moderate();
+    if (sqlite3_column_type(stmt, 2) != SQLITE_NULL) {
+        credentials.kdfParams = KdfParams::decode(static_cast<const uint8_t*>(sqlite3_column_blob(stmt, 2)),
+                                                  static_cast<size_t>(sqlite3_column_bytes(stmt, 2)));
+    }
+    return true;
+}
+
+bool UserAuth::VerifyPassword(const Credentials& credentials, const std::string& password, LoginResult& result) const {
+    {
+        PASSMGR_SPAN("auth.login.verify");
+        if (crypto_pwhash_str_verify(credentials.passwordHash.c_str(), password.c_str(), password.length()) != 0) {
+            return false;
+        }
+    }
+
+    // 哈希字符串自带参数，与当前配置不一致时趁明文密码在手重新哈希
+    if (crypto_pwhash_str_needs_rehash(credentials.passwordHash.c_str(), kdf_.passwordHash.opsLimit,
+                                       kdf_.passwordHash.memLimit) != 0) {
+        result.newPasswordHash = HashPassword(password, kdf_.passwordHash);
+    }
+    return true;
+}
+
+void UserAuth::DeriveKeys(const Credentials& credentials, const std::string& password, LoginResult& result) {
+    PASSMGR_SPAN("auth.derive_session_key");
+    if (credentials.kdfSalt.size() == crypto_pwhash_SALTBYTES) {
+        auto kek = crypto_.deriveSessionKey(password, credentials.kdfSalt, credentials.kdfParams);
+        if (credentials.kdfParams == kdf_.sessionKey) {
+            result.sessionKey = kek;
+            return;
+        }
+        // 参数已变更：换用新盐重新派生，旧会话密钥只用于解开已包裹的数据密钥
+        result.previousSessionKey = kek;
+    }
+
+    // 老用户首次登录时生成会话密钥盐
+    result.newKdfSalt = crypto_.generateSalt();
+    result.sessionKey = crypto_.deriveSessionKey(password, result.newKdfSalt, kdf_.sessionKey);
+}
+
+void UserAuth::CompleteLogin(const std::string& username, const LoginResult& result) {
+    // 重新哈希写入失败不影响本次登录，下次登录时再试
+    if (!result.newPasswordHash.empty()) {
+        auto stmt = statements_->Prepare("UPDATE User SET password_hash = ? WHERE username = ?");
+        sqlite3_bind_text(stmt, 1, result.newPasswordHash.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 2, username.c_str(), -1, SQLITE_STATIC);
+        Step(stmt);
+    }
+
+    if (result.newKdfSalt.empty()) {
+        return;
+    }
+    if (result.previousSessionKey) {
+        UpgradeKeyParams(username, *result.previousSessionKey, *result.sessionKey, result.newKdfSalt);
+    } else {
+        SaveKdfParams(username, result.newKdfSalt);
+    }
 }
 
 bool UserAuth::CheckUserExists(const std::string& username) {
-    sqlite3_stmt* stmt;
     const char* sql = "SELECT 1 FROM User WHERE username = ?";
-    
-    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        throw std::runtime_error("Prepare statement failed: " + std::string(sqlite3_errmsg(db_)));
-    }
+    auto stmt = statements_->Prepare(sql);
     
     sqlite3_bind_text(stmt, 1, username.c_str(), -1, SQLITE_STATIC);
-    bool exists = (sqlite3_step(stmt) == SQLITE_ROW);
-    sqlite3_finalize(stmt);
+    bool exists = (Step(stmt) == SQLITE_ROW);
     return exists;
 }
 
 bool UserAuth::ValidatePassword(const std::string& password) {
-    std::regex pattern(R"((?=.*\d)(?=.*[a-z])(?=.*[A-Z]).{8,32})");
-    return std::regex_match(password, pattern);
+    return MeetsComplexityRule(password);
 }
 
-std::string UserAuth::GenerateHash(const std::string& password) {
+std::string UserAuth::HashPassword(const std::string& password, const KdfParams& params) {
     char hash[crypto_pwhash_STRBYTES];
     if (crypto_pwhash_str(hash, password.c_str(), password.length(),
-                         crypto_pwhash_OPSLIMIT_SENSITIVE,
-                         crypto_pwhash_MEMLIMIT_SENSITIVE) != 0) {
+                         params.opsLimit, params.memLimit) != 0) {
         throw std::runtime_error("Password hashing failed");
     }
     return std::string(hash);
 }
 
-bool UserAuth::GetUserHash(const std::string& username, std::string& stored_hash) {
-    sqlite3_stmt* stmt;
-    const char* sql = "SELECT password_hash FROM User WHERE username = ?";
-    
-    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        throw std::runtime_error("Prepare statement failed: " + std::string(sqlite3_errmsg(db_)));
+std::shared_ptr<SecureKey> UserAuth::DeriveSessionKey(const std::string& username, const std::string& password) {
+    Credentials credentials;
+    if (!LoadCredentials(db_, username, credentials)) {
+        throw std::runtime_error("User not found");
     }
-    
-    sqlite3_bind_text(stmt, 1, username.c_str(), -1, SQLITE_STATIC);
-    
-    if (sqlite3_step(stmt) != SQLITE_ROW) {
-        sqlite3_finalize(stmt);
-        return false;
+    LoginResult result;
+    DeriveKeys(credentials, password, result);
+    CompleteLogin(username, result);
+    return result.sessionKey;
+}
+
+void UserAuth::SaveKdfParams(const std::string& username, const std::vector<uint8_t>& salt) {
+    const std::vector<uint8_t> params = kdf_.sessionKey.encode();
+    const char* sql = "UPDATE User SET kdf_salt = ?, kdf_params = ? WHERE username = ?";
+    auto stmt = statements_->Prepare(sql);
+
+    sqlite3_bind_blob(stmt, 1, salt.data(), static_cast<int>(salt.size()), SQLITE_STATIC);
+    sqlite3_bind_blob(stmt, 2, params.data(), static_cast<int>(params.size()), SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 3, username.c_str(), -1, SQLITE_STATIC);
+
+    if (Step(stmt) != SQLITE_DONE) {
+        throw std::runtime_error("Saving key salt failed: " + std::string(sqlite3_errmsg(db_)));
     }
-    
-    stored_hash = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
-    sqlite3_finalize(stmt);
-    return true;
 }
 
-bool UserAuth::GetUserCodebooks(const std::string& username, std::vector<CodebookInfo>& codebooks) {
-    sqlite3_stmt* stmt;
-    const char* sql = R"(
-        SELECT codebook_id, codebook_name, created_time
-        FROM Codebook
-        WHERE username = ?
-        ORDER BY created_time DESC
-    )";
-    
-    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        throw std::runtime_error("Prepare statement failed: " + std::string(sqlite3_errmsg(db_)));
+void UserAuth::UpgradeKeyParams(const std::string& username, const SecureKey& oldKek, const SecureKey& newKek,
+                                const std::vector<uint8_t>& salt) {
+    // 条目由数据密钥加密，换会话密钥只需重新包裹数据密钥（含轮换未完成时保留的旧数据密钥）
+    struct Rewrapped {
+        int codebook_id;
+        std::vector<uint8_t> wrapped_key;
+        std::vector<uint8_t> previous_wrapped_key;
+        bool has_previous;
+    };
+
+    auto rewrap = [&](sqlite3_stmt* stmt, int column) {
+        const auto* data = static_cast<const uint8_t*>(sqlite3_column_blob(stmt, column));
+        const std::vector<uint8_t> wrapped(data, data + sqlite3_column_bytes(stmt, column));
+        return crypto_.wrapKey(newKek, *crypto_.unwrapKey(oldKek, wrapped));
+    };
+
+    // 保存点可以嵌套在连接池写线程的成组事务中，单独调用时则自成一个事务
+    {
+        auto begin = statements_->Prepare("SAVEPOINT upgrade_key_params");
+        if (Step(begin) != SQLITE_DONE) {
+            throw std::runtime_error("Failed to start transaction");
+        }
     }
-    
-    sqlite3_bind_text(stmt, 1, username.c_str(), -1, SQLITE_STATIC);
-    
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        CodebookInfo info;
-        info.id = sqlite3_column_int(stmt, 0);
-        info.name = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-        info.created_time = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
-        codebooks.push_back(info);
+
+    try {
+        std::vector<Rewrapped> codebooks;
+        {
+            const char* sql = R"(
+                SELECT codebook_id, wrapped_key, previous_wrapped_key
+                FROM Codebook
+                WHERE username = ? AND wrapped_key IS NOT NULL
+            )";
+            auto stmt = statements_->Prepare(sql);
+            sqlite3_bind_text(stmt, 1, username.c_str(), -1, SQLITE_STATIC);
+
+            while (Step(stmt) == SQLITE_ROW) {
+                Rewrapped codebook;
+                codebook.codebook_id = sqlite3_column_int(stmt, 0);
+                codebook.wrapped_key = rewrap(stmt, 1);
+                codebook.has_previous = sqlite3_column_type(stmt, 2) != SQLITE_NULL;
+                if (codebook.has_previous) {
+                    codebook.previous_wrapped_key = rewrap(stmt, 2);
+                }
+                codebooks.push_back(std::move(codebook));
+            }
+        }
+
+        {
+            const char* sql = "UPDATE Codebook SET wrapped_key = ?, previous_wrapped_key = ? WHERE codebook_id = ?";
+            auto stmt = statements_->Prepare(sql);
+            for (const auto& codebook : codebooks) {
+                sqlite3_bind_blob(stmt, 1, codebook.wrapped_key.data(),
+                                  static_cast<int>(codebook.wrapped_key.size()), SQLITE_STATIC);
+                if (codebook.has_previous) {
+                    sqlite3_bind_blob(stmt, 2, codebook.previous_wrapped_key.data(),
+                                      static_cast<int>(codebook.previous_wrapped_key.size()), SQLITE_STATIC);
+                } else {
+                    sqlite3_bind_null(stmt, 2);
+                }
+                sqlite3_bind_int(stmt, 3, codebook.codebook_id);
+                const int rc = Step(stmt);
+                sqlite3_reset(stmt);
+                if (rc != SQLITE_DONE) {
+                    throw std::runtime_error("Update codebook key failed: " + std::string(sqlite3_errmsg(db_)));
+                }
+            }
+        }
+
+        SaveKdfParams(username, salt);
+
+        auto commit = statements_->Prepare("RELEASE upgrade_key_params");
+        if (Step(commit) != SQLITE_DONE) {
+            throw std::runtime_error("Commit failed: " + std::string(sqlite3_errmsg(db_)));
+        }
+    } catch (...) {
+        sqlite3_exec(db_, "ROLLBACK TO upgrade_key_params; RELEASE upgrade_key_params", nullptr, nullptr, nullptr);
+        throw;
     }
-    
-    sqlite3_finalize(stmt);
-    return true;
-}
\ No newline at end of file
+}
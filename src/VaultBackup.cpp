@@ -0,0 +1,543 @@
+#include "VaultBackup.h"
+#include <sodium.h>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+using namespace std;
+
+namespace {
+
+const char kBackupMagic[4] = {'P', 'M', 'B', 'K'};
+// 版本 1 没有派生参数字段，固定使用 MODERATE；版本 2 在 salt 之后记录参数
+const uint8_t kBackupVersion = 2;
+const uint8_t kBackupVersionFixedKdf = 1;
+const size_t kBackupPrefixBytes = sizeof(kBackupMagic) + 1;
+
+size_t BackupHeaderBytes(uint8_t version) {
+    return kBackupPrefixBytes + crypto_pwhash_SALTBYTES +
+           (version == kBackupVersionFixedKdf ? 0 : KdfParams::kEncodedBytes) +
+           crypto_secretstream_xchacha20poly1305_HEADERBYTES;
+}
+// 明文累积到该大小即封装为一个 chunk；单个 chunk 的上限用于拒绝损坏的长度字段
+const size_t kChunkBytes = 64 * 1024;
+const uint32_t kMaxChunkBytes = 16 * 1024 * 1024;
+
+enum RecordType : uint8_t {
+    kRecordCodebook = 1,   // name, created_time
+    kRecordEntry = 2,      // address, password, notes, created_time
+};
+
+static_assert(crypto_secretstream_xchacha20poly1305_KEYBYTES == SecureKey::kKeyBytes,
+              "SecureKey size must match secretstream key size");
+
+void PutU32(vector<uint8_t>& out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+}
+
+uint32_t GetU32(const uint8_t* in) {
+    return static_cast<uint32_t>(in[0]) | static_cast<uint32_t>(in[1]) << 8 |
+           static_cast<uint32_t>(in[2]) << 16 | static_cast<uint32_t>(in[3]) << 24;
+}
+
+void PutField(vector<uint8_t>& out, const void* data, size_t size) {
+    PutU32(out, static_cast<uint32_t>(size));
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    out.insert(out.end(), bytes, bytes + size);
+}
+
+void PutField(vector<uint8_t>& out, const string& text) {
+    PutField(out, text.data(), text.size());
+}
+
+void Wipe(vector<uint8_t>& buffer) {
+    if (!buffer.empty()) {
+        sodium_memzero(buffer.data(), buffer.size());
+    }
+    buffer.clear();
+}
+
+void Wipe(string& text) {
+    if (!text.empty()) {
+        sodium_memzero(&text[0], text.size());
+    }
+    text.clear();
+}
+
+// 写端：文件头作为每个 chunk 的附加数据，篡改版本或 salt 会导致校验失败
+class BackupWriter {
+public:
+    BackupWriter(const string& path, const SecureKey& key, const vector<uint8_t>& salt, const KdfParams& params)
+        : path_(path), out_(path, ios::binary | ios::trunc) {
+        if (!out_) {
+            throw runtime_error("无法创建备份文件: " + path);
+        }
+
+        if (salt.size() != crypto_pwhash_SALTBYTES) {
+            throw invalid_argument("Invalid backup salt");
+        }
+        header_.resize(BackupHeaderBytes(kBackupVersion));
+        memcpy(header_.data(), kBackupMagic, sizeof(kBackupMagic));
+        header_[sizeof(kBackupMagic)] = kBackupVersion;
+        memcpy(header_.data() + kBackupPrefixBytes, salt.data(), salt.size());
+        const vector<uint8_t> encoded = params.encode();
+        memcpy(header_.data() + kBackupPrefixBytes + salt.size(), encoded.data(), encoded.size());
+        crypto_secretstream_xchacha20poly1305_init_push(
+            &state_, header_.data() + header_.size() - crypto_secretstream_xchacha20poly1305_HEADERBYTES,
+            key.data());
+        Write(header_.data(), header_.size());
+    }
+
+    ~BackupWriter() {
+        Wipe(buffer_);
+        sodium_memzero(&state_, sizeof(state_));
+    }
+
+    vector<uint8_t>& Buffer() { return buffer_; }
+
+    void FlushIfFull() {
+        if (buffer_.size() >= kChunkBytes) {
+            Push(0);
+        }
+    }
+
+    void Finish() {
+        Push(crypto_secretstream_xchacha20poly1305_TAG_FINAL);
+        out_.close();
+        if (!out_) {
+            throw runtime_error("写入备份文件失败: " + path_);
+        }
+    }
+
+private:
+    void Push(uint8_t tag) {
+        vector<uint8_t> chunk(buffer_.size() + crypto_secretstream_xchacha20poly1305_ABYTES);
+        crypto_secretstream_xchacha20poly1305_push(
+            &state_, chunk.data(), nullptr, buffer_.data(), buffer_.size(),
+            header_.data(), header_.size(), tag);
+        Wipe(buffer_);
+
+        vector<uint8_t> length;
+        PutU32(length, static_cast<uint32_t>(chunk.size()));
+        Write(length.data(), length.size());
+        Write(chunk.data(), chunk.size());
+    }
+
+    void Write(const uint8_t* data, size_t size) {
+        out_.write(reinterpret_cast<const char*>(data), static_cast<streamsize>(size));
+        if (!out_) {
+            throw runtime_error("写入备份文件失败: " + path_);
+        }
+    }
+
+    const string path_;
+    ofstream out_;
+    vector<uint8_t> header_;
+    vector<uint8_t> buffer_;
+    crypto_secretstream_xchacha20poly1305_state state_;
+};
+
+// 读端：逐个 chunk 解密校验，任何篡改、截断或尾部多余数据都会抛出异常
+class BackupReader {
+public:
+    explicit BackupReader(const string& path) : in_(path, ios::binary) {
+        if (!in_) {
+            throw runtime_error("无法打开备份文件: " + path);
+        }
+        in_.seekg(0, ios::end);
+        totalBytes_ = static_cast<uint64_t>(in_.tellg());
+        in_.seekg(0, ios::beg);
+
+        header_.resize(kBackupPrefixBytes);
+        if (!Read(header_.data(), header_.size()) ||
+            memcmp(header_.data(), kBackupMagic, sizeof(kBackupMagic)) != 0) {
+            throw runtime_error("不是有效的备份文件");
+        }
+        const uint8_t version = header_[sizeof(kBackupMagic)];
+        if (version != kBackupVersion && version != kBackupVersionFixedKdf) {
+            throw runtime_error("不支持的备份文件版本");
+        }
+        header_.resize(BackupHeaderBytes(version));
+        if (!Read(header_.data() + kBackupPrefixBytes, header_.size() - kBackupPrefixBytes)) {
+            throw runtime_error("不是有效的备份文件");
+        }
+
+        params_ = KdfParams::moderate();
+        if (version != kBackupVersionFixedKdf) {
+            // 参数超出范围说明文件头已损坏；参数本身被篡改会导致派生出错误的密钥，校验失败
+            try {
+                params_ = KdfParams::decode(header_.data() + kBackupPrefixBytes + crypto_pwhash_SALTBYTES,
+                                            KdfParams::kEncodedBytes);
+            } catch (const runtime_error&) {
+                throw runtime_error("备份文件已损坏");
+            }
+        }
+    }
+
+    ~BackupReader() {
+        sodium_memzero(&state_, sizeof(state_));
+    }
+
+    vector<uint8_t> Salt() const {
+        auto begin = header_.begin() + kBackupPrefixBytes;
+        return vector<uint8_t>(begin, begin + crypto_pwhash_SALTBYTES);
+    }
+
+    const KdfParams& Params() const { return params_; }
+
+    // 按文件头记录的参数派生备份密钥
+    shared_ptr<SecureKey> DeriveKey(CryptoModule& crypto, const string& passphrase) const {
+        return crypto.deriveSessionKey(passphrase, Salt(), params_);
+    }
+
+    void Open(const SecureKey& key) {
+        const uint8_t* streamHeader = header_.data() + header_.size() - crypto_secretstream_xchacha20poly1305_HEADERBYTES;
+        if (crypto_secretstream_xchacha20poly1305_init_pull(&state_, streamHeader, key.data()) != 0) {
+            throw runtime_error("不是有效的备份文件");
+        }
+    }
+
+    // 读取下一个 chunk，返回 false 表示已读到 TAG_FINAL
+    bool Next(vector<uint8_t>& plaintext) {
+        uint8_t length[4];
+        if (!Read(length, sizeof(length))) {
+            throw runtime_error("备份文件不完整");
+        }
+        const uint32_t chunkSize = GetU32(length);
+        if (chunkSize < crypto_secretstream_xchacha20poly1305_ABYTES || chunkSize > kMaxChunkBytes) {
+            throw runtime_error("备份文件已损坏");
+        }
+
+        vector<uint8_t> chunk(chunkSize);
+        if (!Read(chunk.data(), chunk.size())) {
+            throw runtime_error("备份文件不完整");
+        }
+
+        Wipe(plaintext);
+        plaintext.resize(chunkSize - crypto_secretstream_xchacha20poly1305_ABYTES);
+        unsigned long long plaintextSize = 0;
+        uint8_t tag = 0;
+        if (crypto_secretstream_xchacha20poly1305_pull(
+                &state_, plaintext.data(), &plaintextSize, &tag,
+                chunk.data(), chunk.size(), header_.data(), header_.size()) != 0) {
+            throw runtime_error("备份口令错误或文件已损坏");
+        }
+        plaintext.resize(static_cast<size_t>(plaintextSize));
+
+        if (tag != crypto_secretstream_xchacha20poly1305_TAG_FINAL) {
+            return true;
+        }
+        if (in_.peek() != char_traits<char>::eof()) {
+            throw runtime_error("备份文件已损坏");
+        }
+        return false;
+    }
+
+    uint64_t BytesRead() const { return bytesRead_; }
+    uint64_t TotalBytes() const { return totalBytes_; }
+
+private:
+    bool Read(uint8_t* data, size_t size) {
+        in_.read(reinterpret_cast<char*>(data), static_cast<streamsize>(size));
+        bytesRead_ += static_cast<uint64_t>(in_.gcount());
+        return static_cast<size_t>(in_.gcount()) == size;
+    }
+
+    ifstream in_;
+    uint64_t totalBytes_ = 0;
+    uint64_t bytesRead_ = 0;
+    vector<uint8_t> header_;
+    KdfParams params_ = KdfParams::moderate();
+    crypto_secretstream_xchacha20poly1305_state state_;
+};
+
+// 解析一个 chunk 内的记录：type ‖ u32 字段数 ‖ { u32 长度 ‖ 字段 }*
+class RecordParser {
+public:
+    explicit RecordParser(const vector<uint8_t>& chunk) : pos_(chunk.data()), end_(chunk.data() + chunk.size()) {}
+
+    bool Next(uint8_t& type, vector<string>& fields) {
+        for (auto& field : fields) {
+            Wipe(field);
+        }
+        fields.clear();
+        if (pos_ == end_) {
+            return false;
+        }
+
+        type = *pos_++;
+        const uint32_t count = ReadU32();
+        for (uint32_t i = 0; i < count; ++i) {
+            const uint32_t size = ReadU32();
+            if (static_cast<size_t>(end_ - pos_) < size) {
+                throw runtime_error("备份记录格式错误");
+            }
+            fields.emplace_back(reinterpret_cast<const char*>(pos_), size);
+            pos_ += size;
+        }
+        return true;
+    }
+
+private:
+    uint32_t ReadU32() {
+        if (end_ - pos_ < 4) {
+            throw runtime_error("备份记录格式错误");
+        }
+        const uint32_t value = GetU32(pos_);
+        pos_ += 4;
+        return value;
+    }
+
+    const uint8_t* pos_;
+    const uint8_t* end_;
+};
+
+} // namespace
+
+// 恢复时按密码本累积一页明文，批量加密后在一个事务内写入
+struct VaultBackup::RestoreTarget {
+    string username;
+    int codebookId = -1;
+    shared_ptr<SecureKey> key;
+    vector<PasswordVault::PasswordEntry> entries;
+    vector<vector<uint8_t>> passwords;
+    vector<int> created;   // 本次恢复新建的密码本
+};
+
+VaultBackup::VaultBackup(PasswordVault& vault, shared_ptr<SessionKeyring> keyring)
+    : vault_(vault), keyring_(move(keyring)) {
+    if (!keyring_) {
+        throw invalid_argument("Invalid session keyring");
+    }
+}
+
+BackupStats VaultBackup::ExportUser(const string& username, const string& path,
+                                    const string& passphrase, const BackupOptions& options) {
+    return ExportCodebooks(vault_.GetUserCodebooks(username), path, passphrase, options);
+}
+
+BackupStats VaultBackup::ExportCodebooks(const vector<PasswordVault::Codebook>& codebooks, const string& path,
+                                         const string& passphrase, const BackupOptions& options) {
+    if (passphrase.empty()) {
+        throw invalid_argument("备份口令不能为空");
+    }
+
+    uint64_t total = 0;
+    for (const auto& codebook : codebooks) {
+        total += static_cast<uint64_t>(vault_.CountEntries(codebook.id));
+    }
+
+    // 先写入临时文件，完成后再替换目标文件，失败时不留下半个备份
+    const string tempPath = path + ".tmp";
+    const vector<uint8_t> salt = crypto_.generateSalt();
+    const KdfParams& params = keyring_->Kdf().sessionKey;
+    auto key = crypto_.deriveSessionKey(passphrase, salt, params);
+    BackupStats stats;
+
+    try {
+        BackupWriter writer(tempPath, *key, salt, params);
+        for (const auto& codebook : codebooks) {
+            auto& buffer = writer.Buffer();
+            buffer.push_back(kRecordCodebook);
+            PutU32(buffer, 2);
+            PutField(buffer, codebook.name);
+            PutField(buffer, codebook.created_time);
+            ++stats.codebooks;
+
+            auto codebookKey = keyring_->GetCodebookKey(vault_, codebook.id);
+            PasswordVault::EntryPage page;
+            do {
+                page = vault_.GetEntries(codebook.id, "", page.next_after_id, options.pageSize);
+                vector<vector<uint8_t>> blobs;
+                for (auto& entry : page.entries) {
+                    blobs.push_back(move(entry.encrypted_password));
+                }
+                auto plaintexts = keyring_->DecryptBatch(*codebookKey, blobs);
+
+                for (size_t i = 0; i < page.entries.size(); ++i) {
+                    if (!plaintexts[i].ok) {
+                        ++stats.skipped;
+                        continue;
+                    }
+                    const auto& entry = page.entries[i];
+                    auto& out = writer.Buffer();
+                    out.push_back(kRecordEntry);
+                    PutU32(out, 4);
+                    PutField(out, entry.address);
+                    PutField(out, plaintexts[i].plaintext.data(), plaintexts[i].plaintext.size());
+                    PutField(out, entry.notes);
+                    PutField(out, entry.created_time);
+                    Wipe(plaintexts[i].plaintext);
+                    ++stats.entries;
+                    writer.FlushIfFull();
+                }
+
+                if (options.progress && !options.progress(stats.entries + stats.skipped, total)) {
+                    stats.canceled = true;
+                    break;
+                }
+            } while (page.has_more);
+
+            if (stats.canceled) {
+                break;
+            }
+        }
+
+        if (!stats.canceled) {
+            writer.Finish();
+        }
+    } catch (...) {
+        remove(tempPath.c_str());
+        throw;
+    }
+
+    if (stats.canceled) {
+        remove(tempPath.c_str());
+        return stats;
+    }
+    remove(path.c_str());
+    if (rename(tempPath.c_str(), path.c_str()) != 0) {
+        remove(tempPath.c_str());
+        throw runtime_error("无法写入备份文件: " + path);
+    }
+    return stats;
+}
+
+BackupStats VaultBackup::Verify(const string& path, const string& passphrase) {
+    auto key = BackupReader(path).DeriveKey(crypto_, passphrase);
+    return ReadBackup(path, *key, nullptr, BackupOptions());
+}
+
+BackupStats VaultBackup::Restore(const string& username, const string& path,
+                                 const string& passphrase, const BackupOptions& options) {
+    auto key = BackupReader(path).DeriveKey(crypto_, passphrase);
+
+    // 第一遍只校验；口令错误、截断或篡改在写入任何数据前就会被发现。
+    // 两遍各占进度的一半
+    BackupOptions verifyOptions;
+    BackupOptions restoreOptions;
+    restoreOptions.pageSize = options.pageSize;
+    if (options.progress) {
+        verifyOptions.progress = [&options](uint64_t done, uint64_t total) {
+            return options.progress(done, total * 2);
+        };
+        restoreOptions.progress = [&options](uint64_t done, uint64_t total) {
+            return options.progress(total + done, total * 2);
+        };
+    }
+
+    BackupStats verified = ReadBackup(path, *key, nullptr, verifyOptions);
+    if (verified.canceled) {
+        return verified;
+    }
+
+    // 第二遍在一个事务内写入：中途取消或出错时整体回滚，不留下部分恢复的数据
+    RestoreTarget target;
+    target.username = username;
+    BackupStats stats;
+    // 回滚后新建密码本的 id 可能被重新分配，不能继续缓存其数据密钥
+    auto forgetCreated = [&] {
+        for (int id : target.created) {
+            keyring_->ForgetCodebook(id);
+        }
+    };
+    try {
+        const bool committed = vault_.RunInTransaction([&] {
+            stats = ReadBackup(path, *key, &target, restoreOptions);
+            return !stats.canceled;
+        });
+        if (!committed) {
+            forgetCreated();
+        }
+    } catch (...) {
+        forgetCreated();
+        throw;
+    }
+    return stats;
+}
+
+BackupStats VaultBackup::ReadBackup(const string& path, const SecureKey& key,
+                                    RestoreTarget* target, const BackupOptions& options) {
+    BackupReader reader(path);
+    reader.Open(key);
+    BackupStats stats;
+
+    auto flush = [&] {
+        if (!target || target->entries.empty()) {
+            return;
+        }
+        auto encrypted = crypto_.encryptBatch(*target->key, target->passwords);
+        for (size_t i = 0; i < encrypted.size(); ++i) {
+            target->entries[i].encrypted_password = move(encrypted[i]);
+            Wipe(target->passwords[i]);
+        }
+        const vector<bool> inserted = vault_.AddEntries(target->codebookId, target->entries);
+        for (bool ok : inserted) {
+            if (!ok) ++stats.skipped;
+        }
+        target->entries.clear();
+        target->passwords.clear();
+    };
+
+    vector<uint8_t> chunk;
+    vector<string> fields;
+    uint8_t type = 0;
+    bool more = true;
+    while (more) {
+        more = reader.Next(chunk);
+
+        RecordParser parser(chunk);
+        while (parser.Next(type, fields)) {
+            if (type == kRecordCodebook && fields.size() >= 1) {
+                ++stats.codebooks;
+                if (!target) continue;
+
+                flush();
+                // 同名密码本已存在时合并到其中；新建的密码本沿用备份中的创建时间
+                const string createdTime = fields.size() >= 2 ? fields[1] : "";
+                target->codebookId = vault_.CreateCodebook(target->username, fields[0], createdTime).id;
+                if (target->codebookId >= 0) {
+                    target->created.push_back(target->codebookId);
+                } else {
+                    target->codebookId = vault_.GetCodebookId(target->username, fields[0]);
+                }
+                if (target->codebookId < 0) {
+                    throw runtime_error("无法创建密码本: " + fields[0]);
+                }
+                target->key = keyring_->GetCodebookKey(vault_, target->codebookId);
+            } else if (type == kRecordEntry && fields.size() >= 3) {
+                ++stats.entries;
+                if (!target) continue;
+                if (target->codebookId < 0) {
+                    throw runtime_error("备份记录格式错误");
+                }
+
+                PasswordVault::PasswordEntry entry;
+                entry.address = fields[0];
+                entry.notes = fields[2];
+                if (fields.size() >= 4) {
+                    entry.created_time = fields[3];
+                }
+                target->entries.push_back(move(entry));
+                target->passwords.emplace_back(fields[1].begin(), fields[1].end());
+                if (static_cast<int>(target->entries.size()) >= options.pageSize) {
+                    flush();
+                }
+            }
+            // 未知类型的记录留给后续版本，直接跳过
+        }
+
+        if (options.progress && !options.progress(reader.BytesRead(), reader.TotalBytes())) {
+            stats.canceled = true;
+            break;
+        }
+    }
+    Wipe(chunk);
+
+    if (!stats.canceled) {
+        flush();
+    }
+    return stats;
+}
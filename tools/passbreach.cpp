@@ -0,0 +1,82 @@
+// 将泄露密码列表导入为本地泄露库：
+//   passbreach 输出文件 列表1 [列表2 ...]
+//   passbreach --hibp 输出文件 哈希列表
+// 默认每行一个明文密码，计算 SHA-1 后排序去重；--hibp 读取 HIBP 按哈希排序的 "SHA1:次数" 列表，
+// 逐行流式写入，不需要把整个列表读入内存。
+// 生成的 passmgr.breach 放在程序工作目录下，重复密码检查时会同时标出已泄露的密码。
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "BreachStore.h"
+
+namespace {
+
+void ImportHibp(const char* input, const char* output) {
+    std::ifstream in(input);
+    if (!in) {
+        throw std::runtime_error(std::string("无法打开列表: ") + input);
+    }
+
+    BreachStoreWriter writer(output);
+    std::string line;
+    size_t lineNumber = 0;
+    while (std::getline(in, line)) {
+        ++lineNumber;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty()) continue;
+        const size_t colon = line.find(':');
+        const size_t length = colon == std::string::npos ? line.size() : colon;
+        BreachStore::Digest digest;
+        if (!BreachStore::ParseHex(line.data(), length, digest)) {
+            throw std::runtime_error("第 " + std::to_string(lineNumber) + " 行不是 SHA-1 摘要");
+        }
+        writer.Add(digest);
+    }
+    writer.Finish();
+}
+
+void ImportPlaintext(char* inputs[], int count, const char* output) {
+    std::vector<BreachStore::Digest> digests;
+    for (int i = 0; i < count; ++i) {
+        std::ifstream in(inputs[i]);
+        if (!in) {
+            throw std::runtime_error(std::string("无法打开列表: ") + inputs[i]);
+        }
+        std::string line;
+        while (std::getline(in, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (!line.empty()) digests.push_back(BreachStore::Hash(line));
+        }
+    }
+    BreachStoreWriter::Write(std::move(digests), output);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const bool hibp = argc > 1 && std::strcmp(argv[1], "--hibp") == 0;
+    const int first = hibp ? 2 : 1;
+    if (argc - first < 2 || (hibp && argc - first != 2)) {
+        std::cerr << "用法: passbreach 输出文件 列表1 [列表2 ...]\n"
+                  << "      passbreach --hibp 输出文件 哈希列表" << std::endl;
+        return 2;
+    }
+
+    try {
+        const char* output = argv[first];
+        if (hibp) {
+            ImportHibp(argv[first + 1], output);
+        } else {
+            ImportPlaintext(argv + first + 1, argc - first - 1, output);
+        }
+        auto store = BreachStore::Open(output);
+        std::cout << output << ": " << store->Count() << " 个摘要" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,54 @@
+// 将词表编译为强度估计使用的字典文件：
+//   passdict 输出文件 词表1 [词表2 ...]
+// 每个词表每行一个词，按常见程度排序；多个词表按行交错合并，使各表中排名相近的词排名也相近。
+// 生成的 passmgr.dict 放在程序工作目录下即可替换内置词表。
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "PasswordDictionary.h"
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "用法: passdict 输出文件 词表1 [词表2 ...]" << std::endl;
+        return 2;
+    }
+
+    std::vector<std::vector<std::string>> lists;
+    for (int i = 2; i < argc; ++i) {
+        std::ifstream in(argv[i]);
+        if (!in) {
+            std::cerr << "无法打开词表: " << argv[i] << std::endl;
+            return 1;
+        }
+        std::vector<std::string> words;
+        std::string line;
+        while (std::getline(in, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (!line.empty()) words.push_back(line);
+        }
+        lists.push_back(std::move(words));
+    }
+
+    std::vector<std::string> merged;
+    for (size_t row = 0;; ++row) {
+        bool any = false;
+        for (const auto& words : lists) {
+            if (row < words.size()) {
+                merged.push_back(words[row]);
+                any = true;
+            }
+        }
+        if (!any) break;
+    }
+
+    try {
+        PasswordDictionary::CompileFile(merged, argv[1]);
+        auto dictionary = PasswordDictionary::Open(argv[1]);
+        std::cout << argv[1] << ": " << dictionary->WordCount() << " 个词" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
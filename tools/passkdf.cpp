@@ -0,0 +1,44 @@
+// 测量本机并选择 Argon2id 参数：
+//   passkdf [目标毫秒数] [内存上限 MiB]
+// 默认目标 500 ms、内存上限 256 MiB。输出的 kdf.* 配置行追加到 passmgr.conf 即可生效，
+// 已有用户在下次登录时自动改用新参数：
+//   passkdf 300 64 >> passmgr.conf
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include "KdfProfile.h"
+
+namespace {
+
+unsigned long ParseArg(const char* text, const char* name) {
+    char* end = nullptr;
+    const unsigned long value = std::strtoul(text, &end, 10);
+    if (!*text || *end || value == 0) {
+        throw std::invalid_argument(std::string(name) + " 必须是正整数: " + text);
+    }
+    return value;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc > 3) {
+        std::cerr << "用法: passkdf [目标毫秒数] [内存上限 MiB]" << std::endl;
+        return 2;
+    }
+
+    try {
+        const unsigned long targetMs = argc > 1 ? ParseArg(argv[1], "目标毫秒数") : 500;
+        const unsigned long capMiB = argc > 2 ? ParseArg(argv[2], "内存上限") : 256;
+
+        const KdfProfile profile = KdfProfile::Calibrate(static_cast<unsigned>(targetMs),
+                                                         static_cast<size_t>(capMiB) * 1024 * 1024);
+        std::cout << "# passkdf: 单次派生约 " << targetMs << " ms，内存上限 " << capMiB << " MiB\n"
+                  << profile.ToConfig();
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
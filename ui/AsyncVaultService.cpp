@@ -0,0 +1,615 @@
+#include "AsyncVaultService.h"
+#include "Metrics.h"
+#include <QCoreApplication>
+#include <QFutureWatcher>
+#include <QPromise>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrentRun>
+#include <sodium.h>
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+// 所有服务实例共用的任务线程：查询各自租用连接池的读连接并发执行，
+// 写入交给连接池的写线程，任务线程只等待结果、汇报进度
+QThreadPool* jobPool()
+{
+    static QThreadPool* pool = [] {
+        auto* p = new QThreadPool(QCoreApplication::instance());
+        p->setMaxThreadCount(std::max(2, QThread::idealThreadCount()));
+        return p;
+    }();
+    return pool;
+}
+
+// 把标准异常转换为可跨线程传递的 VaultJobError
+template <typename Fn>
+void guarded(Fn&& fn)
+{
+    try {
+        fn();
+    } catch (const VaultJobError&) {
+        throw;
+    } catch (const std::exception& e) {
+        throw VaultJobError(QString::fromUtf8(e.what()));
+    }
+}
+
+} // namespace
+
+AsyncVaultService::AsyncVaultService(sqlite3* db, UserAuth* auth, QObject* parent)
+    : QObject(parent), pool_(ConnectionPool::ForConnection(db)), auth_(auth)
+{
+}
+
+AsyncVaultService::~AsyncVaultService()
+{
+    // 尚未开始的任务直接跳过；正在运行的任务只持有共享对象，可安全完成
+    cancelAll();
+}
+
+void AsyncVaultService::cancelAll()
+{
+    for (auto* watcher : findChildren<QFutureWatcherBase*>(Qt::FindDirectChildrenOnly)) {
+        watcher->cancel();
+    }
+}
+
+template <typename T>
+QFuture<T> AsyncVaultService::track(QFuture<T> future, std::function<void(const T&)> onResult)
+{
+    auto* watcher = new QFutureWatcher<T>(this);
+    if (runningJobs_++ == 0) {
+        Q_EMIT busyChanged(true);
+    }
+
+    connect(watcher, &QFutureWatcherBase::progressValueChanged, this, [this, watcher](int value) {
+        Q_EMIT progressChanged(value, watcher->progressMaximum());
+    });
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher, onResult] {
+        watcher->deleteLater();
+        if (--runningJobs_ == 0) {
+            Q_EMIT busyChanged(false);
+        }
+
+        if (watcher->isCanceled() || watcher->future().resultCount() == 0) {
+            try {
+                watcher->waitForFinished();
+                Q_EMIT jobCanceled();
+            } catch (const std::exception& e) {
+                Q_EMIT jobFailed(QString::fromUtf8(e.what()));
+            }
+            return;
+        }
+        try {
+            onResult(watcher->result());
+        } catch (const std::exception& e) {
+            Q_EMIT jobFailed(QString::fromUtf8(e.what()));
+        }
+    });
+    watcher->setFuture(future);
+    return future;
+}
+
+QFuture<std::shared_ptr<SessionKeyring>> AsyncVaultService::login(const QString& username, const QString& password)
+{
+    using Result = std::shared_ptr<SessionKeyring>;
+    UserAuth* auth = auth_;
+    const std::string user = username.toStdString();
+    const std::string pass = password.toStdString();
+
+    auto pool = pool_;
+
+    auto future = QtConcurrent::run(jobPool(), [pool, auth, user, pass](QPromise<Result>& promise) {
+        guarded([&] {
+            PASSMGR_SPAN("ui.login");
+            if (!auth) throw std::logic_error("Service has no UserAuth");
+            promise.setProgressRange(0, 2);
+
+            UserAuth::Credentials credentials;
+            const bool found = [&] {
+                auto reader = pool->AcquireReader();
+                return UserAuth::LoadCredentials(reader.Handle(), user, credentials);
+            }();
+
+            // 校验密码与派生会话密钥都是耗时的 Argon2，在任务线程上计算，不占用写线程与写锁
+            UserAuth::LoginResult login;
+            if (!found || !auth->VerifyPassword(credentials, pass, login)) {
+                promise.addResult(Result());
+                return;
+            }
+            promise.setProgressValue(1);
+            if (promise.isCanceled()) return;
+
+            // 每次登录只派生一次会话密钥；派生参数与配置不同时顺带升级
+            auth->DeriveKeys(credentials, pass, login);
+            promise.setProgressValue(2);
+
+            // 写线程只执行重新哈希、保存派生参数与重新包裹数据密钥的语句
+            const bool migrated = pool->Write([&](PasswordVault& vault) {
+                auth->CompleteLogin(user, login);
+                return !vault.HasCodebooksBelowFormat(user, EntryRecord::kVersion);
+            }).get();
+            auto keyring = std::make_shared<SessionKeyring>(login.sessionKey, pass, auth->GetKdfProfile());
+            // 所有密码本都已迁移时不再需要主密码
+            if (migrated) {
+                keyring->DropMasterPassword();
+            }
+            promise.addResult(keyring);
+        });
+    });
+
+    return track<Result>(future, [this, username](const Result& keyring) {
+        Q_EMIT loginFinished(username, keyring);
+    });
+}
+
+QFuture<bool> AsyncVaultService::registerUser(const QString& username, const QString& password)
+{
+    UserAuth* auth = auth_;
+    const std::string user = username.toStdString();
+    const std::string pass = password.toStdString();
+
+    auto pool = pool_;
+
+    auto future = QtConcurrent::run(jobPool(), [pool, auth, user, pass](QPromise<bool>& promise) {
+        guarded([&] {
+            if (!auth) throw std::logic_error("Service has no UserAuth");
+            // SENSITIVE 级哈希需要数秒，在任务线程上计算；写线程只执行插入
+            auth->ValidateRegistration(user, pass);
+            const std::string hash = UserAuth::HashPassword(pass, auth->GetKdfProfile().passwordHash);
+            promise.addResult(pool->Write([&](PasswordVault&) { return auth->CreateUser(user, hash); }).get());
+        });
+    });
+
+    return track<bool>(future, [this](const bool& created) {
+        Q_EMIT registerFinished(created);
+    });
+}
+
+QFuture<PasswordVault::Codebook> AsyncVaultService::createCodebook(const QString& username, const QString& name)
+{
+    using Result = PasswordVault::Codebook;
+    auto pool = pool_;
+    const std::string user = username.toStdString();
+    const std::string codebookName = name.toStdString();
+
+    auto future = QtConcurrent::run(jobPool(), [pool, user, codebookName](QPromise<Result>& promise) {
+        guarded([&] {
+            promise.addResult(pool->Write([&](PasswordVault& vault) { return vault.CreateCodebook(user, codebookName); }).get());
+        });
+    });
+
+    return track<Result>(future, [](const Result&) {});
+}
+
+QFuture<bool> AsyncVaultService::deleteCodebook(std::shared_ptr<SessionKeyring> keyring, int codebookId)
+{
+    auto pool = pool_;
+
+    auto future = QtConcurrent::run(jobPool(), [pool, keyring, codebookId](QPromise<bool>& promise) {
+        guarded([&] {
+            const bool deleted = pool->Write([codebookId](PasswordVault& vault) { return vault.DeleteCodebook(codebookId); }).get();
+            if (deleted) {
+                keyring->ForgetCodebook(codebookId);
+            }
+            promise.addResult(deleted);
+        });
+    });
+
+    return track<bool>(future, [](const bool&) {});
+}
+
+QFuture<std::shared_ptr<SecureKey>> AsyncVaultService::codebookKey(std::shared_ptr<SessionKeyring> keyring, int codebookId)
+{
+    using Result = std::shared_ptr<SecureKey>;
+    auto pool = pool_;
+
+    auto future = QtConcurrent::run(jobPool(), [pool, keyring, codebookId](QPromise<Result>& promise) {
+        guarded([&] {
+            Result key = keyring->CachedCodebookKey(codebookId);
+            if (!key) {
+                key = pool->Read([&](PasswordVault& vault) { return keyring->FindCodebookKey(vault, codebookId); });
+            }
+            if (!key) {
+                // 首次使用：生成并保存数据密钥，可能要排在写线程上正在执行的长任务之后
+                try {
+                    key = pool->Write([&](PasswordVault& vault) { return keyring->GetCodebookKey(vault, codebookId); }).get();
+                } catch (...) {
+                    // 提交失败时密钥环里可能已缓存了未保存的新密钥
+                    keyring->ForgetCodebook(codebookId);
+                    throw;
+                }
+            }
+            promise.addResult(std::move(key));
+        });
+    });
+
+    return track<Result>(future, [](const Result&) {});
+}
+
+QFuture<std::vector<PasswordVault::PasswordEntry>> AsyncVaultService::loadEntries(int codebookId)
+{
+    using Result = std::vector<PasswordVault::PasswordEntry>;
+    auto pool = pool_;
+
+    auto future = QtConcurrent::run(jobPool(), [pool, codebookId](QPromise<Result>& promise) {
+        guarded([&] {
+            PASSMGR_SPAN("ui.load_entries");
+            auto reader = pool->AcquireReader();
+            Result entries;
+            PasswordVault::EntryPage page;
+            do {
+                if (promise.isCanceled()) return;
+                page = reader.Vault().GetEntrySummaries(codebookId, "", page.next_after_id, 500);
+                entries.insert(entries.end(), page.entries.begin(), page.entries.end());
+            } while (page.has_more);
+            promise.addResult(entries);
+        });
+    });
+
+    return track<Result>(future, [this, codebookId](const Result& entries) {
+        Q_EMIT entriesLoaded(codebookId, entries);
+    });
+}
+
+QFuture<bool> AsyncVaultService::addEntry(int codebookId, std::shared_ptr<SecureKey> key,
+                                          const QString& address, const QString& password, const QString& notes)
+{
+    auto pool = pool_;
+    const std::string addr = address.toStdString();
+    const std::string note = notes.toStdString();
+
+    // 明文只在锁定内存中跨线程传递，UTF-8 转换产生的临时副本立即清零
+    QByteArray utf8 = password.toUtf8();
+    auto pass = std::make_shared<SecureBuffer>();
+    pass->resize(static_cast<size_t>(utf8.size()));
+    std::copy(utf8.cbegin(), utf8.cend(), pass->data());
+    sodium_memzero(utf8.data(), static_cast<size_t>(utf8.size()));
+
+    auto future = QtConcurrent::run(jobPool(), [pool, key, codebookId, addr, pass, note](QPromise<bool>& promise) {
+        guarded([&] {
+            if (promise.isCanceled()) return;
+            CryptoModule crypto;
+            std::vector<uint8_t> ciphertext(CryptoModule::sealedSize(pass->size()));
+            if (!crypto.encrypt(*key, pass->data(), pass->size(), ciphertext.data(), ciphertext.size())) {
+                throw std::runtime_error("加密失败");
+            }
+            // 与其他窗口同时提交的写入合并为一次事务
+            promise.addResult(pool->Write([&](PasswordVault& vault) {
+                return vault.AddEntry(codebookId, addr, ciphertext, note);
+            }).get());
+        });
+    });
+
+    return track<bool>(future, [this, codebookId](const bool& added) {
+        if (added) Q_EMIT entryAdded(codebookId);
+    });
+}
+
+QFuture<bool> AsyncVaultService::deleteEntry(int entryId)
+{
+    auto pool = pool_;
+
+    auto future = QtConcurrent::run(jobPool(), [pool, entryId](QPromise<bool>& promise) {
+        guarded([&] {
+            if (promise.isCanceled()) return;
+            promise.addResult(pool->Write([entryId](PasswordVault& vault) { return vault.DeleteEntry(entryId); }).get());
+        });
+    });
+
+    return track<bool>(future, [this, entryId](const bool& deleted) {
+        if (deleted) Q_EMIT entryDeleted(entryId);
+    });
+}
+
+QFuture<std::shared_ptr<SecureBuffer>> AsyncVaultService::decryptEntry(std::shared_ptr<SessionKeyring> keyring,
+                                                                       std::shared_ptr<SecureKey> key, int entryId)
+{
+    using Result = std::shared_ptr<SecureBuffer>;
+    auto pool = pool_;
+
+    auto future = QtConcurrent::run(jobPool(), [pool, keyring, key, entryId](QPromise<Result>& promise) {
+        guarded([&] {
+            // 密文直接从语句结果解密到锁定内存池的槽位，不经过普通堆内存
+            auto plaintext = std::make_shared<SecureBuffer>();
+            bool decrypted = false;
+            const bool found = pool->Read([&](PasswordVault& vault) {
+                return vault.VisitEncryptedPassword(entryId, [&](int, const uint8_t* blob, size_t size) {
+                    decrypted = keyring->Decrypt(*key, blob, size, *plaintext);
+                });
+            });
+            if (!found) {
+                throw std::runtime_error("条目不存在");
+            }
+            if (!decrypted) {
+                throw std::runtime_error("解密失败：密钥不正确或数据已损坏");
+            }
+            if (promise.isCanceled()) return;
+            promise.addResult(std::move(plaintext));
+        });
+    });
+
+    // 明文只通过 QFuture 交给发起方，不经由广播信号
+    return track<Result>(future, [](const Result&) {});
+}
+
+QFuture<int> AsyncVaultService::migrateLegacyEntries(std::shared_ptr<SessionKeyring> keyring,
+                                                     std::shared_ptr<SecureKey> key,
+                                                     const QString& username, int codebookId)
+{
+    const std::string user = username.toStdString();
+    auto pool = pool_;
+
+    auto future = QtConcurrent::run(jobPool(), [pool, keyring, key, user, codebookId](QPromise<int>& promise) {
+        guarded([&] {
+            // 只看记录头筛选：密文原地检查，已是当前版本且 key_id 相符的条目不复制；
+            // 恰好以记录头开头的旧格式条目 key_id 不符，同样会被迁移
+            std::vector<int> ids;
+            std::vector<std::vector<uint8_t>> legacy;
+            {
+                auto reader = pool->AcquireReader();
+                // 已完整迁移过的密码本不再扫描：之后写入的条目都是当前版本
+                if (reader.Vault().GetCodebookFormat(codebookId) >= EntryRecord::kVersion) {
+                    if (!reader.Vault().HasCodebooksBelowFormat(user, EntryRecord::kVersion)) {
+                        keyring->DropMasterPassword();
+                    }
+                    promise.addResult(0);
+                    return;
+                }
+                PasswordVault::BlobPage page;
+                do {
+                    page = reader.Vault().VisitEntryBlobs(codebookId, [&](int entryId, const uint8_t* blob, size_t size) {
+                        if (!CryptoModule::isCurrentFormat(*key, blob, size)) {
+                            ids.push_back(entryId);
+                            legacy.emplace_back(blob, blob + size);
+                        }
+                    }, page.next_after_id);
+                } while (page.has_more);
+            }
+
+            // 无头部的旧格式每条都要跑一次 Argon2，交给批量解密并行处理（版本 2 的记录只需一次 secretbox）；
+            // 汇报进度并响应取消，已完成的部分照常写回
+            promise.setProgressRange(0, static_cast<int>(legacy.size()));
+            BatchDecryptOptions options;
+            options.progress = [&promise](size_t done, size_t) {
+                promise.setProgressValue(static_cast<int>(done));
+                return !promise.isCanceled();
+            };
+            auto plaintexts = keyring->DecryptBatch(*key, legacy, options);
+
+            CryptoModule crypto;
+            std::vector<PasswordVault::RotatedBlob> rewrapped;
+            for (size_t i = 0; i < plaintexts.size(); ++i) {
+                // 无法解密的条目保持原样，不影响其余条目迁移
+                if (!plaintexts[i].ok) continue;
+                rewrapped.push_back({ids[i], std::move(legacy[i]), crypto.encrypt(*key, plaintexts[i].plaintext)});
+                sodium_memzero(plaintexts[i].plaintext.data(), plaintexts[i].plaintext.size());
+            }
+
+            // 迁移期间被用户修改的条目已是新密文，写入时跳过；完整跑完一遍后记下格式版本，
+            // 无法解密的条目之后也不会变得可解，不再重复扫描
+            const bool complete = !promise.isCanceled();
+            bool remaining = true;
+            const size_t migrated = pool->Write([&](PasswordVault& vault) {
+                const size_t written = vault.UpdateEncryptedPasswords(rewrapped);
+                if (complete) {
+                    vault.SetCodebookFormat(codebookId, EntryRecord::kVersion);
+                }
+                remaining = vault.HasCodebooksBelowFormat(user, EntryRecord::kVersion);
+                return written;
+            }).get();
+            // 最后一个密码本迁移完成后清除主密码
+            if (!remaining) {
+                keyring->DropMasterPassword();
+            }
+            promise.addResult(static_cast<int>(migrated));
+        });
+    });
+
+    return track<int>(future, [this, codebookId](const int& migrated) {
+        Q_EMIT migrationFinished(codebookId, migrated);
+    });
+}
+
+QFuture<CsvImportReport> AsyncVaultService::importCsv(int codebookId, std::shared_ptr<SecureKey> key, const QString& path)
+{
+    auto pool = pool_;
+    const std::string file = path.toStdString();
+
+    auto future = QtConcurrent::run(jobPool(), [pool, key, codebookId, file](QPromise<CsvImportReport>& promise) {
+        guarded([&] {
+            // 按已读取字节数汇报进度，换算为千分比避免超出 int 范围
+            promise.setProgressRange(0, 1000);
+            CsvImportOptions options;
+            options.progress = [&promise](uint64_t bytesRead, uint64_t totalBytes) {
+                if (totalBytes > 0) {
+                    promise.setProgressValue(static_cast<int>(std::min<uint64_t>(1000, bytesRead * 1000 / totalBytes)));
+                }
+                return !promise.isCanceled();
+            };
+
+            // 导入自行按批提交，在写线程上单独执行
+            promise.addResult(pool->Exclusive([&](PasswordVault& vault) {
+                CsvImporter importer(vault, key);
+                return importer.ImportFile(codebookId, file, options);
+            }).get());
+        });
+    });
+
+    return track<CsvImportReport>(future, [this, codebookId](const CsvImportReport& report) {
+        Q_EMIT importFinished(codebookId, report);
+    });
+}
+
+QFuture<BackupStats> AsyncVaultService::exportBackup(std::shared_ptr<SessionKeyring> keyring, const QString& username,
+                                                     const QString& path, const QString& passphrase)
+{
+    auto pool = pool_;
+    const std::string user = username.toStdString();
+    const std::string file = path.toStdString();
+    const std::string pass = passphrase.toStdString();
+
+    auto future = QtConcurrent::run(jobPool(), [pool, keyring, user, file, pass](QPromise<BackupStats>& promise) {
+        guarded([&] {
+            promise.setProgressRange(0, 1000);
+            BackupOptions options;
+            options.progress = [&promise](uint64_t done, uint64_t total) {
+                if (total > 0) {
+                    promise.setProgressValue(static_cast<int>(std::min<uint64_t>(1000, done * 1000 / total)));
+                }
+                return !promise.isCanceled();
+            };
+
+            promise.addResult(pool->Exclusive([&](PasswordVault& vault) {
+                VaultBackup backup(vault, keyring);
+                return backup.ExportUser(user, file, pass, options);
+            }).get());
+        });
+    });
+
+    return track<BackupStats>(future, [this](const BackupStats& stats) {
+        Q_EMIT backupExported(stats);
+    });
+}
+
+QFuture<BackupStats> AsyncVaultService::restoreBackup(std::shared_ptr<SessionKeyring> keyring, const QString& username,
+                                                      const QString& path, const QString& passphrase)
+{
+    auto pool = pool_;
+    const std::string user = username.toStdString();
+    const std::string file = path.toStdString();
+    const std::string pass = passphrase.toStdString();
+
+    auto future = QtConcurrent::run(jobPool(), [pool, keyring, user, file, pass](QPromise<BackupStats>& promise) {
+        guarded([&] {
+            promise.setProgressRange(0, 1000);
+            BackupOptions options;
+            options.progress = [&promise](uint64_t done, uint64_t total) {
+                if (total > 0) {
+                    promise.setProgressValue(static_cast<int>(std::min<uint64_t>(1000, done * 1000 / total)));
+                }
+                return !promise.isCanceled();
+            };
+
+            promise.addResult(pool->Exclusive([&](PasswordVault& vault) {
+                VaultBackup backup(vault, keyring);
+                return backup.Restore(user, file, pass, options);
+            }).get());
+        });
+    });
+
+    return track<BackupStats>(future, [this](const BackupStats& stats) {
+        Q_EMIT backupRestored(stats);
+    });
+}
+
+QFuture<StrengthAuditReport> AsyncVaultService::auditStrength(std::shared_ptr<SessionKeyring> keyring, int codebookId)
+{
+    auto pool = pool_;
+
+    auto future = QtConcurrent::run(jobPool(), [pool, keyring, codebookId](QPromise<StrengthAuditReport>& promise) {
+        guarded([&] {
+            promise.setProgressRange(0, 1000);
+            AuditOptions options;
+            options.progress = [&promise](uint64_t done, uint64_t total) {
+                if (total > 0) {
+                    promise.setProgressValue(static_cast<int>(std::min<uint64_t>(1000, done * 1000 / total)));
+                }
+                return !promise.isCanceled();
+            };
+
+            // 强度审计只读取，不占用写线程
+            auto reader = pool->AcquireReader();
+            PasswordAuditor auditor(reader.Vault(), keyring);
+            promise.addResult(auditor.AuditStrength(codebookId, options));
+        });
+    });
+
+    return track<StrengthAuditReport>(future, [this, codebookId](const StrengthAuditReport& report) {
+        Q_EMIT auditFinished(codebookId, report);
+    });
+}
+
+QFuture<ReuseAuditReport> AsyncVaultService::auditReuse(std::shared_ptr<SessionKeyring> keyring, const QString& username)
+{
+    auto pool = pool_;
+    const std::string user = username.toStdString();
+
+    auto future = QtConcurrent::run(jobPool(), [pool, keyring, user](QPromise<ReuseAuditReport>& promise) {
+        guarded([&] {
+            promise.setProgressRange(0, 1000);
+            AuditOptions options;
+            options.progress = [&promise](uint64_t done, uint64_t total) {
+                if (total > 0) {
+                    promise.setProgressValue(static_cast<int>(std::min<uint64_t>(1000, done * 1000 / total)));
+                }
+                return !promise.isCanceled();
+            };
+
+            auto breaches = BreachStore::OpenDefault();
+            // 重复检查会写入审计缓存
+            promise.addResult(pool->Exclusive([&](PasswordVault& vault) {
+                PasswordAuditor auditor(vault, keyring);
+                return auditor.AuditReuse(user, breaches.get(), options);
+            }).get());
+        });
+    });
+
+    return track<ReuseAuditReport>(future, [this](const ReuseAuditReport& report) {
+        Q_EMIT reuseAuditFinished(report);
+    });
+}
+
+QFuture<bool> AsyncVaultService::changeMasterPassword(std::shared_ptr<SessionKeyring> keyring, const QString& username,
+                                                      const QString& oldPassword, const QString& newPassword)
+{
+    auto pool = pool_;
+    const std::string user = username.toStdString();
+    const std::string oldPass = oldPassword.toStdString();
+    const std::string newPass = newPassword.toStdString();
+
+    auto future = QtConcurrent::run(jobPool(), [pool, keyring, user, oldPass, newPass](QPromise<bool>& promise) {
+        guarded([&] {
+            promise.addResult(pool->Exclusive([&](PasswordVault& vault) {
+                KeyRotation rotation(vault, keyring);
+                return rotation.ChangeMasterPassword(user, oldPass, newPass);
+            }).get());
+        });
+    });
+
+    return track<bool>(future, [this](const bool& changed) {
+        Q_EMIT masterPasswordChanged(changed);
+    });
+}
+
+QFuture<RotationReport> AsyncVaultService::resumeKeyRotation(std::shared_ptr<SessionKeyring> keyring, const QString& username)
+{
+    auto pool = pool_;
+    const std::string user = username.toStdString();
+
+    auto future = QtConcurrent::run(jobPool(), [pool, keyring, user](QPromise<RotationReport>& promise) {
+        guarded([&] {
+            promise.setProgressRange(0, 1000);
+            RotationOptions options;
+            options.progress = [&promise](uint64_t done, uint64_t total) {
+                if (total > 0) {
+                    promise.setProgressValue(static_cast<int>(std::min<uint64_t>(1000, done * 1000 / total)));
+                }
+                return !promise.isCanceled();
+            };
+
+            // 每批与检查点各自提交，在写线程上单独执行
+            promise.addResult(pool->Exclusive([&](PasswordVault& vault) {
+                KeyRotation rotation(vault, keyring);
+                return rotation.Resume(user, options);
+            }).get());
+        });
+    });
+
+    return track<RotationReport>(future, [this](const RotationReport& report) {
+        Q_EMIT keyRotationFinished(report);
+    });
+}
@@ -0,0 +1,116 @@
+#pragma once
+#include <QObject>
+#include <QFuture>
+#include <QException>
+#include <QString>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "PassWordVault.h"
+#include "ConnectionPool.h"
+#include "CsvImporter.h"
+#include "VaultBackup.h"
+#include "PasswordAudit.h"
+#include "KeyRotation.h"
+#include "SessionKeyring.h"
+#include "UserAuth.h"
+
+// 后台任务失败时随 QFuture 传递的异常
+class VaultJobError : public QException {
+public:
+    explicit VaultJobError(const QString& message) : message_(message.toUtf8()) {}
+    void raise() const override { throw *this; }
+    VaultJobError* clone() const override { return new VaultJobError(*this); }
+    const char* what() const noexcept override { return message_.constData(); }
+
+private:
+    QByteArray message_;
+};
+
+// UserAuth / PasswordVault / CryptoModule 的异步门面：
+// 查询在任务线程上租用连接池的只读连接并发执行；写入排入连接池的写线程，
+// 短小的写入与其他窗口同时提交的写入成组提交，自行分批提交的长任务在写线程上单独执行；
+// 结果既通过 QFuture 返回，也通过信号发回界面线程。
+class AsyncVaultService : public QObject {
+    Q_OBJECT
+public:
+    explicit AsyncVaultService(sqlite3* db, UserAuth* auth = nullptr, QObject* parent = nullptr);
+    ~AsyncVaultService() override;
+
+    // 登录成功返回会话密钥环，用户名或密码错误时返回空指针
+    QFuture<std::shared_ptr<SessionKeyring>> login(const QString& username, const QString& password);
+    QFuture<bool> registerUser(const QString& username, const QString& password);
+
+    // 同名密码本已存在时返回的 id 为 -1
+    QFuture<PasswordVault::Codebook> createCodebook(const QString& username, const QString& name);
+    // 删除成功后同时丢弃密钥环中缓存的数据密钥；已在其他窗口中删除时返回 false
+    QFuture<bool> deleteCodebook(std::shared_ptr<SessionKeyring> keyring, int codebookId);
+    // 取得密码本的数据密钥：已缓存时直接返回，已保存时在读连接上解包，尚未生成时才交给写线程生成并保存
+    QFuture<std::shared_ptr<SecureKey>> codebookKey(std::shared_ptr<SessionKeyring> keyring, int codebookId);
+
+    QFuture<std::vector<PasswordVault::PasswordEntry>> loadEntries(int codebookId);
+    QFuture<bool> addEntry(int codebookId, std::shared_ptr<SecureKey> key,
+                           const QString& address, const QString& password, const QString& notes);
+    QFuture<bool> deleteEntry(int entryId);
+    // 明文留在锁定内存池中，结果释放时清零
+    QFuture<std::shared_ptr<SecureBuffer>> decryptEntry(std::shared_ptr<SessionKeyring> keyring,
+                                                        std::shared_ptr<SecureKey> key, int entryId);
+    // 将旧格式与版本 2 的条目重新加密为当前的 EntryRecord 版本，返回迁移条数；
+    // 用户的密码本全部迁移后，密钥环清除保存的主密码
+    QFuture<int> migrateLegacyEntries(std::shared_ptr<SessionKeyring> keyring,
+                                      std::shared_ptr<SecureKey> key,
+                                      const QString& username, int codebookId);
+
+    // 流式导入 CSV，按批提交；取消时已提交的批次保留
+    QFuture<CsvImportReport> importCsv(int codebookId, std::shared_ptr<SecureKey> key, const QString& path);
+
+    // 将用户全部密码本导出为口令加密的流式备份，或从备份恢复
+    QFuture<BackupStats> exportBackup(std::shared_ptr<SessionKeyring> keyring, const QString& username,
+                                      const QString& path, const QString& passphrase);
+    QFuture<BackupStats> restoreBackup(std::shared_ptr<SessionKeyring> keyring, const QString& username,
+                                       const QString& path, const QString& passphrase);
+
+    // 逐页解密并估计密码本中每个密码的强度，返回弱密码列表
+    QFuture<StrengthAuditReport> auditStrength(std::shared_ptr<SessionKeyring> keyring, int codebookId);
+    // 检查用户所有密码本中的重复密码；工作目录下有 passmgr.breach 时同时检查已泄露的密码
+    QFuture<ReuseAuditReport> auditReuse(std::shared_ptr<SessionKeyring> keyring, const QString& username);
+
+    // 修改主密码：旧主密码错误时返回 false；成功后需要调用 resumeKeyRotation 重新加密条目
+    QFuture<bool> changeMasterPassword(std::shared_ptr<SessionKeyring> keyring, const QString& username,
+                                       const QString& oldPassword, const QString& newPassword);
+    // 从检查点继续重新加密；取消后已提交的批次保留，下次从检查点继续
+    QFuture<RotationReport> resumeKeyRotation(std::shared_ptr<SessionKeyring> keyring, const QString& username);
+
+    bool isBusy() const { return runningJobs_ > 0; }
+
+public Q_SLOTS:
+    void cancelAll();
+
+Q_SIGNALS:
+    void loginFinished(const QString& username, std::shared_ptr<SessionKeyring> keyring);
+    void registerFinished(bool created);
+    void entriesLoaded(int codebookId, const std::vector<PasswordVault::PasswordEntry>& entries);
+    void entryAdded(int codebookId);
+    void entryDeleted(int entryId);
+    void migrationFinished(int codebookId, int migrated);
+    void importFinished(int codebookId, const CsvImportReport& report);
+    void backupExported(const BackupStats& stats);
+    void backupRestored(const BackupStats& stats);
+    void auditFinished(int codebookId, const StrengthAuditReport& report);
+    void reuseAuditFinished(const ReuseAuditReport& report);
+    void masterPasswordChanged(bool changed);
+    void keyRotationFinished(const RotationReport& report);
+
+    void progressChanged(int value, int maximum);
+    void busyChanged(bool busy);
+    void jobCanceled();
+    void jobFailed(const QString& message);
+
+private:
+    template <typename T>
+    QFuture<T> track(QFuture<T> future, std::function<void(const T&)> onResult);
+
+    std::shared_ptr<ConnectionPool> pool_;
+    UserAuth* auth_;
+    int runningJobs_ = 0;
+};
@@ -0,0 +1,138 @@
+#include "DiagnosticsDialog.h"
+#include "ConnectionPool.h"
+#include "Metrics.h"
+#include "SecureArena.h"
+#include <QFileDialog>
+#include <QFontDatabase>
+#include <QHBoxLayout>
+#include <QMessageBox>
+#include <QPushButton>
+#include <QVBoxLayout>
+
+namespace {
+
+QString formatNanos(uint64_t nanos)
+{
+    if (nanos >= 1000000000ull) return QString::number(nanos / 1e9, 'f', 2) + " s";
+    if (nanos >= 1000000ull) return QString::number(nanos / 1e6, 'f', 2) + " ms";
+    if (nanos >= 1000ull) return QString::number(nanos / 1e3, 'f', 1) + " µs";
+    return QString::number(nanos) + " ns";
+}
+
+} // namespace
+
+DiagnosticsDialog::DiagnosticsDialog(sqlite3* db, QWidget* parent)
+    : QDialog(parent), db_(db)
+{
+    setWindowTitle("诊断");
+    setMinimumSize(720, 480);
+    setAttribute(Qt::WA_DeleteOnClose);
+
+    format_ = new QComboBox(this);
+    format_->addItems({"汇总", "Prometheus", "JSON"});
+
+    output_ = new QPlainTextEdit(this);
+    output_->setReadOnly(true);
+    output_->setLineWrapMode(QPlainTextEdit::NoWrap);
+    output_->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+
+    QPushButton* refreshBtn = new QPushButton("刷新", this);
+    QPushButton* resetBtn = new QPushButton("清零", this);
+    QPushButton* exportBtn = new QPushButton("导出...", this);
+
+    connect(format_, &QComboBox::currentIndexChanged, this, &DiagnosticsDialog::refresh);
+    connect(refreshBtn, &QPushButton::clicked, this, &DiagnosticsDialog::refresh);
+    connect(resetBtn, &QPushButton::clicked, this, &DiagnosticsDialog::resetMetrics);
+    connect(exportBtn, &QPushButton::clicked, this, &DiagnosticsDialog::exportMetrics);
+
+    QHBoxLayout* btnLayout = new QHBoxLayout();
+    btnLayout->addWidget(format_);
+    btnLayout->addStretch();
+    btnLayout->addWidget(refreshBtn);
+    btnLayout->addWidget(resetBtn);
+    btnLayout->addWidget(exportBtn);
+
+    QVBoxLayout* mainLayout = new QVBoxLayout(this);
+    mainLayout->addWidget(output_);
+    mainLayout->addLayout(btnLayout);
+
+    refresh();
+}
+
+void DiagnosticsDialog::refresh()
+{
+    switch (format_->currentIndex()) {
+    case 1:
+        output_->setPlainText(QString::fromStdString(Metrics::ToPrometheus(Metrics::Snapshot())));
+        break;
+    case 2:
+        output_->setPlainText(QString::fromStdString(Metrics::ToJson(Metrics::Snapshot())));
+        break;
+    default:
+        output_->setPlainText(summaryText());
+        break;
+    }
+}
+
+void DiagnosticsDialog::resetMetrics()
+{
+    Metrics::Reset();
+    refresh();
+}
+
+void DiagnosticsDialog::exportMetrics()
+{
+    const QString path = QFileDialog::getSaveFileName(this, "导出指标", "passmgr-metrics.prom",
+                                                      "Prometheus 文本 (*.prom *.txt);;JSON (*.json)");
+    if (path.isEmpty()) return;
+    try {
+        Metrics::WriteFile(path.toStdString());
+    } catch (const std::exception& e) {
+        QMessageBox::critical(this, "导出失败", e.what());
+    }
+}
+
+QString DiagnosticsDialog::summaryText() const
+{
+    QString text;
+    if (!Metrics::Enabled()) {
+        text += "本程序构建时未启用 PASSMGR_ENABLE_METRICS，没有插桩数据。\n\n";
+    }
+
+    text += QString("%1 %2 %3 %4 %5 %6\n")
+                .arg("跨度", -28).arg("次数", 10).arg("p50", 12).arg("p99", 12).arg("最长", 12).arg("合计", 12);
+    QString counters;
+    for (const auto& series : Metrics::Snapshot()) {
+        const QString name = QString::fromStdString(series.name);
+        if (series.kind == Metrics::Kind::Counter) {
+            counters += QString("%1 %2\n").arg(name, -28).arg(series.sum, 10);
+            continue;
+        }
+        text += QString("%1 %2 %3 %4 %5 %6\n")
+                    .arg(name, -28)
+                    .arg(series.count, 10)
+                    .arg(formatNanos(series.Quantile(0.5)), 12)
+                    .arg(formatNanos(series.Quantile(0.99)), 12)
+                    .arg(formatNanos(series.max), 12)
+                    .arg(formatNanos(series.sum), 12);
+    }
+    if (!counters.isEmpty()) {
+        text += "\n计数器\n" + counters;
+    }
+
+    // 连接池与锁定内存池的统计不依赖插桩，总是可用
+    const ConnectionPool::Stats pool = ConnectionPool::ForConnection(db_)->GetStats();
+    text += QString("\n连接池：读连接 %1/%2，查询 %3 次（等待 %4 次），成组写入 %5 次共 %6 次提交（最大一组 %7），"
+                    "独占任务 %8 个，写队列峰值 %9\n")
+                .arg(pool.readers).arg(ConnectionPool::ForConnection(db_)->MaxReaders())
+                .arg(pool.reads).arg(pool.readWaits)
+                .arg(pool.groupedWrites).arg(pool.groupCommits).arg(pool.largestGroup)
+                .arg(pool.exclusiveJobs).arg(pool.peakQueueDepth);
+
+    const SecureArena::Stats arena = SecureArena::Global().GetStats();
+    text += QString("锁定内存：持有 %1 个槽位（峰值 %2），%3 个 chunk 共 %4 KiB，累计 sodium_malloc %5 次\n")
+                .arg(arena.liveSlots).arg(arena.peakLiveSlots)
+                .arg(arena.chunks).arg(arena.reservedBytes / 1024)
+                .arg(arena.chunkAllocations);
+    return text;
+}
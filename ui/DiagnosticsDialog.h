@@ -0,0 +1,26 @@
+#pragma once
+#include <QDialog>
+#include <QPlainTextEdit>
+#include <QComboBox>
+#include <sqlite3.h>
+
+// 隐藏的诊断窗口（主窗口中按 Ctrl+Shift+D 打开）：显示插桩指标的汇总、连接池与锁定内存池的统计，
+// 并可把指标导出为 JSON 或 Prometheus 文本文件
+class DiagnosticsDialog : public QDialog
+{
+    Q_OBJECT
+public:
+    explicit DiagnosticsDialog(sqlite3* db, QWidget* parent = nullptr);
+
+private Q_SLOTS:
+    void refresh();
+    void resetMetrics();
+    void exportMetrics();
+
+private:
+    QString summaryText() const;
+
+    sqlite3* db_;
+    QComboBox* format_;
+    QPlainTextEdit* output_;
+};
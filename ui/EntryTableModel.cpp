@@ -0,0 +1,225 @@
+#include "EntryTableModel.h"
+#include "Metrics.h"
+#include <algorithm>
+
+EntryTableModel::EntryTableModel(sqlite3* db, int codebookId, QObject* parent)
+    : QAbstractTableModel(parent), pool_(ConnectionPool::ForConnection(db)), codebookId_(codebookId), changes_(ChangeBus::ForConnection(db))
+{
+    // 回调可能在后台任务线程上执行，只投递到界面线程
+    subscription_ = changes_->Subscribe([this](int64_t) {
+        if (refreshQueued_.exchange(true)) return;
+        QMetaObject::invokeMethod(this, [this] {
+            refreshQueued_ = false;
+            applyChanges();
+        }, Qt::QueuedConnection);
+    });
+}
+
+EntryTableModel::~EntryTableModel()
+{
+    changes_->Unsubscribe(subscription_);
+}
+
+int EntryTableModel::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : static_cast<int>(rows_.size());
+}
+
+int EntryTableModel::columnCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant EntryTableModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid() || index.row() >= rows_.size()) return QVariant();
+    const Row& row = rows_[index.row()];
+
+    if (role == EntryIdRole) return row.id;
+
+    if (role == Qt::ToolTipRole && index.column() == PasswordColumn) {
+        return "双击显示密码（3秒后自动隐藏）";
+    }
+
+    if (role != Qt::DisplayRole) return QVariant();
+    switch (index.column()) {
+    case AddressColumn: return row.address;
+    case CreatedColumn: return row.createdTime;
+    case PasswordColumn: return revealed_.value(row.id, "******");
+    case NotesColumn: return row.notes;
+    }
+    return QVariant();
+}
+
+QVariant EntryTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+        return QAbstractTableModel::headerData(section, orientation, role);
+    }
+    switch (section) {
+    case AddressColumn: return "地址";
+    case CreatedColumn: return "创建时间";
+    case PasswordColumn: return "密码";
+    case NotesColumn: return "备注";
+    }
+    return QVariant();
+}
+
+Qt::ItemFlags EntryTableModel::flags(const QModelIndex& index) const
+{
+    if (!index.isValid()) return Qt::NoItemFlags;
+    return Qt::ItemIsEnabled | Qt::ItemIsSelectable;
+}
+
+bool EntryTableModel::canFetchMore(const QModelIndex& parent) const
+{
+    return !parent.isValid() && hasMore_;
+}
+
+void EntryTableModel::fetchMore(const QModelIndex& parent)
+{
+    if (parent.isValid() || !hasMore_) return;
+    PASSMGR_SPAN("ui.entries.fetch_page");
+    appendPage(pool_->Read([this](PasswordVault& vault) {
+        return vault.GetEntrySummaries(codebookId_, std::string(), lastEntryId_, kPageSize);
+    }));
+}
+
+void EntryTableModel::reload(const QString& query)
+{
+    PASSMGR_SPAN("ui.entries.reload");
+    // 先记下序号再加载：加载期间提交的变更会在下次 applyChanges 时重复应用，但不会遗漏
+    seq_ = pool_->Read([](PasswordVault& vault) { return vault.CurrentSeq(); });
+    beginResetModel();
+    query_ = query.trimmed().toStdString();
+    rows_.clear();
+    revealed_.clear();
+    lastEntryId_ = 0;
+    hasMore_ = query_.empty();
+    endResetModel();
+
+    if (query_.empty()) {
+        fetchMore(QModelIndex());
+        return;
+    }
+
+    PasswordVault::EntryPage results;
+    results.entries = pool_->Read([this](PasswordVault& vault) { return vault.Search(codebookId_, query_, kSearchLimit); });
+    appendPage(results);
+}
+
+void EntryTableModel::applyChanges()
+{
+    PASSMGR_SPAN("ui.entries.apply_changes");
+    const PasswordVault::ChangeSet changes =
+        pool_->Read([this](PasswordVault& vault) { return vault.GetChangesSince(codebookId_, seq_); });
+    if (!changes.complete) {
+        reload(QString::fromStdString(query_));
+        return;
+    }
+    seq_ = changes.seq;
+
+    for (int entryId : changes.deleted) {
+        removeEntry(entryId);
+    }
+    for (const auto& entry : changes.changed) {
+        upsertEntry(entry);
+    }
+}
+
+void EntryTableModel::removeEntry(int entryId)
+{
+    const int row = rowForEntry(entryId);
+    if (row < 0) return;
+
+    beginRemoveRows(QModelIndex(), row, row);
+    rows_.remove(row);
+    revealed_.remove(entryId);
+    endRemoveRows();
+}
+
+void EntryTableModel::upsertEntry(const PasswordVault::PasswordEntry& entry)
+{
+    Row updated{entry.id,
+                QString::fromStdString(entry.address),
+                QString::fromStdString(entry.created_time),
+                QString::fromStdString(entry.notes)};
+
+    const int row = rowForEntry(entry.id);
+    if (row >= 0) {
+        // 密码可能已被修改，收回已显示的明文
+        rows_[row] = std::move(updated);
+        revealed_.remove(entry.id);
+        Q_EMIT dataChanged(index(row, 0), index(row, ColumnCount - 1));
+        return;
+    }
+
+    // 搜索结果按相关度排列，新条目要等下次搜索才出现；
+    // 浏览时尚未加载到的条目留给后续分页
+    if (!query_.empty() || (hasMore_ && entry.id > lastEntryId_)) return;
+
+    auto it = std::lower_bound(rows_.begin(), rows_.end(), entry.id,
+                               [](const Row& row, int id) { return row.id < id; });
+    const int position = static_cast<int>(it - rows_.begin());
+    beginInsertRows(QModelIndex(), position, position);
+    rows_.insert(position, std::move(updated));
+    lastEntryId_ = std::max(lastEntryId_, entry.id);
+    endInsertRows();
+}
+
+int EntryTableModel::entryIdAt(int row) const
+{
+    return row >= 0 && row < rows_.size() ? rows_[row].id : -1;
+}
+
+int EntryTableModel::rowForEntry(int entryId) const
+{
+    if (!query_.empty()) {
+        auto it = std::find_if(rows_.begin(), rows_.end(),
+                               [entryId](const Row& row) { return row.id == entryId; });
+        return it == rows_.end() ? -1 : static_cast<int>(it - rows_.begin());
+    }
+
+    // 浏览时行按 entry_id 递增排列
+    auto it = std::lower_bound(rows_.begin(), rows_.end(), entryId,
+                               [](const Row& row, int id) { return row.id < id; });
+    if (it == rows_.end() || it->id != entryId) return -1;
+    return static_cast<int>(it - rows_.begin());
+}
+
+void EntryTableModel::revealPassword(int entryId, const QString& password)
+{
+    const int row = rowForEntry(entryId);
+    if (row < 0) return;
+
+    revealed_.insert(entryId, password);
+    const QModelIndex cell = index(row, PasswordColumn);
+    Q_EMIT dataChanged(cell, cell, {Qt::DisplayRole});
+}
+
+void EntryTableModel::concealPassword(int entryId)
+{
+    if (revealed_.remove(entryId) == 0) return;
+
+    const int row = rowForEntry(entryId);
+    if (row < 0) return;
+    const QModelIndex cell = index(row, PasswordColumn);
+    Q_EMIT dataChanged(cell, cell, {Qt::DisplayRole});
+}
+
+void EntryTableModel::appendPage(const PasswordVault::EntryPage& page)
+{
+    hasMore_ = page.has_more;
+    if (page.entries.empty()) return;
+
+    const int first = static_cast<int>(rows_.size());
+    beginInsertRows(QModelIndex(), first, first + static_cast<int>(page.entries.size()) - 1);
+    for (const auto& entry : page.entries) {
+        rows_.append(Row{entry.id,
+                         QString::fromStdString(entry.address),
+                         QString::fromStdString(entry.created_time),
+                         QString::fromStdString(entry.notes)});
+    }
+    lastEntryId_ = page.next_after_id;
+    endInsertRows();
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <QAbstractTableModel>
+#include <QHash>
+#include <QString>
+#include <QVector>
+#include <atomic>
+#include <memory>
+#include "ChangeBus.h"
+#include "ConnectionPool.h"
+#include "PassWordVault.h"
+
+// 密码条目表格模型：按 entry_id 键集分页，从数据库分批取行；
+// 订阅连接的 ChangeBus，任何窗口写入后只取回自上次以来的差量，
+// 发出对应行的 rowsInserted / rowsRemoved / dataChanged，不重新加载整个表。
+// 设置了搜索词时改为一次性加载全文搜索结果（按相关度排列，不再分页）。
+class EntryTableModel : public QAbstractTableModel {
+    Q_OBJECT
+public:
+    enum Column { AddressColumn, CreatedColumn, PasswordColumn, NotesColumn, ColumnCount };
+    static const int EntryIdRole = Qt::UserRole;
+
+    EntryTableModel(sqlite3* db, int codebookId, QObject* parent = nullptr);
+    ~EntryTableModel() override;
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    Qt::ItemFlags flags(const QModelIndex& index) const override;
+
+    bool canFetchMore(const QModelIndex& parent) const override;
+    void fetchMore(const QModelIndex& parent) override;
+
+    // 重新从第一页开始加载；query 非空时显示全文搜索结果
+    void reload(const QString& query = QString());
+    // 应用自上次以来的变更；未加载完时新条目会随后续分页自然出现，
+    // 搜索结果只更新和移除已显示的行
+    void applyChanges();
+
+    int entryIdAt(int row) const;
+    int rowForEntry(int entryId) const;
+
+    // 明文只保存在被查看的行上，隐藏时立即移除
+    void revealPassword(int entryId, const QString& password);
+    void concealPassword(int entryId);
+
+private:
+    struct Row {
+        int id;
+        QString address;
+        QString createdTime;
+        QString notes;
+    };
+
+    void appendPage(const PasswordVault::EntryPage& page);
+    void removeEntry(int entryId);
+    void upsertEntry(const PasswordVault::PasswordEntry& entry);
+
+    static const int kPageSize = 200;
+    static const int kSearchLimit = 200;
+
+    std::shared_ptr<ConnectionPool> pool_;   // 查询租用只读连接，看到的总是已提交的数据
+    const int codebookId_;
+    std::string query_;
+    QVector<Row> rows_;
+    QHash<int, QString> revealed_;
+    int lastEntryId_ = 0;
+    bool hasMore_ = true;
+
+    std::shared_ptr<ChangeBus> changes_;
+    int subscription_ = 0;
+    int64_t seq_ = 0;
+    // 写入线程上连续发布的通知合并为一次界面线程上的 applyChanges
+    std::atomic<bool> refreshQueued_{false};
+};
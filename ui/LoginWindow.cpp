@@ -5,7 +5,9 @@
 #include <QLabel>
 #include <QMessageBox>
 
-LoginWindow::LoginWindow(QWidget *parent) : QWidget(parent)
+LoginWindow::LoginWindow(const ConnectionProfile& profile, const KdfProfile& kdf, QWidget *parent)
+    : QWidget(parent), userAuth("UserAuth.db", profile, kdf),
+      service(userAuth.GetDatabaseHandle(), &userAuth, this)
 {
     setWindowTitle("密码管家 - 登录");
     setFixedSize(400, 300);
@@ -29,12 +31,40 @@ void LoginWindow::setupUI()
     passwordInput->setEchoMode(QLineEdit::Password);
     passwordInput->setMaxLength(32);
 
-    QPushButton *loginBtn = new QPushButton("登录", this);
-    QPushButton *registerBtn = new QPushButton("注册", this);
+    loginBtn = new QPushButton("登录", this);
+    registerBtn = new QPushButton("注册", this);
+
+    statusLabel = new QLabel(this);
+    statusLabel->setAlignment(Qt::AlignCenter);
 
     connect(loginBtn, &QPushButton::clicked, this, &LoginWindow::handleLogin);
     connect(registerBtn, &QPushButton::clicked, this, &LoginWindow::handleRegister);
 
+    // 密钥派生耗时数秒，在后台完成后再回到界面线程
+    connect(&service, &AsyncVaultService::busyChanged, this, [this](bool busy) {
+        loginBtn->setEnabled(!busy);
+        registerBtn->setEnabled(!busy);
+        if (!busy) statusLabel->clear();
+    });
+    connect(&service, &AsyncVaultService::loginFinished, this,
+            [this](const QString &username, std::shared_ptr<SessionKeyring> keyring) {
+        if (keyring) {
+            showMainWindow(username, keyring);
+        } else {
+            QMessageBox::warning(this, "登录失败", "用户名或密码错误");
+        }
+    });
+    connect(&service, &AsyncVaultService::registerFinished, this, [this](bool created) {
+        if (created) {
+            QMessageBox::information(this, "注册成功", "请使用新账号登录");
+        } else {
+            QMessageBox::warning(this, "注册失败", "用户名已存在");
+        }
+    });
+    connect(&service, &AsyncVaultService::jobFailed, this, [this](const QString &message) {
+        QMessageBox::critical(this, "错误", message);
+    });
+
     QHBoxLayout *btnLayout = new QHBoxLayout();
     btnLayout->addWidget(loginBtn);
     btnLayout->addWidget(registerBtn);
@@ -43,6 +73,7 @@ void LoginWindow::setupUI()
     mainLayout->addWidget(usernameInput);
     mainLayout->addWidget(passwordInput);
     mainLayout->addLayout(btnLayout);
+    mainLayout->addWidget(statusLabel);
 }
 
 void LoginWindow::handleLogin()
@@ -50,12 +81,9 @@ void LoginWindow::handleLogin()
     QString username = usernameInput->text();
     QString password = passwordInput->text();
 
-    std::vector<UserAuth::CodebookInfo> codebooks;
-    if (userAuth.Login(username.toStdString(), password.toStdString(), codebooks)) {
-        showMainWindow(username);
-    } else {
-        QMessageBox::warning(this, "登录失败", "用户名或密码错误");
-    }
+    // 每次登录只派生一次会话密钥，条目加解密只使用缓存的数据密钥
+    statusLabel->setText("正在验证...");
+    service.login(username, password);
 }
 
 void LoginWindow::handleRegister()
@@ -63,22 +91,15 @@ void LoginWindow::handleRegister()
     QString username = usernameInput->text();
     QString password = passwordInput->text();
 
-    try {
-        if (userAuth.Register(username.toStdString(), password.toStdString())) {
-            QMessageBox::information(this, "注册成功", "请使用新账号登录");
-        } else {
-            QMessageBox::warning(this, "注册失败", "用户名已存在");
-        }
-    } catch (const std::exception &e) {
-        QMessageBox::critical(this, "错误", QString("注册失败: ") + e.what());
-    }
+    statusLabel->setText("正在注册...");
+    service.registerUser(username, password);
 }
 
-void LoginWindow::showMainWindow(const QString &username)
+void LoginWindow::showMainWindow(const QString &username, std::shared_ptr<SessionKeyring> keyring)
 {
     sqlite3 *db = userAuth.GetDatabaseHandle();
     if (db) {
-        MainWindow *mainWin = new MainWindow(db, username.toStdString(), this->cachedMasterPassword);
+        MainWindow *mainWin = new MainWindow(db, username.toStdString(), keyring);
         mainWin->show();
         this->close();
     } else {
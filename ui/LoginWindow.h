@@ -2,14 +2,19 @@
 #include <QWidget>
 #include <QLineEdit>
 #include <QPushButton>
+#include <QLabel>
+#include <memory>
 #include "UserAuth.h"
+#include "SessionKeyring.h"
+#include "AsyncVaultService.h"
 
 class LoginWindow : public QWidget
 {
     Q_OBJECT
 public:
-    explicit LoginWindow(QWidget *parent = nullptr);
-    std::string GetMasterPassword() const {return cachedMasterPassword;}
+    explicit LoginWindow(const ConnectionProfile& profile = ConnectionProfile::Default(),
+                         const KdfProfile& kdf = KdfProfile::Default(),
+                         QWidget *parent = nullptr);
 
 private Q_SLOTS:
     void handleLogin();
@@ -18,9 +23,12 @@ private Q_SLOTS:
 private:
     QLineEdit *usernameInput;
     QLineEdit *passwordInput;
+    QPushButton *loginBtn;
+    QPushButton *registerBtn;
+    QLabel *statusLabel;
     UserAuth userAuth;
-    std::string cachedMasterPassword;
+    AsyncVaultService service;
 
     void setupUI();
-    void showMainWindow(const QString &username);
+    void showMainWindow(const QString &username, std::shared_ptr<SessionKeyring> keyring);
 };
\ No newline at end of file
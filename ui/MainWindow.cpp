@@ -1,19 +1,37 @@
 #include "MainWindow.h"
 #include "PasswordManagerWindow.h"
+#include "PasswordStrength.h"
+#include "DiagnosticsDialog.h"
+#include "Metrics.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QInputDialog>
 #include <QMessageBox>
 #include <QPushButton>
 #include <QListWidgetItem>
+#include <QLocale>
+#include <QFileDialog>
+#include <QShortcut>
+#include <QStringList>
+#include <algorithm>
+#include <map>
 
-MainWindow::MainWindow(sqlite3* db, const std::string &username, const std::string &masterPassword,  QWidget *parent)
-    : db_(db), QWidget(parent), vault(db), user(username), masterPassword_(masterPassword)
+MainWindow::MainWindow(sqlite3* db, const std::string &username, std::shared_ptr<SessionKeyring> keyring,  QWidget *parent)
+    : db_(db), QWidget(parent), keyring_(keyring), user(username)
 {
     setWindowTitle("密码本管理 - " + QString::fromStdString(username));
     setMinimumSize(600, 400);
+    service_ = new AsyncVaultService(db, nullptr, this);
     setupUI();
     loadCodebooks();
+
+    // 上次修改主密码后的重新加密被中断时，从检查点继续
+    const bool interrupted = ConnectionPool::ForConnection(db_)->Read([this](PasswordVault& v) {
+        return !v.GetRotationCheckpoints(user).empty();
+    });
+    if (interrupted) {
+        service_->resumeKeyRotation(keyring_, QString::fromStdString(user));
+    }
 }
 
 void MainWindow::setupUI()
@@ -27,37 +45,105 @@ void MainWindow::setupUI()
     QPushButton *addBtn = new QPushButton("创建新的密码本", this);
     QPushButton *deleteBtn = new QPushButton("删除密码本", this);
     QPushButton *openBtn = new QPushButton("打开密码本", this);
+    QPushButton *exportBtn = new QPushButton("导出备份", this);
+    QPushButton *restoreBtn = new QPushButton("恢复备份", this);
+    QPushButton *auditBtn = new QPushButton("重复密码检查", this);
+    QPushButton *passwordBtn = new QPushButton("修改主密码", this);
 
     connect(addBtn, &QPushButton::clicked, this, &MainWindow::addCodebook);
     connect(deleteBtn, &QPushButton::clicked, this, &MainWindow::deleteCodebook);
     connect(openBtn, &QPushButton::clicked, this, &MainWindow::openCodebook);
+    connect(exportBtn, &QPushButton::clicked, this, &MainWindow::exportBackup);
+    connect(restoreBtn, &QPushButton::clicked, this, &MainWindow::restoreBackup);
+    connect(auditBtn, &QPushButton::clicked, this, &MainWindow::auditReuse);
+    connect(passwordBtn, &QPushButton::clicked, this, &MainWindow::changeMasterPassword);
+
+    // 备份与检查任务在后台运行，按钮在任务期间禁用
+    connect(service_, &AsyncVaultService::busyChanged, this, [exportBtn, restoreBtn, auditBtn, passwordBtn](bool busy) {
+        exportBtn->setEnabled(!busy);
+        restoreBtn->setEnabled(!busy);
+        auditBtn->setEnabled(!busy);
+        passwordBtn->setEnabled(!busy);
+    });
+    connect(service_, &AsyncVaultService::jobFailed, this, [this](const QString& message) {
+        QMessageBox::critical(this, "操作失败", message);
+    });
+    connect(service_, &AsyncVaultService::reuseAuditFinished, this, &MainWindow::showReuseReport);
+    connect(service_, &AsyncVaultService::masterPasswordChanged, this, [this](bool changed) {
+        if (!changed) {
+            QMessageBox::warning(this, "修改主密码", "当前主密码不正确");
+            return;
+        }
+        // 新主密码已生效，条目在后台逐批改用新的数据密钥
+        service_->resumeKeyRotation(keyring_, QString::fromStdString(user));
+    });
+    connect(service_, &AsyncVaultService::keyRotationFinished, this, [this](const RotationReport& report) {
+        if (!report.finished) return;
+        QString message = QString("主密码已修改，%1 条条目已重新加密").arg(report.reencrypted);
+        if (report.undecryptable > 0) {
+            message += QString("\n%1 条条目无法解密，保持原样").arg(report.undecryptable);
+        }
+        QMessageBox::information(this, "修改主密码", message);
+    });
+    connect(service_, &AsyncVaultService::backupExported, this, [this](const BackupStats& stats) {
+        if (stats.canceled) return;
+        QString message = QString("已导出 %1 个密码本、%2 条条目").arg(stats.codebooks).arg(stats.entries);
+        if (stats.skipped > 0) {
+            message += QString("\n%1 条条目无法解密，未导出").arg(stats.skipped);
+        }
+        QMessageBox::information(this, "导出完成", message);
+    });
+    connect(service_, &AsyncVaultService::backupRestored, this, [this](const BackupStats& stats) {
+        loadCodebooks();
+        if (stats.canceled) return;
+        QMessageBox::information(this, "恢复完成",
+            QString("已恢复 %1 个密码本、%2 条条目").arg(stats.codebooks).arg(stats.entries - stats.skipped));
+    });
 
     btnLayout->addWidget(addBtn);
     btnLayout->addWidget(deleteBtn);
     btnLayout->addWidget(openBtn);
+    btnLayout->addWidget(exportBtn);
+    btnLayout->addWidget(restoreBtn);
+    btnLayout->addWidget(auditBtn);
+    btnLayout->addWidget(passwordBtn);
 
     mainLayout->addWidget(codebookList);
     mainLayout->addLayout(btnLayout);
-}
 
-QString MainWindow::getOriginalName(const QString& displayText) 
-{
-    // 通过第一个换行符分割字符串
-    int splitIndex = displayText.indexOf('\n');
-    return splitIndex == -1 ? displayText : displayText.left(splitIndex).trimmed();
+    // 不在界面上露出的诊断窗口
+    QShortcut* diagnostics = new QShortcut(QKeySequence("Ctrl+Shift+D"), this);
+    connect(diagnostics, &QShortcut::activated, this, [this] {
+        (new DiagnosticsDialog(db_, this))->show();
+    });
 }
 
 void MainWindow::loadCodebooks()
 {
+    PASSMGR_SPAN("ui.codebooks.load");
     codebookList->clear();
-    auto codebooks = vault.GetUserCodebooks(user);
+    // 条目数与大小由触发器维护，列表只需一次按索引的查询
+    auto codebooks = ConnectionPool::ForConnection(db_)->Read([this](PasswordVault& v) { return v.GetUserCodebooks(user); });
+    codebookList->setUpdatesEnabled(false);
     for (const auto &cb : codebooks) {
-        QListWidgetItem *item = new QListWidgetItem(
-            QString("%1\n创建时间: %2").arg(cb.name.c_str()).arg(cb.created_time.c_str())
-        );
-        item->setData(Qt::UserRole, cb.id);  // 保留原有数据存储
-        codebookList->addItem(item);
+        addCodebookItem(cb, codebookList->count());
     }
+    codebookList->setUpdatesEnabled(true);
+}
+
+void MainWindow::addCodebookItem(const PasswordVault::Codebook& cb, int row)
+{
+    QListWidgetItem *item = new QListWidgetItem(
+        QString("%1\n%2 条条目 · %3 · 修改于 %4 · 创建于 %5")
+            .arg(QString::fromStdString(cb.name))
+            .arg(cb.entry_count)
+            .arg(QLocale().formattedDataSize(cb.total_bytes))
+            .arg(QString::fromStdString(cb.modified_time))
+            .arg(QString::fromStdString(cb.created_time))
+    );
+    // 之后的操作都按 codebook_id 进行，不再由显示文本反查
+    item->setData(Qt::UserRole, cb.id);
+    codebookList->insertItem(row, item);
 }
 
 void MainWindow::deleteCodebook()
@@ -65,24 +151,17 @@ void MainWindow::deleteCodebook()
     QListWidgetItem* selectedItem = codebookList->currentItem();
     if (!selectedItem) return;
 
-    // 通过密码本名称获取codebook_id
-    std::string codebookName = getOriginalName(selectedItem->text()).toStdString();
-    int codebookId = vault.GetCodebookId(user, codebookName);
-
-    if (codebookId == -1) {
-        QMessageBox::warning(this, "错误", "未找到指定密码本");
-        return;
-    }
-
-    try {
-        if (vault.DeleteCodebook(codebookId)) {
-            // 删除成功后从列表移除
-            delete selectedItem;
+    const int codebookId = selectedItem->data(Qt::UserRole).toInt();
+    // 写入在后台排队，写线程可能正忙于导入或密钥轮换；失败由 jobFailed 提示
+    service_->deleteCodebook(keyring_, codebookId).then(this, [this, codebookId](bool) {
+        // 删除成功或已在其他窗口中删除，都从列表移除；等待期间列表可能已刷新，按 id 查找
+        for (int row = 0; row < codebookList->count(); ++row) {
+            if (codebookList->item(row)->data(Qt::UserRole).toInt() == codebookId) {
+                delete codebookList->takeItem(row);
+                break;
+            }
         }
-    } catch (const std::exception& e) {
-        QMessageBox::critical(this, "删除失败", 
-                            QString("数据库错误: %1").arg(e.what()));
-    }
+    });
 }
 
 void MainWindow::addCodebook()
@@ -93,13 +172,17 @@ void MainWindow::addCodebook()
                                         QLineEdit::Normal,
                                         "", &ok);
     if (ok && !name.isEmpty()) {
-        try {
-            if (vault.CreateCodebook(user, name.toStdString())) {
-                loadCodebooks();
-            }
-        } catch (const std::exception &e) {
-            QMessageBox::critical(this, "Error!", QString("创建失败: ") + e.what());
-        }
+        // 写入在后台排队，失败由 jobFailed 提示
+        service_->createCodebook(QString::fromStdString(user), name)
+            .then(this, [this](const PasswordVault::Codebook& created) {
+                if (created.id < 0) {
+                    QMessageBox::warning(this, "创建失败", "已有同名的密码本");
+                    return;
+                }
+                // 列表按创建时间倒序，新密码本放在最前，无需重新查询
+                addCodebookItem(created, 0);
+                codebookList->setCurrentRow(0);
+            });
     }
 }
 
@@ -109,15 +192,13 @@ void MainWindow::openCodebook()
     if (!selectedItem) return;
 
     try {
-        // 获取密码本ID（假设存储在item的data中）
-        std::string codebookName = getOriginalName(selectedItem->text()).toStdString();
-        int codebookId = vault.GetCodebookId(user, codebookName);
+        const int codebookId = selectedItem->data(Qt::UserRole).toInt();
 
         // 创建新窗口时指定父对象，并设置为独立窗口
         PasswordManagerWindow *pmWindow = new PasswordManagerWindow(
             db_, 
             user, 
-            masterPassword_,
+            keyring_,
             codebookId,
             nullptr  // 设置为独立顶级窗口
         );
@@ -129,3 +210,116 @@ void MainWindow::openCodebook()
         QMessageBox::critical(this, "错误", QString("打开失败: %1").arg(e.what()));
     }
 }
+
+
+void MainWindow::exportBackup()
+{
+    const QString path = QFileDialog::getSaveFileName(this, "导出备份", QString(), "密码备份 (*.pmbk)");
+    if (path.isEmpty()) return;
+
+    bool ok;
+    const QString passphrase = QInputDialog::getText(this, "导出备份", "设置备份口令:",
+                                                     QLineEdit::Password, "", &ok);
+    if (!ok || passphrase.isEmpty()) return;
+    const QString confirm = QInputDialog::getText(this, "导出备份", "再次输入备份口令:",
+                                                  QLineEdit::Password, "", &ok);
+    if (!ok) return;
+    if (confirm != passphrase) {
+        QMessageBox::warning(this, "错误", "两次输入的口令不一致");
+        return;
+    }
+
+    service_->exportBackup(keyring_, QString::fromStdString(user), path, passphrase);
+}
+
+void MainWindow::restoreBackup()
+{
+    const QString path = QFileDialog::getOpenFileName(this, "恢复备份", QString(), "密码备份 (*.pmbk);;所有文件 (*)");
+    if (path.isEmpty()) return;
+
+    bool ok;
+    const QString passphrase = QInputDialog::getText(this, "恢复备份", "备份口令:",
+                                                     QLineEdit::Password, "", &ok);
+    if (!ok || passphrase.isEmpty()) return;
+
+    // 先完整校验备份再写入，同名密码本的条目会合并
+    service_->restoreBackup(keyring_, QString::fromStdString(user), path, passphrase);
+}
+
+void MainWindow::auditReuse()
+{
+    // 首次检查需要解密所有条目，之后只重新解密有改动的条目
+    service_->auditReuse(keyring_, QString::fromStdString(user));
+}
+
+void MainWindow::showReuseReport(const ReuseAuditReport& report)
+{
+    if (report.canceled) return;
+
+    std::map<int, QString> codebookNames;
+    auto codebooks = ConnectionPool::ForConnection(db_)->Read([this](PasswordVault& v) { return v.GetUserCodebooks(user); });
+    for (const auto& cb : codebooks) {
+        codebookNames[cb.id] = QString::fromStdString(cb.name);
+    }
+    auto describe = [&codebookNames](const AuditedEntry& entry) {
+        return QString("%1 / %2").arg(codebookNames[entry.codebookId]).arg(QString::fromStdString(entry.address));
+    };
+
+    QString message = QString("已检查 %1 个密码").arg(report.audited);
+    if (report.undecryptable > 0) {
+        message += QString("，%1 个无法解密").arg(report.undecryptable);
+    }
+    if (report.reused.empty() && report.breached.empty()) {
+        message += report.breachChecked ? "，没有发现重复或已泄露的密码" : "，没有发现重复的密码";
+        QMessageBox::information(this, "重复密码检查", message);
+        return;
+    }
+
+    // 只列出前若干组，避免消息框过长
+    const size_t shownGroups = std::min<size_t>(report.reused.size(), 10);
+    if (!report.reused.empty()) {
+        message += QString("\n\n%1 组密码被重复使用：").arg(report.reused.size());
+    }
+    for (size_t i = 0; i < shownGroups; ++i) {
+        QStringList places;
+        for (const auto& entry : report.reused[i]) {
+            places << describe(entry);
+        }
+        message += "\n" + places.join("，");
+    }
+    const size_t shownBreached = std::min<size_t>(report.breached.size(), 10);
+    if (!report.breached.empty()) {
+        message += QString("\n\n%1 个密码出现在泄露库中：").arg(report.breached.size());
+    }
+    for (size_t i = 0; i < shownBreached; ++i) {
+        message += "\n" + describe(report.breached[i]);
+    }
+    if (!report.breachChecked) {
+        message += "\n\n工作目录下没有 passmgr.breach，未检查已泄露的密码";
+    }
+    QMessageBox::warning(this, "重复密码检查", message);
+}
+
+void MainWindow::changeMasterPassword()
+{
+    bool ok;
+    const QString oldPassword = QInputDialog::getText(this, "修改主密码", "当前主密码:",
+                                                      QLineEdit::Password, "", &ok);
+    if (!ok || oldPassword.isEmpty()) return;
+    const QString newPassword = QInputDialog::getText(this, "修改主密码", "新主密码:",
+                                                      QLineEdit::Password, "", &ok);
+    if (!ok || newPassword.isEmpty()) return;
+    if (!MeetsComplexityRule(newPassword.toStdString())) {
+        QMessageBox::warning(this, "错误", "新主密码需为 8-32 位，且必须包含大小写字母和数字");
+        return;
+    }
+    const QString confirm = QInputDialog::getText(this, "修改主密码", "再次输入新主密码:",
+                                                  QLineEdit::Password, "", &ok);
+    if (!ok) return;
+    if (confirm != newPassword) {
+        QMessageBox::warning(this, "错误", "两次输入的密码不一致");
+        return;
+    }
+
+    service_->changeMasterPassword(keyring_, QString::fromStdString(user), oldPassword, newPassword);
+}
@@ -1,28 +1,36 @@
 #pragma once
 #include <QWidget>
 #include <QListWidget>
-#include "PasswordVault.h"
+#include <memory>
+#include "PassWordVault.h"
+#include "SessionKeyring.h"
 #include "UserAuth.h"
+#include "AsyncVaultService.h"
 
 class MainWindow : public QWidget
 {
     Q_OBJECT
 public:
-    MainWindow(sqlite3* db, const std::string &username, const std::string &masterPassword, QWidget *parent = nullptr);
+    MainWindow(sqlite3* db, const std::string &username, std::shared_ptr<SessionKeyring> keyring, QWidget *parent = nullptr);
     sqlite3* GetDatabase() const { return db_; }
 
 private Q_SLOTS:
     void addCodebook();
     void deleteCodebook();
     void openCodebook();
+    void exportBackup();
+    void restoreBackup();
+    void auditReuse();
+    void changeMasterPassword();
 
 private:
     sqlite3* db_;
-    std::string masterPassword_;
-    PasswordVault vault;
+    std::shared_ptr<SessionKeyring> keyring_;
     std::string user;
     QListWidget *codebookList;
-    QString getOriginalName(const QString& displayText);
+    AsyncVaultService *service_;
     void setupUI();
     void loadCodebooks();
+    void addCodebookItem(const PasswordVault::Codebook& cb, int row);
+    void showReuseReport(const ReuseAuditReport& report);
 };
\ No newline at end of file
@@ -11,19 +11,26 @@
 #include <QPushButton>
 #include <QApplication>
 #include <QTimer>
-#include <regex>
+#include <QProgressBar>
+#include <QFileDialog>
+#include <algorithm>
+#include "PasswordStrength.h"
 
 PasswordManagerWindow::PasswordManagerWindow(sqlite3* db, 
                                            const std::string& username,
-                                           const std::string& masterPassword,
+                                           std::shared_ptr<SessionKeyring> keyring,
                                            int codebookId,
                                            QWidget* parent)
     : QWidget(parent, Qt::Window),
-      vault(db),
-      masterPassword(masterPassword),
+      keyring_(keyring),
+      username_(username),
       currentCodebookId(codebookId) {
+    service_ = new AsyncVaultService(db, nullptr, this);
+    entriesModel = new EntryTableModel(db, currentCodebookId, this);
     setupUI();
     loadEntries();
+    // 迁移前先在后台解包数据密钥，密码本首次打开时生成；失败由 jobFailed 提示
+    migrateLegacyEntries();
 
     setMinimumSize(800, 600);
 }
@@ -33,14 +40,25 @@ void PasswordManagerWindow::setupUI() {
     QVBoxLayout* mainLayout = new QVBoxLayout(this);
     mainLayout->setContentsMargins(60, 40, 60, 40);
     
+    // 搜索框：停止输入 200ms 后再查询，避免每个按键都访问数据库
+    searchInput = new QLineEdit;
+    searchInput->setPlaceholderText("搜索地址或备注");
+    searchInput->setClearButtonEnabled(true);
+    searchTimer = new QTimer(this);
+    searchTimer->setSingleShot(true);
+    searchTimer->setInterval(200);
+
     // 条目表格
-    entriesTable = new QTableWidget(this);
-    entriesTable->setColumnCount(4);
-    entriesTable->setHorizontalHeaderLabels({"地址", "创建时间", "密码", "备注"});
-    entriesTable->horizontalHeader()->setSectionResizeMode(0, QHeaderView::ResizeToContents);
-    entriesTable->horizontalHeader()->setSectionResizeMode(1, QHeaderView::ResizeToContents);
-    entriesTable->horizontalHeader()->setSectionResizeMode(2, QHeaderView::ResizeToContents);
-    entriesTable->horizontalHeader()->setSectionResizeMode(3, QHeaderView::Stretch);
+    entriesTable = new QTableView(this);
+    entriesTable->setModel(entriesModel);
+    entriesTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+    entriesTable->setSelectionMode(QAbstractItemView::SingleSelection);
+    entriesTable->setContextMenuPolicy(Qt::CustomContextMenu);
+    // ResizeToContents 会遍历所有已加载的行，大密码本下改为固定宽度
+    entriesTable->horizontalHeader()->setSectionResizeMode(EntryTableModel::AddressColumn, QHeaderView::Interactive);
+    entriesTable->horizontalHeader()->setSectionResizeMode(EntryTableModel::CreatedColumn, QHeaderView::Interactive);
+    entriesTable->horizontalHeader()->setSectionResizeMode(EntryTableModel::PasswordColumn, QHeaderView::Interactive);
+    entriesTable->horizontalHeader()->setSectionResizeMode(EntryTableModel::NotesColumn, QHeaderView::Stretch);
     entriesTable->horizontalHeader()->setMinimumSectionSize(150);
     
     // 操作工具栏
@@ -48,6 +66,8 @@ void PasswordManagerWindow::setupUI() {
     QAction* addAction = toolbar->addAction("新增条目");
     QAction* deleteAction = toolbar->addAction("删除条目");
     QAction* copyAction = toolbar->addAction("复制密码");
+    QAction* importAction = toolbar->addAction("导入CSV");
+    QAction* auditAction = toolbar->addAction("弱密码检查");
     
     // 输入表单
     QFormLayout* form = new QFormLayout;
@@ -56,6 +76,7 @@ void PasswordManagerWindow::setupUI() {
     passwordInput = new QLineEdit;
     passwordInput->setPlaceholderText("密码8-32位，必须包含大小写字母和数字");
     QPushButton* generateBtn = new QPushButton("生成");
+    strengthLabel = new QLabel;
     notesInput = new QPlainTextEdit;
     
     // 密码生成菜单
@@ -73,70 +94,136 @@ void PasswordManagerWindow::setupUI() {
     
     form->addRow("服务地址:", addressInput);
     form->addRow("密码:", passLayout);
+    form->addRow("强度:", strengthLabel);
     form->addRow("备注:", notesInput);
     
+    // 后台任务进度
+    progressBar = new QProgressBar;
+    progressBar->setTextVisible(false);
+    QPushButton* cancelBtn = new QPushButton("取消");
+    QHBoxLayout* progressLayout = new QHBoxLayout;
+    progressLayout->addWidget(progressBar);
+    progressLayout->addWidget(cancelBtn);
+    progressRow = new QWidget;
+    progressRow->setLayout(progressLayout);
+    progressRow->hide();
+
     mainLayout->addWidget(toolbar);
+    mainLayout->addWidget(searchInput);
     mainLayout->addWidget(entriesTable);
+    mainLayout->addWidget(progressRow);
     mainLayout->addLayout(form);
     
     // 信号连接
     connect(addAction, &QAction::triggered, this, &PasswordManagerWindow::addEntry);
     connect(deleteAction, &QAction::triggered, this, &PasswordManagerWindow::deleteEntry);
     connect(copyAction, &QAction::triggered, this, &PasswordManagerWindow::copyPassword);
-    connect(entriesTable, &QTableWidget::cellDoubleClicked, this, &PasswordManagerWindow::showPassword);
-    connect(entriesTable, &QTableWidget::customContextMenuRequested, [this](const QPoint& pos){
+    connect(importAction, &QAction::triggered, this, &PasswordManagerWindow::importCsv);
+    connect(auditAction, &QAction::triggered, this, &PasswordManagerWindow::auditStrength);
+    connect(passwordInput, &QLineEdit::textChanged, this, &PasswordManagerWindow::updateStrength);
+    connect(addressInput, &QLineEdit::textChanged, this, &PasswordManagerWindow::updateStrength);
+    connect(searchInput, &QLineEdit::textChanged, searchTimer, qOverload<>(&QTimer::start));
+    connect(searchTimer, &QTimer::timeout, this, &PasswordManagerWindow::loadEntries);
+    connect(entriesTable, &QTableView::doubleClicked, this, &PasswordManagerWindow::showPassword);
+    connect(entriesTable, &QTableView::customContextMenuRequested, [this](const QPoint& pos){
         QMenu menu;
         menu.addAction("复制密码", this, &PasswordManagerWindow::copyPassword);
         menu.exec(entriesTable->viewport()->mapToGlobal(pos));
     });
+
+    // 后台任务结果
+    connect(cancelBtn, &QPushButton::clicked, service_, &AsyncVaultService::cancelAll);
+    connect(service_, &AsyncVaultService::busyChanged, this, [this](bool busy) {
+        progressBar->setRange(0, 0);
+        progressRow->setVisible(busy);
+    });
+    connect(service_, &AsyncVaultService::progressChanged, this, [this](int value, int maximum) {
+        progressBar->setRange(0, maximum);
+        progressBar->setValue(value);
+    });
+    connect(service_, &AsyncVaultService::jobFailed, this, [this](const QString& message) {
+        QMessageBox::critical(this, "错误", message);
+    });
+    connect(service_, &AsyncVaultService::entryAdded, this, [this](int codebookId) {
+        if (codebookId != currentCodebookId) return;
+        // 新行由模型通过变更总线追加，这里只清空表单
+        QMessageBox::information(this, "成功", "条目添加成功");
+
+        addressInput->clear();
+        passwordInput->clear();
+        notesInput->clear();
+    });
+    connect(service_, &AsyncVaultService::importFinished, this, [this](int codebookId, const CsvImportReport& report) {
+        if (codebookId != currentCodebookId) return;
+
+        QString message = QString("已从 %1 格式导入 %2 条，失败 %3 条")
+            .arg(CsvImporter::LayoutName(report.layout))
+            .arg(report.imported)
+            .arg(report.errors.size());
+        // 只列出前若干条错误，避免消息框过长
+        const size_t shown = std::min<size_t>(report.errors.size(), 10);
+        for (size_t i = 0; i < shown; ++i) {
+            message += QString("\n第 %1 行：%2").arg(report.errors[i].line)
+                .arg(QString::fromStdString(report.errors[i].message));
+        }
+        QMessageBox::information(this, "导入完成", message);
+    });
+    connect(service_, &AsyncVaultService::auditFinished, this, [this](int codebookId, const StrengthAuditReport& report) {
+        if (codebookId != currentCodebookId) return;
+
+        if (report.weak.empty()) {
+            QMessageBox::information(this, "弱密码检查",
+                                     QString("已检查 %1 个密码，没有发现弱密码").arg(report.audited));
+            return;
+        }
+        QString message = QString("已检查 %1 个密码，其中 %2 个强度不足：")
+            .arg(report.audited)
+            .arg(report.weak.size());
+        // 只列出最弱的若干条，避免消息框过长
+        const size_t shown = std::min<size_t>(report.weak.size(), 20);
+        for (size_t i = 0; i < shown; ++i) {
+            const WeakPassword& weak = report.weak[i];
+            message += QString("\n%1（%2）：%3")
+                .arg(QString::fromStdString(weak.address))
+                .arg(StrengthEstimator::ScoreName(weak.score))
+                .arg(QString::fromStdString(weak.warning));
+        }
+        QMessageBox::warning(this, "弱密码检查", message);
+    });
 }
 
 void PasswordManagerWindow::loadEntries() {
-    entriesTable->setRowCount(0);
-    
-    try {
-        entries = vault.GetEntries(currentCodebookId);
-        
-        for (const auto& entry : entries) {
-            std::vector<uint8_t> plaintext = crypto_.decrypt(
-                masterPassword,
-                entry.encrypted_password
-            );
-            
-            int row = entriesTable->rowCount();
-            entriesTable->insertRow(row);
-
-            auto* addrItem = new QTableWidgetItem(QString::fromStdString(entry.address));
-            entriesTable->setItem(row, 0, addrItem);
-            entriesTable->setItem(row, 1, new QTableWidgetItem(
-                QString::fromStdString(entry.created_time)));
-            auto* pwdItem = new QTableWidgetItem("******");
-            pwdItem->setFlags(pwdItem->flags() ^ Qt::ItemIsEditable);
-            entriesTable->setItem(row, 2, pwdItem);
-            entriesTable->setItem(row, 3, new QTableWidgetItem(
-                QString::fromStdString(entry.notes)));
-            entriesTable->item(row, 2)->setData(Qt::UserRole, 
-                QByteArray(reinterpret_cast<const char*>(plaintext.data()), 
-                plaintext.size()));
-            entriesTable->item(row, 0)->setData(Qt::UserRole, entry.id);
-        }
-        
-        entriesTable->horizontalHeader()->setSectionResizeMode(0, QHeaderView::ResizeToContents);
-        entriesTable->horizontalHeader()->setSectionResizeMode(1, QHeaderView::ResizeToContents);
-        entriesTable->horizontalHeader()->setSectionResizeMode(2, QHeaderView::ResizeToContents);
-        entriesTable->horizontalHeader()->setSectionResizeMode(3, QHeaderView::Stretch);
-        
-    } catch (const std::exception& e) {
-        QMessageBox::critical(this, "加载错误", 
-            QString("无法加载密码本条目:\n%1").arg(e.what()));
-    }
+    // 只加载第一页元数据，其余分页在滚动到底部时由视图按需获取；
+    // 密码在用户查看或复制时才按行解密
+    searchTimer->stop();
+    entriesModel->reload(searchInput->text());
+}
+
+void PasswordManagerWindow::migrateLegacyEntries() {
+    // 旧格式与版本 2 的条目由后台任务重新加密为当前版本并写回；无头部的旧格式每条都要跑一次 Argon2
+    withCodebookKey([this](const std::shared_ptr<SecureKey>& key) {
+        service_->migrateLegacyEntries(keyring_, key, QString::fromStdString(username_), currentCodebookId);
+    });
+}
+
+void PasswordManagerWindow::withCodebookKey(std::function<void(const std::shared_ptr<SecureKey>&)> use) {
+    // 解包或首次生成密钥都在后台完成，界面线程不等待写线程上的长任务
+    service_->codebookKey(keyring_, currentCodebookId)
+        .then(this, [this, use](const std::shared_ptr<SecureKey>& key) {
+            try {
+                use(key);
+            } catch (const std::exception& e) {
+                QMessageBox::critical(this, "错误", QString::fromUtf8(e.what()));
+            }
+        });
 }
 
 void PasswordManagerWindow::generatePassword(int length) {
     try {
-        // 每次生成都创建新实例
-        PasswordGenerator gen(length);
-        QString password = QString::fromStdString(gen.generateExtended());
+        // 复用窗口持有的生成器；字符集在编译期展开，保证满足条目密码规则
+        static constexpr Charset charset(kStrongPolicy);
+        generator.setLength(length);
+        QString password = QString::fromStdString(generator.generate(charset));
 
         // 设置密码输入框的文本
         passwordInput->setText(password);
@@ -158,33 +245,35 @@ void PasswordManagerWindow::generatePassword(int length) {
 void PasswordManagerWindow::showEvent(QShowEvent* event) {
     QWidget::showEvent(event);
     
-    // 首次显示时自动调整列宽
-    entriesTable->horizontalHeader()->setSectionResizeMode(0, QHeaderView::ResizeToContents);
-    entriesTable->horizontalHeader()->setSectionResizeMode(1, QHeaderView::Stretch);
-    
-    // 密码字段保护
-    for(int row = 0; row < entriesTable->rowCount(); ++row) {
-        QTableWidgetItem* item = entriesTable->item(row, 1);
-        item->setFlags(item->flags() ^ Qt::ItemIsEditable);
-        item->setToolTip("双击显示密码（3秒后自动隐藏）");
-    }
+    // 首次显示时自动调整列宽（只按表头和可见行计算）
+    entriesTable->resizeColumnToContents(EntryTableModel::AddressColumn);
+    entriesTable->resizeColumnToContents(EntryTableModel::CreatedColumn);
+}
 
+int PasswordManagerWindow::selectedEntryId() const {
+    QModelIndexList selected = entriesTable->selectionModel()->selectedRows();
+    if (selected.isEmpty()) return -1;
+    return selected.first().data(EntryTableModel::EntryIdRole).toInt();
 }
 
-void PasswordManagerWindow::showPassword(int row, int column) {
-    if (column == 2) {
-        QTableWidgetItem* item = entriesTable->item(row, column);
-        const std::vector<uint8_t> encrypted = entries[row].encrypted_password;
-        std::vector<uint8_t> plaintext = crypto_.decrypt(masterPassword, encrypted);
+void PasswordManagerWindow::showPassword(const QModelIndex& index) {
+    if (!index.isValid() || index.column() != EntryTableModel::PasswordColumn) return;
 
-        QString password = QString::fromUtf8(reinterpret_cast<const char*>(plaintext.data()), plaintext.size());
-        item->setText(password);
+    const int entryId = index.data(EntryTableModel::EntryIdRole).toInt();
+    withCodebookKey([this, entryId](const std::shared_ptr<SecureKey>& key) {
+        service_->decryptEntry(keyring_, key, entryId)
+            .then(this, [this, entryId](const std::shared_ptr<SecureBuffer>& plaintext) {
+                // 解密期间模型可能已变化，由模型按条目 ID 重新定位
+                QString password = QString::fromUtf8(reinterpret_cast<const char*>(plaintext->data()),
+                                                     static_cast<qsizetype>(plaintext->size()));
+                entriesModel->revealPassword(entryId, password);
 
-        // 3秒后隐藏密码
-        QTimer::singleShot(3000, [item] {
-            item->setText("******");
-        });
-    }
+                // 3秒后隐藏密码
+                QTimer::singleShot(3000, entriesModel, [this, entryId] {
+                    entriesModel->concealPassword(entryId);
+                });
+            });
+    });
 }
 
 void PasswordManagerWindow::addEntry() {
@@ -193,70 +282,74 @@ void PasswordManagerWindow::addEntry() {
             throw std::runtime_error("服务地址不能为空");
         }
         
-        // 加密密码
         const std::string plainPassword = passwordInput->text().toStdString();
-        const std::vector<uint8_t> ciphertext = crypto_.encrypt(
-            masterPassword,
-            std::vector<uint8_t>(plainPassword.begin(), plainPassword.end())
-        );
-        
-        // 创建新条目
-        PasswordVault::PasswordEntry entry{
-            .address = addressInput->text().toStdString(),
-            .public_key = "N/A", // 根据实际情况实现
-            .encrypted_password = ciphertext,
-            .notes = notesInput->toPlainText().toStdString()
-        };
-        
-        if(!std::regex_match(plainPassword, std::regex(R"((?=.*\d)(?=.*[a-z])(?=.*[A-Z]).{8,32})"))){
+        if (!MeetsComplexityRule(plainPassword)) {
             throw std::runtime_error("密码不符合复杂度要求");
         }
 
-        if (vault.AddEntry(currentCodebookId, entry.address, entry.encrypted_password, entry.notes)) {
-            refreshEntries();
-            QMessageBox::information(this, "成功", "条目添加成功");
-
-            addressInput->clear();
-            passwordInput->clear();
-            notesInput->clear();
-        }
+        // 取得密钥、加密与写入都在后台完成，成功后由 entryAdded 刷新界面；
+        // 表单内容在提交时读取，取得密钥期间的修改不影响本次添加
+        const QString address = addressInput->text();
+        const QString password = passwordInput->text();
+        const QString notes = notesInput->toPlainText();
+        withCodebookKey([this, address, password, notes](const std::shared_ptr<SecureKey>& key) {
+            service_->addEntry(currentCodebookId, key, address, password, notes);
+        });
     } catch (const std::exception& e) {
         QMessageBox::critical(this, "错误", QString::fromStdString(e.what()));
     }
 }
 
-void PasswordManagerWindow::deleteEntry() {
-    QModelIndexList selected = entriesTable->selectionModel()->selectedRows();
-    if (selected.isEmpty()) return;
+void PasswordManagerWindow::updateStrength() {
+    const std::string password = passwordInput->text().toStdString();
+    if (password.empty()) {
+        strengthLabel->clear();
+        return;
+    }
 
-    try {
-        int entryId = entriesTable->item(selected.first().row(), 0)->data(Qt::UserRole).toInt();
-        if (vault.DeleteEntry(entryId)) {
-            refreshEntries();
-        }
-    } catch (const std::exception& e) {
-        QMessageBox::critical(this, "错误", QString("删除失败: %1").arg(e.what()));
+    // 估计只需几微秒，可以在每次输入时同步计算；服务地址作为用户相关词参与估计
+    const StrengthResult result = strength_.Estimate(password, {addressInput->text().toStdString()});
+    QString text = QString("%1（约 %2 bit）")
+        .arg(StrengthEstimator::ScoreName(result.score))
+        .arg(static_cast<int>(result.entropyBits));
+    if (!result.warning.empty()) {
+        text += "  " + QString::fromStdString(result.warning);
     }
+    strengthLabel->setText(text);
+}
+
+void PasswordManagerWindow::auditStrength() {
+    service_->auditStrength(keyring_, currentCodebookId);
+}
+
+void PasswordManagerWindow::deleteEntry() {
+    const int entryId = selectedEntryId();
+    if (entryId < 0) return;
+
+    service_->deleteEntry(entryId);
 }
 
 void PasswordManagerWindow::copyPassword() {
-    QModelIndexList selected = entriesTable->selectionModel()->selectedRows();
-    if (selected.isEmpty()) return;
+    const int entryId = selectedEntryId();
+    if (entryId < 0) return;
 
-    try {
-        const int row = selected.first().row();
-        const std::vector<uint8_t> encrypted = entries[row].encrypted_password;
-        const std::vector<uint8_t> plaintext = crypto_.decrypt(masterPassword, encrypted);
-        
-        QApplication::clipboard()->setText(
-            QString::fromUtf8(reinterpret_cast<const char*>(plaintext.data()), plaintext.size())
-        );
-    } catch (const std::exception& e) {
-        QMessageBox::critical(this, "错误", QString("复制失败: %1").arg(e.what()));
-    }
+    withCodebookKey([this, entryId](const std::shared_ptr<SecureKey>& key) {
+        service_->decryptEntry(keyring_, key, entryId)
+            .then(this, [](const std::shared_ptr<SecureBuffer>& plaintext) {
+                QApplication::clipboard()->setText(
+                    QString::fromUtf8(reinterpret_cast<const char*>(plaintext->data()),
+                                      static_cast<qsizetype>(plaintext->size()))
+                );
+            });
+    });
 }
 
-void PasswordManagerWindow::refreshEntries() {
-    entriesTable->setRowCount(0);
-    loadEntries();
+void PasswordManagerWindow::importCsv() {
+    const QString path = QFileDialog::getOpenFileName(this, "导入CSV", QString(), "CSV 文件 (*.csv);;所有文件 (*)");
+    if (path.isEmpty()) return;
+
+    // 支持 Chrome / Firefox / KeePass / KeePassXC / Bitwarden 导出格式
+    withCodebookKey([this, path](const std::shared_ptr<SecureKey>& key) {
+        service_->importCsv(currentCodebookId, key, path);
+    });
 }
\ No newline at end of file
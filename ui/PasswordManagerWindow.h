@@ -1,17 +1,25 @@
 #pragma once
 #include <QWidget>
-#include <QTableWidget>
+#include <QTableView>
 #include <QPlainTextEdit>
+#include <QProgressBar>
+#include <QTimer>
+#include <QLabel>
+#include <memory>
 #include "PassWordVault.h"
 #include "PassWordGen.h"
 #include "CryptoModule.h"
+#include "SessionKeyring.h"
+#include "AsyncVaultService.h"
+#include "EntryTableModel.h"
+#include "PasswordStrength.h"
 
 class PasswordManagerWindow : public QWidget {
     Q_OBJECT
 public:
     explicit PasswordManagerWindow(sqlite3* db, 
                                   const std::string& username,
-                                  const std::string& masterPassword,
+                                  std::shared_ptr<SessionKeyring> keyring,
                                   int codebookId,
                                   QWidget* parent = nullptr);
     
@@ -20,23 +28,36 @@ private Q_SLOTS:
     void deleteEntry();
     void loadEntries();
     void copyPassword();
+    void importCsv();
+    void auditStrength();
+    void updateStrength();
     void generatePassword(int length);
-    void refreshEntries();
-    void showPassword(int row, int column);
+    void showPassword(const QModelIndex& index);
 
 private:
     void setupUI();
     void showEvent(QShowEvent* event) override;
+    void migrateLegacyEntries();
+    int selectedEntryId() const;
+    // 每次使用时从密钥环获取：修改主密码后数据密钥会被替换。
+    // 取得密钥后在界面线程上调用 use；获取失败由 jobFailed 提示，use 抛出的异常在此提示
+    void withCodebookKey(std::function<void(const std::shared_ptr<SecureKey>&)> use);
 
-    PasswordVault vault;
-    CryptoModule crypto_;
     PasswordGenerator generator;
-    QTableWidget* entriesTable;
+    StrengthEstimator strength_;
+    QTableView* entriesTable;
+    EntryTableModel* entriesModel;
+    QLineEdit* searchInput;
+    QTimer* searchTimer;
     QLineEdit* addressInput;
     QLineEdit* passwordInput;
+    QLabel* strengthLabel;
     QPlainTextEdit* notesInput;
+    QWidget* progressRow;
+    QProgressBar* progressBar;
+    AsyncVaultService* service_;
     
-    const std::string masterPassword;
+    std::shared_ptr<SessionKeyring> keyring_;
+    const std::string username_;
     const int currentCodebookId;
-    std::vector<PasswordVault::PasswordEntry> entries;
 };
\ No newline at end of file